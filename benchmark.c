@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+// A grid is "NxKxM" like the tuning shapes, where every dimension may be a comma-separated list; all combinations are appended
+unsigned char shapeGridParsing(const char* grid, struct benchmarkShape** shapes, size_t* shapeNum)
+{
+	unsigned int dims[3][BENCHMARK_GRID_DIM_MAX];
+	size_t dimNum[3] = { 0, 0, 0 };
+	const char* gridPos = grid;
+
+	for (int i = 0; i < 3; i++)
+	{
+		while (1)
+		{
+			char* dimEnd;
+			const unsigned long dim = strtoul(gridPos, &dimEnd, 10);
+			if (dimEnd == gridPos || !dim || dim > 0xFFFFFFFFUL || dimNum[i] == BENCHMARK_GRID_DIM_MAX)
+				return 1;
+
+			dims[i][dimNum[i]++] = (unsigned int)dim;
+			gridPos = dimEnd;
+
+			if (*gridPos != ',')
+				break;
+
+			gridPos++;
+		}
+
+		if (*gridPos != (i < 2 ? 'x' : '\0'))
+			return 1;
+
+		gridPos++;
+	}
+
+	struct benchmarkShape* grownShapes = (struct benchmarkShape*)realloc(*shapes, sizeof(struct benchmarkShape) * (*shapeNum + dimNum[0] * dimNum[1] * dimNum[2]));
+	if (grownShapes == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	*shapes = grownShapes;
+
+	for (size_t n = 0; n < dimNum[0]; n++)
+	{
+		for (size_t k = 0; k < dimNum[1]; k++)
+		{
+			for (size_t m = 0; m < dimNum[2]; m++)
+			{
+				struct benchmarkShape* shape = &(*shapes)[(*shapeNum)++];
+				shape->colSecondMatrix = dims[0][n];
+				shape->colFirstRowSecond = dims[1][k];
+				shape->rowFirstMatrix = dims[2][m];
+			}
+		}
+	}
+
+	return 0;
+}
+
+// Compute units x clock x 2 operations of a multiply-add x lanes per compute unit, which on CPUs are the preferred vector width
+// of the type the products are summed in; the result is only as good as that guess, so BENCHMARK_PEAK_ENV may replace it
+double devicePeakEstimation(cl_device_id device, int elementType)
+{
+	const char* peakStr = getenv(BENCHMARK_PEAK_ENV);
+	if (peakStr != NULL && atof(peakStr) > 0.0)
+		return atof(peakStr);
+
+	cl_uint computeUnitNum, clockFrequency, laneNum = BENCHMARK_GPU_LANES;
+	cl_device_type deviceType;
+
+	cl_int errCodeReturn = clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnitNum, NULL);
+	errCodeReturn |= clGetDeviceInfo(device, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(cl_uint), &clockFrequency, NULL);
+	errCodeReturn |= clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(cl_device_type), &deviceType, NULL);
+
+	if (errCodeReturn == CL_SUCCESS && (deviceType & CL_DEVICE_TYPE_CPU))
+	{
+		const cl_device_info widthInfo = elementType == ELEMENT_TYPE_DOUBLE ? CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE
+			: elementType == ELEMENT_TYPE_INT8 ? CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT : CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT;
+
+		errCodeReturn = clGetDeviceInfo(device, widthInfo, sizeof(cl_uint), &laneNum, NULL);
+	}
+
+	if (errCodeReturn != CL_SUCCESS)
+		return 0.0;
+
+	return (double)computeUnitNum * clockFrequency * 2.0 * (laneNum ? laneNum : 1) / 1000.0;
+}
+
+// Nearest-rank percentile of ascending times; the median of an even count is the mean of the two middle times
+double timePercentile(const double* sortedTimes, size_t timeNum, double fraction)
+{
+	if (fraction == 0.5 && !(timeNum % 2))
+		return (sortedTimes[timeNum / 2 - 1] + sortedTimes[timeNum / 2]) / 2.0;
+
+	size_t rank = (size_t)(fraction * timeNum + 0.999999);
+	if (rank < 1)
+		rank = 1;
+
+	return sortedTimes[(rank < timeNum ? rank : timeNum) - 1];
+}
+
+int timeComparison(const void* first, const void* second)
+{
+	const double firstTime = *(const double*)first;
+	const double secondTime = *(const double*)second;
+
+	return (firstTime > secondTime) - (firstTime < secondTime);
+}
+
+// Uniform in [-1, 1), or integers from -128 to 127 for int8, stored as the device takes the element type
+void randomMatrixFilling(void* matrix, size_t count, int elementType)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float value = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+
+		if (elementType == ELEMENT_TYPE_HALF)
+			halfConversion(&value, (cl_half*)matrix + i, 1);
+		else if (elementType == ELEMENT_TYPE_DOUBLE)
+			((double*)matrix)[i] = value;
+		else if (elementType == ELEMENT_TYPE_INT8)
+			((signed char*)matrix)[i] = (signed char)(rand() % 256 - 128);
+		else
+			((float*)matrix)[i] = value;
+	}
+}
+
+// Kernel times of repeatNum runs after the warm-up, in the order they were measured. The kernel of the operating mode is kept
+// for every shape, so small results are not timed as the matrix-vector kernel under each mode
+unsigned char benchmarkMeasuring(struct matmulContext* ctx, int implementationType, int elementType, const struct benchmarkShape* shape,
+	const void* firstMatrix, const void* secondMatrix, void* resultMatrix, unsigned int repeatNum, double* times)
+{
+	struct matmulOptions options = { implementationType, elementType, 0, 0, NULL, NULL, 0, 1 };
+
+	for (unsigned int repeat = 0; repeat < BENCHMARK_WARMUP_NUM + repeatNum; repeat++)
+	{
+		struct matmulTiming timing;
+		if (matmulTypedBatched(ctx, firstMatrix, secondMatrix, resultMatrix, shape->rowFirstMatrix, shape->colSecondMatrix, shape->colFirstRowSecond, 1,
+			&options, &timing))
+			return 1;
+
+		if (repeat >= BENCHMARK_WARMUP_NUM)
+			times[repeat - BENCHMARK_WARMUP_NUM] = timing.kernelTime;
+	}
+
+	return 0;
+}
+
+// Device names are quoted, with quotes doubled for CSV and escaped for JSON
+void quotedStringPrinting(FILE* file, const char* str, int format)
+{
+	fputc('"', file);
+
+	for (; *str; str++)
+	{
+		if (*str == '"')
+			fputs(format == BENCHMARK_FORMAT_JSON ? "\\\"" : "\"\"", file);
+		else if (*str == '\\' && format == BENCHMARK_FORMAT_JSON)
+			fputs("\\\\", file);
+		else if ((unsigned char)*str >= ' ')
+			fputc(*str, file);
+	}
+
+	fputc('"', file);
+}
+
+// The CSV header or the opening bracket of the JSON array goes in front of the first result
+void benchmarkResultPrinting(FILE* file, int format, const struct benchmarkResult* result, unsigned char first)
+{
+	static const char* elementTypeNames[ELEMENT_TYPE_NUM] = { "float", "half", "double", "int8" };
+
+	if (format == BENCHMARK_FORMAT_JSON)
+	{
+		fputs(first ? "[\n\t{ \"device\": " : ",\n\t{ \"device\": ", file);
+		quotedStringPrinting(file, result->deviceName, format);
+		fprintf(file, ", \"mode\": %d, \"type\": \"%s\", \"M\": %u, \"N\": %u, \"K\": %u, \"repetitions\": %u, "
+			"\"min_ms\": %g, \"median_ms\": %g, \"p95_ms\": %g, \"gflops\": %g, \"gbps\": %g, \"peak_percent\": %g }",
+			result->implementationType, elementTypeNames[result->elementType], result->shape.rowFirstMatrix, result->shape.colSecondMatrix,
+			result->shape.colFirstRowSecond, result->repeatNum, result->minTime, result->medianTime, result->percentileTime,
+			result->gflops, result->bandwidth, result->peakPercent);
+		return;
+	}
+
+	if (first)
+		fputs("device,mode,type,M,N,K,repetitions,min_ms,median_ms,p95_ms,gflops,gbps,peak_percent\n", file);
+
+	quotedStringPrinting(file, result->deviceName, format);
+	fprintf(file, ",%d,%s,%u,%u,%u,%u,%g,%g,%g,%g,%g,%g\n", result->implementationType, elementTypeNames[result->elementType],
+		result->shape.rowFirstMatrix, result->shape.colSecondMatrix, result->shape.colFirstRowSecond, result->repeatNum,
+		result->minTime, result->medianTime, result->percentileTime, result->gflops, result->bandwidth, result->peakPercent);
+}
+
+// Every OpenCL device in the order of the device IDs runs every shape with every operating mode on random matrices.
+// The rates are of the median kernel time; the effective bandwidth counts each matrix moved once. A device, mode or shape
+// that fails is left out and reported on stderr, and the sweep goes on
+unsigned char benchmarkProcessing(const struct benchmarkShape* shapes, size_t shapeNum, int elementType, unsigned int repeatNum, int format)
+{
+	cl_uint platformNum = 0;
+	cl_uint deviceNum = getDeviceNumber(&platformNum);
+
+	struct deviceInfo* devices = (struct deviceInfo*)malloc(sizeof(struct deviceInfo) * (deviceNum ? deviceNum : 1));
+	double* times = (double*)malloc(sizeof(double) * repeatNum);
+	if (devices == NULL || times == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(devices);
+		free(times);
+		return 1;
+	}
+
+	if (!deviceNum || getDeviceInfo(devices, deviceNum, platformNum))
+	{
+		fprintf(stderr, "Number of devices: 0\n");
+		free(devices);
+		free(times);
+		return 1;
+	}
+
+	deviceSorting(devices, deviceNum);
+
+	unsigned char failed = 0;
+	unsigned char first = 1;
+
+	for (cl_uint i = 0; i < deviceNum; i++)
+	{
+		cl_device_id device = NULL;
+		deviceSelection(devices, deviceNum, &device, i);
+
+		struct matmulContext* ctx;
+		if (matmulDeviceCreate(&ctx, device))
+		{
+			failed = 1;
+			continue;
+		}
+
+		const double peak = devicePeakEstimation(device, elementType);
+
+		for (size_t j = 0; j < shapeNum; j++)
+		{
+			const struct benchmarkShape* shape = &shapes[j];
+			const size_t firstMatrixSize = (size_t)shape->rowFirstMatrix * shape->colFirstRowSecond;
+			const size_t secondMatrixSize = (size_t)shape->colFirstRowSecond * shape->colSecondMatrix;
+			const size_t resultMatrixSize = (size_t)shape->rowFirstMatrix * shape->colSecondMatrix;
+
+			// Host allocations are counted in floats
+			void* firstMatrix = matmulHostAllocation((firstMatrixSize * elementSize(elementType) + sizeof(float) - 1) / sizeof(float));
+			void* secondMatrix = matmulHostAllocation((secondMatrixSize * elementSize(elementType) + sizeof(float) - 1) / sizeof(float));
+			void* resultMatrix = matmulHostAllocation((resultMatrixSize * resultElementSize(elementType) + sizeof(float) - 1) / sizeof(float));
+
+			if (firstMatrix == NULL || secondMatrix == NULL || resultMatrix == NULL)
+			{
+				fprintf(stderr, "Insufficient memory available!\n");
+				matmulHostRelease((float*)firstMatrix);
+				matmulHostRelease((float*)secondMatrix);
+				matmulHostRelease((float*)resultMatrix);
+				failed = 1;
+				continue;
+			}
+
+			randomMatrixFilling(firstMatrix, firstMatrixSize, elementType);
+			randomMatrixFilling(secondMatrix, secondMatrixSize, elementType);
+
+			const double operationNum = 2.0 * shape->rowFirstMatrix * shape->colSecondMatrix * shape->colFirstRowSecond;
+			const double byteNum = (double)(firstMatrixSize + secondMatrixSize) * elementSize(elementType) + (double)resultMatrixSize * resultElementSize(elementType);
+
+			for (int implementationType = 1; implementationType <= IMPLEMENTATION_TYPE_NUM; implementationType++)
+			{
+				if (benchmarkMeasuring(ctx, implementationType, elementType, shape, firstMatrix, secondMatrix, resultMatrix, repeatNum, times))
+				{
+					fprintf(stderr, "Benchmark failed on %s: mode %d, %ux%ux%u!\n", matmulDeviceName(ctx), implementationType,
+						shape->colSecondMatrix, shape->colFirstRowSecond, shape->rowFirstMatrix);
+					failed = 1;
+					continue;
+				}
+
+				qsort(times, repeatNum, sizeof(double), timeComparison);
+
+				struct benchmarkResult result;
+				result.deviceName = matmulDeviceName(ctx);
+				result.implementationType = implementationType;
+				result.elementType = elementType;
+				result.shape = *shape;
+				result.repeatNum = repeatNum;
+				result.minTime = times[0];
+				result.medianTime = timePercentile(times, repeatNum, 0.5);
+				result.percentileTime = timePercentile(times, repeatNum, 0.95);
+
+				// A kernel too short for the profiling clock is counted as 1 ns
+				const double medianTime = result.medianTime > 1e-6 ? result.medianTime : 1e-6;
+				result.gflops = operationNum / medianTime / 1e6;
+				result.bandwidth = byteNum / medianTime / 1e6;
+				result.peakPercent = peak > 0.0 ? result.gflops / peak * 100.0 : 0.0;
+
+				benchmarkResultPrinting(stdout, format, &result, first);
+				fflush(stdout);
+				first = 0;
+			}
+
+			matmulHostRelease((float*)firstMatrix);
+			matmulHostRelease((float*)secondMatrix);
+			matmulHostRelease((float*)resultMatrix);
+		}
+
+		matmulRelease(ctx);
+	}
+
+	if (format == BENCHMARK_FORMAT_JSON)
+		fputs(first ? "[]\n" : "\n]\n", stdout);
+
+	free(devices);
+	free(times);
+	return failed;
+}
@@ -0,0 +1,53 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "matmul.h"
+
+// Runs before the timed repetitions of every device, mode and shape, which build the kernel and fill the buffer pool
+#define BENCHMARK_WARMUP_NUM 2
+
+// Each dimension of a shape grid lists at most this many sizes
+#define BENCHMARK_GRID_DIM_MAX 16
+
+// The estimated peak of every device is replaced by this many GFLOP/s when set
+#define BENCHMARK_PEAK_ENV "MATMUL_PEAK_GFLOPS"
+
+// Arithmetic lanes per compute unit assumed for devices other than CPUs, whose preferred vector width says nothing about them
+#define BENCHMARK_GPU_LANES 64
+
+#define BENCHMARK_FORMAT_CSV 0
+#define BENCHMARK_FORMAT_JSON 1
+
+struct benchmarkShape
+{
+	unsigned int rowFirstMatrix;
+	unsigned int colSecondMatrix;
+	unsigned int colFirstRowSecond;
+};
+
+// Kernel times of the timed repetitions of one device, mode and shape in ms, and the rates of the median time
+struct benchmarkResult
+{
+	const char* deviceName;
+	int implementationType;
+	int elementType;
+	struct benchmarkShape shape;
+	unsigned int repeatNum;
+	double minTime;
+	double medianTime;
+	double percentileTime;
+	double gflops;
+	double bandwidth;
+	double peakPercent;
+};
+
+unsigned char shapeGridParsing(const char* grid, struct benchmarkShape** shapes, size_t* shapeNum);
+double devicePeakEstimation(cl_device_id device, int elementType);
+double timePercentile(const double* sortedTimes, size_t timeNum, double fraction);
+void randomMatrixFilling(void* matrix, size_t count, int elementType);
+unsigned char benchmarkMeasuring(struct matmulContext* ctx, int implementationType, int elementType, const struct benchmarkShape* shape,
+	const void* firstMatrix, const void* secondMatrix, void* resultMatrix, unsigned int repeatNum, double* times);
+void benchmarkResultPrinting(FILE* file, int format, const struct benchmarkResult* result, unsigned char first);
+unsigned char benchmarkProcessing(const struct benchmarkShape* shapes, size_t shapeNum, int elementType, unsigned int repeatNum, int format);
+
+#endif
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bufferPool.h"
+
+void bufferPoolInit(struct bufferPool* pool, cl_context context, size_t granularity, size_t memoryCap)
+{
+	memset(pool, 0, sizeof(struct bufferPool));
+	pool->context = context;
+	pool->granularity = granularity ? granularity : 1;
+	pool->memoryCap = memoryCap;
+	pool->stats.memoryCap = memoryCap;
+}
+
+void bufferPoolRelease(struct bufferPool* pool)
+{
+	for (size_t i = 0; i < pool->bufferNum; i++)
+		clReleaseMemObject(pool->buffers[i].mem);
+
+	free(pool->buffers);
+	pool->buffers = NULL;
+	pool->bufferNum = 0;
+	pool->bufferCapacity = 0;
+	pool->stats.allocatedBytes = 0;
+	pool->stats.inUseBytes = 0;
+}
+
+size_t bufferSizeClass(const struct bufferPool* pool, size_t requiredSize)
+{
+	size_t units = (requiredSize + pool->granularity - 1) / pool->granularity;
+	if (units <= BUFFER_POOL_CLASS_STEPS)
+		return (units ? units : 1) * pool->granularity;
+
+	size_t topBit = 1;
+	while (topBit <= units / 2)
+		topBit <<= 1;
+
+	size_t step = topBit / BUFFER_POOL_CLASS_STEPS;
+	units = (units + step - 1) / step * step;
+
+	return units * pool->granularity;
+}
+
+// Frees least recently used idle buffers until requiredSize more bytes fit under the cap
+unsigned char bufferPoolEviction(struct bufferPool* pool, size_t requiredSize)
+{
+	while (pool->memoryCap && pool->stats.allocatedBytes + requiredSize > pool->memoryCap)
+	{
+		size_t victim = pool->bufferNum;
+		for (size_t i = 0; i < pool->bufferNum; i++)
+		{
+			if (!pool->buffers[i].inUse && (victim == pool->bufferNum || pool->buffers[i].lastUse < pool->buffers[victim].lastUse))
+				victim = i;
+		}
+
+		if (victim == pool->bufferNum)
+			return 1;
+
+		clReleaseMemObject(pool->buffers[victim].mem);
+		pool->stats.allocatedBytes -= pool->buffers[victim].size;
+		pool->stats.evictionNum++;
+		pool->buffers[victim] = pool->buffers[--pool->bufferNum];
+	}
+
+	return 0;
+}
+
+unsigned char bufferAcquiring(struct bufferPool* pool, size_t requiredSize, cl_mem_flags flags, cl_mem* mem)
+{
+	size_t classSize = bufferSizeClass(pool, requiredSize);
+
+	for (size_t i = 0; i < pool->bufferNum; i++)
+	{
+		struct pooledBuffer* buffer = &pool->buffers[i];
+		if (!buffer->inUse && buffer->size == classSize && buffer->flags == flags)
+		{
+			buffer->inUse = 1;
+			buffer->lastUse = ++pool->useCounter;
+			pool->stats.inUseBytes += buffer->size;
+			pool->stats.reuseNum++;
+			*mem = buffer->mem;
+			return 0;
+		}
+	}
+
+	if ((pool->memoryCap && classSize > pool->memoryCap) || bufferPoolEviction(pool, classSize))
+	{
+		fprintf(stderr, "Device memory cap exceeded!\n");
+		return 1;
+	}
+
+	if (pool->bufferNum == pool->bufferCapacity)
+	{
+		size_t bufferCapacity = pool->bufferCapacity ? pool->bufferCapacity * 2 : 8;
+		struct pooledBuffer* buffers = (struct pooledBuffer*)realloc(pool->buffers, sizeof(struct pooledBuffer) * bufferCapacity);
+		if (buffers == NULL)
+		{
+			fprintf(stderr, "Insufficient memory available!\n");
+			return 1;
+		}
+
+		pool->buffers = buffers;
+		pool->bufferCapacity = bufferCapacity;
+	}
+
+	cl_int errCodeReturn = CL_SUCCESS;
+	cl_mem newMem = clCreateBuffer(pool->context, flags, classSize, NULL, &errCodeReturn);
+
+	// The driver may be out of memory while idle buffers of other classes are still held
+	if (errCodeReturn == CL_MEM_OBJECT_ALLOCATION_FAILURE || errCodeReturn == CL_OUT_OF_RESOURCES)
+	{
+		bufferPoolTrimming(pool);
+		newMem = clCreateBuffer(pool->context, flags, classSize, NULL, &errCodeReturn);
+	}
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateBuffer");
+		return 1;
+	}
+
+	struct pooledBuffer* buffer = &pool->buffers[pool->bufferNum++];
+	buffer->mem = newMem;
+	buffer->size = classSize;
+	buffer->flags = flags;
+	buffer->inUse = 1;
+	buffer->lastUse = ++pool->useCounter;
+
+	pool->stats.allocatedBytes += classSize;
+	pool->stats.inUseBytes += classSize;
+	pool->stats.allocationNum++;
+	if (pool->stats.highWaterMark < pool->stats.allocatedBytes)
+		pool->stats.highWaterMark = pool->stats.allocatedBytes;
+
+	*mem = newMem;
+	return 0;
+}
+
+void bufferReturning(struct bufferPool* pool, cl_mem mem)
+{
+	if (mem == NULL)
+		return;
+
+	for (size_t i = 0; i < pool->bufferNum; i++)
+	{
+		if (pool->buffers[i].mem == mem && pool->buffers[i].inUse)
+		{
+			pool->buffers[i].inUse = 0;
+			pool->stats.inUseBytes -= pool->buffers[i].size;
+			return;
+		}
+	}
+}
+
+void buffersReturning(struct bufferPool* pool, cl_mem* mems, size_t memNum)
+{
+	for (size_t i = 0; i < memNum; i++)
+		bufferReturning(pool, mems[i]);
+}
+
+// Releases all idle buffers
+void bufferPoolTrimming(struct bufferPool* pool)
+{
+	size_t keptNum = 0;
+
+	for (size_t i = 0; i < pool->bufferNum; i++)
+	{
+		if (pool->buffers[i].inUse)
+		{
+			pool->buffers[keptNum++] = pool->buffers[i];
+		}
+		else
+		{
+			clReleaseMemObject(pool->buffers[i].mem);
+			pool->stats.allocatedBytes -= pool->buffers[i].size;
+			pool->stats.evictionNum++;
+		}
+	}
+
+	pool->bufferNum = keptNum;
+}
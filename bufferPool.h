@@ -0,0 +1,41 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include "matmul.h"
+
+// Size classes are granularity multiples with four classes per power of two, so a reused buffer wastes at most a quarter
+#define BUFFER_POOL_CLASS_STEPS 4U
+
+struct pooledBuffer
+{
+	cl_mem mem;
+	size_t size;
+	cl_mem_flags flags;
+	unsigned char inUse;
+	unsigned long long lastUse;
+};
+
+struct bufferPool
+{
+	cl_context context;
+	size_t granularity;
+	size_t memoryCap;
+
+	struct pooledBuffer* buffers;
+	size_t bufferNum;
+	size_t bufferCapacity;
+
+	unsigned long long useCounter;
+	struct bufferPoolStats stats;
+};
+
+void bufferPoolInit(struct bufferPool* pool, cl_context context, size_t granularity, size_t memoryCap);
+void bufferPoolRelease(struct bufferPool* pool);
+size_t bufferSizeClass(const struct bufferPool* pool, size_t requiredSize);
+unsigned char bufferPoolEviction(struct bufferPool* pool, size_t requiredSize);
+unsigned char bufferAcquiring(struct bufferPool* pool, size_t requiredSize, cl_mem_flags flags, cl_mem* mem);
+void bufferReturning(struct bufferPool* pool, cl_mem mem);
+void buffersReturning(struct bufferPool* pool, cl_mem* mems, size_t memNum);
+void bufferPoolTrimming(struct bufferPool* pool);
+
+#endif
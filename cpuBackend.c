@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "cpuBackend.h"
+#include "matmul.h"
+#include "matrixIO.h"
+
+#if defined(__AVX512F__)
+#define CPU_VEC_WIDTH 16
+#define vecType __m512
+#define vecZero _mm512_setzero_ps
+#define vecLoad _mm512_loadu_ps
+#define vecStore _mm512_storeu_ps
+#define vecBroadcast _mm512_set1_ps
+#define vecFma _mm512_fmadd_ps
+#define vecAdd _mm512_add_ps
+#elif defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define CPU_VEC_WIDTH 8
+#define vecType __m256
+#define vecZero _mm256_setzero_ps
+#define vecLoad _mm256_loadu_ps
+#define vecStore _mm256_storeu_ps
+#define vecBroadcast _mm256_set1_ps
+#define vecFma _mm256_fmadd_ps
+#define vecAdd _mm256_add_ps
+#endif
+
+// CPU_MR consecutive rows are interleaved per k, rows past rowNum are zero; element (row, k) is at row * rowStride + k * depthStride,
+// so the same packing reads the first matrix as stored or transposed
+void firstPanelPacking(const float* firstMatrix, size_t rowStride, size_t depthStride, size_t rowNum, size_t depth, float* packedPanel)
+{
+	for (size_t sliver = 0; sliver < rowNum; sliver += CPU_MR)
+	{
+		for (size_t k = 0; k < depth; k++)
+		{
+			for (size_t r = 0; r < CPU_MR; r++)
+				*packedPanel++ = sliver + r < rowNum ? firstMatrix[(sliver + r) * rowStride + k * depthStride] : 0.0f;
+		}
+	}
+}
+
+// Each column of the second matrix becomes one lane of the CPU_NR wide sliver; element (k, col) is at col * colStride + k * depthStride
+void secondPanelPacking(const float* secondMatrix, size_t colStride, size_t depthStride, size_t colNum, size_t depth, float* packedPanel)
+{
+	for (size_t sliver = 0; sliver < colNum; sliver += CPU_NR)
+	{
+		for (size_t k = 0; k < depth; k++)
+		{
+			for (size_t c = 0; c < CPU_NR; c++)
+				packedPanel[k * CPU_NR + c] = sliver + c < colNum ? secondMatrix[(sliver + c) * colStride + k * depthStride] : 0.0f;
+		}
+
+		packedPanel += depth * CPU_NR;
+	}
+}
+
+// Computes a CPU_MR x CPU_NR block in registers and writes (or adds) its rowNum x colNum part
+void microKernel(size_t depth, const float* packedFirst, const float* packedSecond, float* resultMatrix, size_t colQuantity,
+	size_t rowNum, size_t colNum, unsigned char accumulate)
+{
+	float block[CPU_MR * CPU_NR];
+
+#ifdef CPU_VEC_WIDTH
+	vecType blockVec[CPU_MR][CPU_NR / CPU_VEC_WIDTH];
+
+	for (size_t r = 0; r < CPU_MR; r++)
+		for (size_t v = 0; v < CPU_NR / CPU_VEC_WIDTH; v++)
+			blockVec[r][v] = vecZero();
+
+	for (size_t k = 0; k < depth; k++)
+	{
+		vecType secondVec[CPU_NR / CPU_VEC_WIDTH];
+		for (size_t v = 0; v < CPU_NR / CPU_VEC_WIDTH; v++)
+			secondVec[v] = vecLoad(packedSecond + k * CPU_NR + v * CPU_VEC_WIDTH);
+
+		for (size_t r = 0; r < CPU_MR; r++)
+		{
+			vecType firstVec = vecBroadcast(packedFirst[k * CPU_MR + r]);
+
+			for (size_t v = 0; v < CPU_NR / CPU_VEC_WIDTH; v++)
+				blockVec[r][v] = vecFma(firstVec, secondVec[v], blockVec[r][v]);
+		}
+	}
+
+	if (rowNum == CPU_MR && colNum == CPU_NR)
+	{
+		for (size_t r = 0; r < CPU_MR; r++)
+		{
+			for (size_t v = 0; v < CPU_NR / CPU_VEC_WIDTH; v++)
+			{
+				float* result = resultMatrix + r * colQuantity + v * CPU_VEC_WIDTH;
+				vecStore(result, accumulate ? vecAdd(vecLoad(result), blockVec[r][v]) : blockVec[r][v]);
+			}
+		}
+
+		return;
+	}
+
+	for (size_t r = 0; r < CPU_MR; r++)
+		for (size_t v = 0; v < CPU_NR / CPU_VEC_WIDTH; v++)
+			vecStore(block + r * CPU_NR + v * CPU_VEC_WIDTH, blockVec[r][v]);
+#else
+	memset(block, 0, sizeof(block));
+
+	for (size_t k = 0; k < depth; k++)
+		for (size_t r = 0; r < CPU_MR; r++)
+			for (size_t c = 0; c < CPU_NR; c++)
+				block[r * CPU_NR + c] += packedFirst[k * CPU_MR + r] * packedSecond[k * CPU_NR + c];
+#endif
+
+	for (size_t r = 0; r < rowNum; r++)
+	{
+		for (size_t c = 0; c < colNum; c++)
+		{
+			if (accumulate)
+				resultMatrix[r * colQuantity + c] += block[r * CPU_NR + c];
+			else
+				resultMatrix[r * colQuantity + c] = block[r * CPU_NR + c];
+		}
+	}
+}
+
+// resultMatrix (M x N) = op(firstMatrix) * op(secondMatrix) with the layout flags of matmul.h, for batchNum pairs; stored rows are
+// the leading dimensions apart, and a batch follows the stored rows of the previous one;
+// every thread takes whole CPU_MC x CPU_NC blocks of any of the results and packs its own panels
+unsigned char cpuMatmul(const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	size_t rowFirstMatrix, size_t colSecondMatrix, size_t colFirstRowSecond, size_t batchNum, int layout,
+	size_t firstLeadingDim, size_t secondLeadingDim, size_t resultLeadingDim, double* computeTime)
+{
+	double startTime = wallTime();
+
+	if (!colFirstRowSecond)
+	{
+		for (size_t row = 0; row < rowFirstMatrix * batchNum; row++)
+			memset(resultMatrix + row * resultLeadingDim, 0, sizeof(float) * colSecondMatrix);
+	}
+
+	const size_t rowBlockNum = (rowFirstMatrix + CPU_MC - 1) / CPU_MC;
+	const size_t colBlockNum = (colSecondMatrix + CPU_NC - 1) / CPU_NC;
+	const size_t batchBlockNum = rowBlockNum * colBlockNum;
+	const long long blockNum = (long long)(batchBlockNum * batchNum);
+
+	const size_t firstRowStride = layout & LAYOUT_FIRST_TRANSPOSED ? 1 : firstLeadingDim;
+	const size_t firstDepthStride = layout & LAYOUT_FIRST_TRANSPOSED ? firstLeadingDim : 1;
+	const size_t secondColStride = layout & LAYOUT_SECOND_TRANSPOSED ? secondLeadingDim : 1;
+	const size_t secondDepthStride = layout & LAYOUT_SECOND_TRANSPOSED ? 1 : secondLeadingDim;
+
+	const size_t firstBatchStride = (layout & LAYOUT_FIRST_TRANSPOSED ? colFirstRowSecond : rowFirstMatrix) * firstLeadingDim;
+	const size_t secondBatchStride = (layout & LAYOUT_SECOND_TRANSPOSED ? colSecondMatrix : colFirstRowSecond) * secondLeadingDim;
+
+	unsigned char errCode = 0;
+
+	#pragma omp parallel reduction(|:errCode)
+	{
+		float* packedFirst = (float*)malloc(sizeof(float) * CPU_MC * CPU_KC);
+		float* packedSecond = (float*)malloc(sizeof(float) * CPU_NC * CPU_KC);
+
+		if (packedFirst == NULL || packedSecond == NULL)
+			errCode = 1;
+
+		#pragma omp for schedule(dynamic)
+		for (long long block = 0; block < blockNum; block++)
+		{
+			if (errCode)
+				continue;
+
+			const size_t batch = (size_t)block / batchBlockNum;
+			const size_t rowStart = (size_t)block % batchBlockNum / colBlockNum * CPU_MC;
+			const size_t colStart = (size_t)block % colBlockNum * CPU_NC;
+
+			const float* batchFirstMatrix = firstMatrix + batch * firstBatchStride;
+			const float* batchSecondMatrix = secondMatrix + batch * secondBatchStride;
+			float* batchResultMatrix = resultMatrix + batch * rowFirstMatrix * resultLeadingDim;
+			const size_t rowNum = rowFirstMatrix - rowStart < CPU_MC ? rowFirstMatrix - rowStart : CPU_MC;
+			const size_t colNum = colSecondMatrix - colStart < CPU_NC ? colSecondMatrix - colStart : CPU_NC;
+
+			for (size_t depthStart = 0; depthStart < colFirstRowSecond; depthStart += CPU_KC)
+			{
+				const size_t depth = colFirstRowSecond - depthStart < CPU_KC ? colFirstRowSecond - depthStart : CPU_KC;
+
+				secondPanelPacking(batchSecondMatrix + colStart * secondColStride + depthStart * secondDepthStride, secondColStride, secondDepthStride,
+					colNum, depth, packedSecond);
+				firstPanelPacking(batchFirstMatrix + rowStart * firstRowStride + depthStart * firstDepthStride, firstRowStride, firstDepthStride,
+					rowNum, depth, packedFirst);
+
+				for (size_t col = 0; col < colNum; col += CPU_NR)
+				{
+					for (size_t row = 0; row < rowNum; row += CPU_MR)
+					{
+						microKernel(depth, packedFirst + row * depth, packedSecond + col * depth,
+							batchResultMatrix + (rowStart + row) * resultLeadingDim + colStart + col, resultLeadingDim,
+							rowNum - row < CPU_MR ? rowNum - row : CPU_MR, colNum - col < CPU_NR ? colNum - col : CPU_NR, depthStart != 0);
+					}
+				}
+			}
+		}
+
+		free(packedFirst);
+		free(packedSecond);
+	}
+
+	if (errCode)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	if (computeTime != NULL)
+		*computeTime = (wallTime() - startTime) * 1000.0;
+
+	return 0;
+}
+
+// Rows of a CSR first matrix are dealt to the threads dynamically, as their lengths differ. Each nonzero adds its scaled row of
+// the second matrix to the result row; with a transposed second matrix every result element is a dot product instead
+void cpuSparseMatmul(const unsigned int* rowPointers, const unsigned int* colIndices, const float* values, const float* secondMatrix, float* resultMatrix,
+	size_t rowFirstMatrix, size_t colSecondMatrix, int layout, size_t secondLeadingDim, size_t resultLeadingDim, double* computeTime)
+{
+	double startTime = wallTime();
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for (long long row = 0; row < (long long)rowFirstMatrix; row++)
+	{
+		float* resultRow = resultMatrix + (size_t)row * resultLeadingDim;
+
+		if (layout & LAYOUT_SECOND_TRANSPOSED)
+		{
+			for (size_t col = 0; col < colSecondMatrix; col++)
+			{
+				float currElResultMatrix = 0.0f;
+				for (unsigned int i = rowPointers[row]; i < rowPointers[row + 1]; i++)
+					currElResultMatrix += values[i] * secondMatrix[col * secondLeadingDim + colIndices[i]];
+
+				resultRow[col] = currElResultMatrix;
+			}
+		}
+		else
+		{
+			memset(resultRow, 0, sizeof(float) * colSecondMatrix);
+
+			for (unsigned int i = rowPointers[row]; i < rowPointers[row + 1]; i++)
+			{
+				const float value = values[i];
+				const float* secondRow = secondMatrix + (size_t)colIndices[i] * secondLeadingDim;
+
+				for (size_t col = 0; col < colSecondMatrix; col++)
+					resultRow[col] += value * secondRow[col];
+			}
+		}
+	}
+
+	if (computeTime != NULL)
+		*computeTime = (wallTime() - startTime) * 1000.0;
+}
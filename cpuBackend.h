@@ -0,0 +1,36 @@
+#ifndef CPU_BACKEND_H
+#define CPU_BACKEND_H
+
+#include <stddef.h>
+
+// Micro-kernel shape: CPU_MR rows of the first matrix by CPU_NR columns of the second held in vector registers
+#if defined(__AVX512F__)
+#define CPU_SIMD_NAME "AVX-512"
+#define CPU_MR 12
+#define CPU_NR 32
+#elif defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define CPU_SIMD_NAME "AVX2"
+#define CPU_MR 6
+#define CPU_NR 16
+#else
+#define CPU_SIMD_NAME "scalar"
+#define CPU_MR 4
+#define CPU_NR 8
+#endif
+
+// Cache blocking: a CPU_KC deep panel of the second matrix stays in L1, a CPU_MC x CPU_KC block of the first in L2
+#define CPU_KC 256
+#define CPU_MC (CPU_MR * 16)
+#define CPU_NC (CPU_NR * 8)
+
+void firstPanelPacking(const float* firstMatrix, size_t rowStride, size_t depthStride, size_t rowNum, size_t depth, float* packedPanel);
+void secondPanelPacking(const float* secondMatrix, size_t colStride, size_t depthStride, size_t colNum, size_t depth, float* packedPanel);
+void microKernel(size_t depth, const float* packedFirst, const float* packedSecond, float* resultMatrix, size_t colQuantity,
+	size_t rowNum, size_t colNum, unsigned char accumulate);
+unsigned char cpuMatmul(const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	size_t rowFirstMatrix, size_t colSecondMatrix, size_t colFirstRowSecond, size_t batchNum, int layout,
+	size_t firstLeadingDim, size_t secondLeadingDim, size_t resultLeadingDim, double* computeTime);
+void cpuSparseMatmul(const unsigned int* rowPointers, const unsigned int* colIndices, const float* values, const float* secondMatrix, float* resultMatrix,
+	size_t rowFirstMatrix, size_t colSecondMatrix, int layout, size_t secondLeadingDim, size_t resultLeadingDim, double* computeTime);
+
+#endif
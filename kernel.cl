@@ -1,17 +1,28 @@
-__kernel void matrixMultiplication(
-									__global const float* firstMatrix,
-									__global const float* secondMatrix,
-									__global float* resultMatrix,
-									const unsigned int colFirstRowSecond,
-									const unsigned int colQuantity)
-{
-	const unsigned int currCol = get_global_id(0);
-	const unsigned int currRow = get_global_id(1);
-
-	float currElResultMatrix = 0.0f;
-	
-	for(unsigned int i = 0; i < colFirstRowSecond; i++)
-		currElResultMatrix += firstMatrix[currRow * colFirstRowSecond + i] * secondMatrix[currCol * colFirstRowSecond + i];
-	
-	resultMatrix[currRow * colQuantity + currCol] = currElResultMatrix;
+__kernel void matrixMultiplication(
+									__global const elemType* firstMatrix,
+									__global const elemType* secondMatrix,
+									__global resultType* resultMatrix,
+									const unsigned int colFirstRowSecond,
+									const unsigned int colQuantity,
+									const unsigned int firstLeadingDim,
+									const unsigned int secondLeadingDim,
+									const unsigned int resultLeadingDim
+									epilogueArgs)
+{
+	// The third dimension selects the pair of a batch; each matrix of a batch takes its stored rows times its leading dimension
+	const unsigned int rowQuantity = get_global_size(1);
+	const size_t batch = get_global_id(2);
+	firstMatrix += batch * firstStoredRows * firstLeadingDim;
+	secondMatrix += batch * secondStoredRows * secondLeadingDim;
+	resultMatrix += batch * rowQuantity * resultLeadingDim;
+
+	const unsigned int currCol = get_global_id(0);
+	const unsigned int currRow = get_global_id(1);
+
+	accType currElResultMatrix = 0;
+	
+	for(unsigned int i = 0; i < colFirstRowSecond; i++)
+		currElResultMatrix += elementLoad(firstIndex(currRow, i), firstMatrix) * elementLoad(secondIndex(i, currCol), secondMatrix);
+	
+	elementStore(epilogueApplying(currElResultMatrix, resultIndex(currRow, currCol), currCol), resultIndex(currRow, currCol), resultMatrix);
 }
\ No newline at end of file
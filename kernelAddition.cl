@@ -0,0 +1,23 @@
+__kernel void matrixAddition(
+									__global const elemType* firstMatrix,
+									__global const elemType* secondMatrix,
+									__global resultType* resultMatrix,
+									const unsigned int colQuantity,
+									const unsigned int rowQuantity,
+									const accType secondSign,
+									const ulong firstOffset,
+									const ulong secondOffset,
+									const ulong resultOffset,
+									const unsigned int firstLeadingDim,
+									const unsigned int secondLeadingDim,
+									const unsigned int resultLeadingDim)
+{
+	// Each work-item adds one element of the views; the result may be one of the operands
+	const unsigned int currCol = get_global_id(0);
+	const unsigned int currRow = get_global_id(1);
+
+	if(currRow < rowQuantity && currCol < colQuantity)
+		elementStore(elementLoad(firstOffset + (ulong)currRow * firstLeadingDim + currCol, firstMatrix)
+			+ secondSign * elementLoad(secondOffset + (ulong)currRow * secondLeadingDim + currCol, secondMatrix),
+			resultOffset + (ulong)currRow * resultLeadingDim + currCol, resultMatrix);
+}
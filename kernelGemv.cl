@@ -0,0 +1,94 @@
+// The matrix is multiplied by a few vectors: the columns of the second matrix or, with vectorFirst, the rows of the first one.
+// Every result element is a dot product along K, which the LSIZE lanes of a work-group row share and sum up in local memory
+#ifdef vectorFirst
+#define matrixIndex(out, k) secondIndex(k, out)
+#define vectorIndex(k, vec) firstIndex(vec, k)
+#define matrixPointer secondMatrix
+#define vectorPointer firstMatrix
+#define outputIndex(out, vec) resultIndex(vec, out)
+#define outputCol(out, vec) (out)
+#define outQuantity colQuantity
+#else
+#define matrixIndex(out, k) firstIndex(out, k)
+#define vectorIndex(k, vec) secondIndex(k, vec)
+#define matrixPointer firstMatrix
+#define vectorPointer secondMatrix
+#define outputIndex(out, vec) resultIndex(out, vec)
+#define outputCol(out, vec) (vec)
+#define outQuantity rowQuantity
+#endif
+
+// When the stored rows of the matrix run along K, the lanes are local id 0 and read vecWidth elements at a time;
+// otherwise local id 0 runs along the outputs, so neighbouring work-items still read neighbouring addresses
+#if defined(vectorFirst) && defined(secondTransposed) || !defined(vectorFirst) && !defined(firstTransposed)
+#define matrixAlongK
+#define lane get_local_id(0)
+#define localOut get_local_id(1)
+#define currOut get_global_id(1)
+#else
+#define lane get_local_id(1)
+#define localOut get_local_id(0)
+#define currOut get_global_id(0)
+#endif
+
+__kernel void matrixVectorMultiplication(
+											__global const elemType* firstMatrix,
+											__global const elemType* secondMatrix,
+											__global resultType* resultMatrix,
+											const unsigned int colFirstRowSecond,
+											const unsigned int colQuantity,
+											const unsigned int rowQuantity,
+											const unsigned int firstLeadingDim,
+											const unsigned int secondLeadingDim,
+											const unsigned int resultLeadingDim
+											epilogueArgs)
+{
+	__local accType partialSums[LSIZE][LSIZE + 1];
+
+	const unsigned int out = currOut;
+	const unsigned int currVector = get_global_id(2);
+
+	accType currElResultMatrix = 0;
+
+	if (out < outQuantity)
+	{
+		unsigned int k = lane;
+
+#ifdef matrixAlongK
+		floatType partialProduct = (floatType)(0);
+		accType vectorElements[vecWidth];
+
+		for (k = lane * vecWidth; k + vecWidth <= colFirstRowSecond; k += LSIZE * vecWidth)
+		{
+			for (unsigned int i = 0; i < vecWidth; i++)
+				vectorElements[i] = elementLoad(vectorIndex(k + i, currVector), vectorPointer);
+
+			partialProduct += globalVectorLoad(0, matrixPointer + matrixIndex(out, k)) * vectorLoad(0, vectorElements);
+		}
+
+		vectorStore(partialProduct, 0, vectorElements);
+		for (unsigned int i = 0; i < vecWidth; i++)
+			currElResultMatrix += vectorElements[i];
+
+		k = colFirstRowSecond / vecWidth * vecWidth + lane;
+#endif
+
+		for (; k < colFirstRowSecond; k += LSIZE)
+			currElResultMatrix += elementLoad(matrixIndex(out, k), matrixPointer) * elementLoad(vectorIndex(k, currVector), vectorPointer);
+	}
+
+	partialSums[localOut][lane] = currElResultMatrix;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// LSIZE need not be a power of two, so the upper half is rounded up and its last lane left alone when the count is odd
+	for (unsigned int laneNum = LSIZE; laneNum > 1; laneNum = (laneNum + 1) / 2)
+	{
+		if (lane + (laneNum + 1) / 2 < laneNum)
+			partialSums[localOut][lane] += partialSums[localOut][lane + (laneNum + 1) / 2];
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (lane == 0 && out < outQuantity)
+		elementStore(epilogueApplying(partialSums[localOut][0], outputIndex(out, currVector), outputCol(out, currVector)), outputIndex(out, currVector), resultMatrix);
+}
@@ -1,45 +1,73 @@
-__kernel void matrixMultiplication(
-									__global const float* firstMatrix,
-									__global const float* secondMatrix,
-									__global float* resultMatrix,
-									const unsigned int colFirstRowSecond,
-									const unsigned int colQuantity,
-									const unsigned int rowQuantity,
-									const unsigned int normalColRow)
-{
-	const unsigned int currCol = get_global_id(0);
-	const unsigned int currRow = get_global_id(1);
-
-	__local float localFM[LSIZE][LSIZE];
-	__local float localSM[LSIZE][LSIZE + 1];
-
-	const unsigned char currLocalCol = get_local_id(0);
-	const unsigned char currLocalRow = get_local_id(1);
-
-	float currElResultMatrix = 0.0f;
-
-	for(unsigned int i = 0; i < normalColRow; i++)
-	{
-		unsigned int currLSIZE = i * LSIZE;
-
-		if(currLocalCol < colFirstRowSecond - currLSIZE && currRow < rowQuantity)
-			localFM[currLocalRow][currLocalCol] = firstMatrix[currRow * colFirstRowSecond + currLocalCol + currLSIZE];
-		else
-			localFM[currLocalRow][currLocalCol] = 0;
-		
-		if(currLocalRow < colFirstRowSecond - currLSIZE && currCol < colQuantity)
-			localSM[currLocalCol][currLocalRow] = secondMatrix[currCol * colFirstRowSecond + currLocalRow + currLSIZE];
-		else
-			localSM[currLocalCol][currLocalRow] = 0;
-
-		barrier(CLK_LOCAL_MEM_FENCE);
-
-		for(unsigned int j = 0; j < LSIZE; j++)
-			currElResultMatrix += localFM[currLocalRow][j] * localSM[currLocalCol][j];
-
-		barrier(CLK_LOCAL_MEM_FENCE);
-	}
-
-	if(currRow < rowQuantity && currCol < colQuantity)
-		resultMatrix[currRow * colQuantity + currCol] = currElResultMatrix;
+__kernel void matrixMultiplication(
+									__global const elemType* firstMatrix,
+									__global const elemType* secondMatrix,
+									__global resultType* resultMatrix,
+									unsigned int colFirstRowSecond,
+									const unsigned int colQuantity,
+									const unsigned int rowQuantity,
+									unsigned int normalColRow,
+									const unsigned int firstLeadingDim,
+									const unsigned int secondLeadingDim,
+									const unsigned int resultLeadingDim
+									epilogueArgs)
+{
+	// The third dimension selects the pair of a batch; each matrix of a batch takes its stored rows times its leading dimension.
+	// With splitK it selects a slice of normalColRow tiles of K instead, and the partial products are stored one after another
+	const size_t batch = get_global_id(2);
+#ifdef splitK
+	const unsigned int sliceStart = batch * normalColRow * LSIZE;
+	firstMatrix += firstIndex(0, sliceStart);
+	secondMatrix += secondIndex(sliceStart, 0);
+	colFirstRowSecond -= sliceStart;
+	normalColRow = min(normalColRow, (colFirstRowSecond + LSIZE - 1) / LSIZE);
+#else
+	firstMatrix += batch * firstStoredRows * firstLeadingDim;
+	secondMatrix += batch * secondStoredRows * secondLeadingDim;
+#endif
+	resultMatrix += batch * rowQuantity * resultLeadingDim;
+
+	const unsigned int currCol = get_global_id(0);
+	const unsigned int currRow = get_global_id(1);
+
+	__local accType localFM[LSIZE][LSIZE + 1];
+	__local accType localSM[LSIZE][LSIZE + 1];
+
+	const unsigned char currLocalCol = get_local_id(0);
+	const unsigned char currLocalRow = get_local_id(1);
+
+	// The element of each tile this work-item loads, which for a transposed matrix is not the one it multiplies
+	const unsigned char loadRowFM = firstLocalRow;
+	const unsigned char loadColFM = firstLocalK;
+	const unsigned char loadRowSM = secondLocalCol;
+	const unsigned char loadColSM = secondLocalK;
+
+	const unsigned int tileRow = get_group_id(1) * LSIZE;
+	const unsigned int tileCol = get_group_id(0) * LSIZE;
+
+	accType currElResultMatrix = 0;
+
+	for(unsigned int i = 0; i < normalColRow; i++)
+	{
+		unsigned int currLSIZE = i * LSIZE;
+
+		if(loadColFM < colFirstRowSecond - currLSIZE && tileRow + loadRowFM < rowQuantity)
+			localFM[loadRowFM][loadColFM] = elementLoad(firstIndex(tileRow + loadRowFM, currLSIZE + loadColFM), firstMatrix);
+		else
+			localFM[loadRowFM][loadColFM] = 0;
+		
+		if(loadColSM < colFirstRowSecond - currLSIZE && tileCol + loadRowSM < colQuantity)
+			localSM[loadRowSM][loadColSM] = elementLoad(secondIndex(currLSIZE + loadColSM, tileCol + loadRowSM), secondMatrix);
+		else
+			localSM[loadRowSM][loadColSM] = 0;
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for(unsigned int j = 0; j < LSIZE; j++)
+			currElResultMatrix += localFM[currLocalRow][j] * localSM[currLocalCol][j];
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if(currRow < rowQuantity && currCol < colQuantity)
+		elementStore(epilogueApplying(currElResultMatrix, resultIndex(currRow, currCol), currCol), resultIndex(currRow, currCol), resultMatrix);
 }
\ No newline at end of file
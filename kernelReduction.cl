@@ -0,0 +1,24 @@
+__kernel void partialReduction(
+									__global const accType* partialMatrices,
+									__global resultType* resultMatrix,
+									const unsigned int colQuantity,
+									const unsigned int rowQuantity,
+									const unsigned int sliceNum,
+									const unsigned int resultLeadingDim
+									epilogueArgs)
+{
+	// The partial products of the slices of K are packed rowQuantity x colQuantity matrices one after another;
+	// each work-item sums one element of them and stores it through the epilogue
+	const unsigned int currCol = get_global_id(0);
+	const unsigned int currRow = get_global_id(1);
+
+	if(currRow < rowQuantity && currCol < colQuantity)
+	{
+		accType currElResultMatrix = 0;
+
+		for(unsigned int i = 0; i < sliceNum; i++)
+			currElResultMatrix += partialMatrices[((size_t)i * rowQuantity + currRow) * colQuantity + currCol];
+
+		elementStore(epilogueApplying(currElResultMatrix, resultIndex(currRow, currCol), currCol), resultIndex(currRow, currCol), resultMatrix);
+	}
+}
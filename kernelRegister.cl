@@ -0,0 +1,136 @@
+__kernel void matrixMultiplication(
+									__global const elemType* firstMatrix,
+									__global const elemType* secondMatrix,
+									__global resultType* resultMatrix,
+									unsigned int colFirstRowSecond,
+									const unsigned int colQuantity,
+									const unsigned int rowQuantity,
+									unsigned int normalColRow,
+									const unsigned int firstLeadingDim,
+									const unsigned int secondLeadingDim,
+									const unsigned int resultLeadingDim
+									epilogueArgs)
+{
+	// The third dimension selects the pair of a batch; each matrix of a batch takes its stored rows times its leading dimension.
+	// With splitK it selects a slice of normalColRow tiles of K instead, and the partial products are stored one after another
+	const size_t batch = get_global_id(2);
+#ifdef splitK
+	const unsigned int sliceStart = batch * normalColRow * LSIZE;
+	firstMatrix += firstIndex(0, sliceStart);
+	secondMatrix += secondIndex(sliceStart, 0);
+	colFirstRowSecond -= sliceStart;
+	normalColRow = min(normalColRow, (colFirstRowSecond + LSIZE - 1) / LSIZE);
+#else
+	firstMatrix += batch * firstStoredRows * firstLeadingDim;
+	secondMatrix += batch * secondStoredRows * secondLeadingDim;
+#endif
+	resultMatrix += batch * rowQuantity * resultLeadingDim;
+
+	// Each work-item computes a TM x TN block of the LSIZE * TM x LSIZE * TN tile of its group,
+	// with rows and columns strided by LSIZE so neighbouring work-items read neighbouring local memory
+	const unsigned int currLocalCol = get_local_id(0);
+	const unsigned int currLocalRow = get_local_id(1);
+
+	const unsigned int tileRow = get_group_id(1) * (LSIZE * TM);
+	const unsigned int tileCol = get_group_id(0) * (LSIZE * TN);
+
+	// Tiles are loaded along the stored rows, so for a transposed matrix the local ids swap roles
+	const unsigned int loadRowFM = firstLocalRow;
+	const unsigned int loadKFM = firstLocalK;
+	const unsigned int loadColSM = secondLocalCol;
+	const unsigned int loadKSM = secondLocalK;
+
+	// Two buffers per matrix: the next tile is loaded while the current one is multiplied
+	__local accType localFM[2][LSIZE][LSIZE * TM + 1];
+	__local accType localSM[2][LSIZE][LSIZE * TN + 1];
+
+	accType currElResultMatrix[TM][TN];
+	accType currElemSM[TN];
+
+	for(unsigned int m = 0; m < TM; m++)
+		for(unsigned int n = 0; n < TN; n++)
+			currElResultMatrix[m][n] = 0;
+
+	for(unsigned int m = 0; m < TM; m++)
+	{
+		unsigned int currRow = tileRow + loadRowFM + m * LSIZE;
+
+		if(currRow < rowQuantity && loadKFM < colFirstRowSecond)
+			localFM[0][loadKFM][loadRowFM + m * LSIZE] = elementLoad(firstIndex(currRow, loadKFM), firstMatrix);
+		else
+			localFM[0][loadKFM][loadRowFM + m * LSIZE] = 0;
+	}
+
+	for(unsigned int n = 0; n < TN; n++)
+	{
+		unsigned int currCol = tileCol + loadColSM + n * LSIZE;
+
+		if(currCol < colQuantity && loadKSM < colFirstRowSecond)
+			localSM[0][loadKSM][loadColSM + n * LSIZE] = elementLoad(secondIndex(loadKSM, currCol), secondMatrix);
+		else
+			localSM[0][loadKSM][loadColSM + n * LSIZE] = 0;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for(unsigned int i = 0; i < normalColRow; i++)
+	{
+		const unsigned int currBuffer = i & 1;
+
+		if(i + 1 < normalColRow)
+		{
+			const unsigned int nextBuffer = currBuffer ^ 1;
+			const unsigned int currKFM = (i + 1) * LSIZE + loadKFM;
+			const unsigned int currKSM = (i + 1) * LSIZE + loadKSM;
+
+			for(unsigned int m = 0; m < TM; m++)
+			{
+				unsigned int currRow = tileRow + loadRowFM + m * LSIZE;
+
+				if(currRow < rowQuantity && currKFM < colFirstRowSecond)
+					localFM[nextBuffer][loadKFM][loadRowFM + m * LSIZE] = elementLoad(firstIndex(currRow, currKFM), firstMatrix);
+				else
+					localFM[nextBuffer][loadKFM][loadRowFM + m * LSIZE] = 0;
+			}
+
+			for(unsigned int n = 0; n < TN; n++)
+			{
+				unsigned int currCol = tileCol + loadColSM + n * LSIZE;
+
+				if(currCol < colQuantity && currKSM < colFirstRowSecond)
+					localSM[nextBuffer][loadKSM][loadColSM + n * LSIZE] = elementLoad(secondIndex(currKSM, currCol), secondMatrix);
+				else
+					localSM[nextBuffer][loadKSM][loadColSM + n * LSIZE] = 0;
+			}
+		}
+
+		for(unsigned int j = 0; j < LSIZE; j++)
+		{
+			for(unsigned int n = 0; n < TN; n++)
+				currElemSM[n] = localSM[currBuffer][j][currLocalCol + n * LSIZE];
+
+			for(unsigned int m = 0; m < TM; m++)
+			{
+				accType currElemFM = localFM[currBuffer][j][currLocalRow + m * LSIZE];
+
+				for(unsigned int n = 0; n < TN; n++)
+					currElResultMatrix[m][n] += currElemFM * currElemSM[n];
+			}
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	for(unsigned int m = 0; m < TM; m++)
+	{
+		unsigned int currRow = tileRow + currLocalRow + m * LSIZE;
+
+		for(unsigned int n = 0; n < TN; n++)
+		{
+			unsigned int currCol = tileCol + currLocalCol + n * LSIZE;
+
+			if(currRow < rowQuantity && currCol < colQuantity)
+				elementStore(epilogueApplying(currElResultMatrix[m][n], resultIndex(currRow, currCol), currCol), resultIndex(currRow, currCol), resultMatrix);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+__kernel void sparseMultiplication(
+									__global const unsigned int* rowBlocks,
+									__global const unsigned int* rowPointers,
+									__global const unsigned int* colIndices,
+									__global const elemType* values,
+									__global const elemType* secondMatrix,
+									__global resultType* resultMatrix,
+									const unsigned int colQuantity,
+									const unsigned int secondLeadingDim,
+									const unsigned int resultLeadingDim
+									epilogueArgs)
+{
+	// A work-group takes one block of rows for LSIZE result columns; its TM lanes take the rows of the block in turn,
+	// except for a block of a single long row, whose nonzeros the lanes share and sum up in local memory
+	__local accType partialSums[TM][LSIZE];
+
+	const unsigned int currCol = get_global_id(0);
+	const unsigned int currLocalCol = get_local_id(0);
+	const unsigned int lane = get_local_id(1);
+
+	const unsigned int rowStart = rowBlocks[get_group_id(1)];
+	const unsigned int rowEnd = rowBlocks[get_group_id(1) + 1];
+
+	if (rowEnd - rowStart == 1)
+	{
+		accType currElResultMatrix = 0;
+
+		if (currCol < colQuantity)
+		{
+			for (unsigned int i = rowPointers[rowStart] + lane; i < rowPointers[rowEnd]; i += TM)
+				currElResultMatrix += elementLoad(i, values) * elementLoad(secondIndex(colIndices[i], currCol), secondMatrix);
+		}
+
+		partialSums[lane][currLocalCol] = currElResultMatrix;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (unsigned int laneNum = TM / 2; laneNum > 0; laneNum /= 2)
+		{
+			if (lane < laneNum)
+				partialSums[lane][currLocalCol] += partialSums[lane + laneNum][currLocalCol];
+
+			barrier(CLK_LOCAL_MEM_FENCE);
+		}
+
+		if (lane == 0 && currCol < colQuantity)
+			elementStore(epilogueApplying(partialSums[0][currLocalCol], resultIndex(rowStart, currCol), currCol), resultIndex(rowStart, currCol), resultMatrix);
+	}
+	else if (currCol < colQuantity)
+	{
+		for (unsigned int currRow = rowStart + lane; currRow < rowEnd; currRow += TM)
+		{
+			accType currElResultMatrix = 0;
+
+			for (unsigned int i = rowPointers[currRow]; i < rowPointers[currRow + 1]; i++)
+				currElResultMatrix += elementLoad(i, values) * elementLoad(secondIndex(colIndices[i], currCol), secondMatrix);
+
+			elementStore(epilogueApplying(currElResultMatrix, resultIndex(currRow, currCol), currCol), resultIndex(currRow, currCol), resultMatrix);
+		}
+	}
+}
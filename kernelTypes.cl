@@ -0,0 +1,121 @@
+// Put in front of every kernel. The matrices are stored as elemType, multiplied and summed in accType and the result
+// is stored as resultType; floatType is the accType vector of vecWidth elements. Half matrices are only read and
+// written through vload_half and vstore_half, which need no cl_khr_fp16
+#ifdef doublePrecision
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+
+#define vectorFunction(name, width) name##width
+#define vectorFunctionExpansion(name, width) vectorFunction(name, width)
+
+#if vecWidth == 1
+#define floatType accType
+#else
+#define floatType vectorFunctionExpansion(accType, vecWidth)
+#endif
+
+#ifdef halfStorage
+#define elementLoad(offset, pointer) vload_half(offset, pointer)
+#define elementStore(data, offset, pointer) vstore_half(data, offset, pointer)
+#else
+#define elementLoad(offset, pointer) ((accType)(pointer)[offset])
+#define elementStore(data, offset, pointer) ((pointer)[offset] = (resultType)(data))
+#endif
+
+// vecWidth may be 1, 2, 4, 8 or 16: loads and stores are picked by pasting the width onto vload/vstore,
+// or onto vload_half/vstore_half for the matrices in global memory when they are stored as half.
+// Other matrices in global memory are converted between their own vector types and floatType
+#if vecWidth == 1
+#define vectorLoad(offset, pointer) ((pointer)[offset])
+#define vectorStore(data, offset, pointer) ((pointer)[offset] = (data))
+#define globalVectorLoad elementLoad
+#define globalVectorStore elementStore
+#else
+#define vectorLoad vectorFunctionExpansion(vload, vecWidth)
+#define vectorStore vectorFunctionExpansion(vstore, vecWidth)
+#ifdef halfStorage
+#define globalVectorLoad vectorFunctionExpansion(vload_half, vecWidth)
+#define globalVectorStore vectorFunctionExpansion(vstore_half, vecWidth)
+#else
+#define accConversion vectorFunctionExpansion(convert_, floatType)
+#define resultConversion vectorFunctionExpansion(convert_, vectorFunctionExpansion(resultType, vecWidth))
+#define globalVectorLoad(offset, pointer) accConversion(vectorLoad(offset, pointer))
+#define globalVectorStore(data, offset, pointer) vectorStore(resultConversion(data), offset, pointer)
+#endif
+#endif
+
+// The first matrix is M x K or, with firstTransposed, K x M; the second is K x N or, with secondTransposed, N x K. Stored rows
+// are firstLeadingDim, secondLeadingDim and resultLeadingDim elements apart, so the matrices may be views into larger ones.
+// Tiles are loaded with local id 0 running along the stored rows, so neighbouring work-items read neighbouring addresses
+#ifdef firstTransposed
+#define firstIndex(row, k) ((k) * firstLeadingDim + (row))
+#define firstStoredRows colFirstRowSecond
+#define firstLocalRow get_local_id(0)
+#define firstLocalK get_local_id(1)
+#else
+#define firstIndex(row, k) ((row) * firstLeadingDim + (k))
+#define firstStoredRows rowQuantity
+#define firstLocalRow get_local_id(1)
+#define firstLocalK get_local_id(0)
+#endif
+
+#ifdef secondTransposed
+#define secondIndex(k, col) ((col) * secondLeadingDim + (k))
+#define secondStoredRows colQuantity
+#define secondLocalCol get_local_id(1)
+#define secondLocalK get_local_id(0)
+#else
+#define secondIndex(k, col) ((k) * secondLeadingDim + (col))
+#define secondStoredRows colFirstRowSecond
+#define secondLocalCol get_local_id(0)
+#define secondLocalK get_local_id(1)
+#endif
+
+#define resultIndex(row, col) ((row) * resultLeadingDim + (col))
+
+// With the epilogue defined the stored result is activation(alpha * product + beta * result + bias[column]), computed in
+// epilogueType right before the store; C is only read when beta is not zero. activation is 0 (none), 1 (ReLU) or 2 (GELU)
+#ifdef epilogue
+#ifdef doublePrecision
+#define epilogueType double
+#define epilogueSqrtHalf M_SQRT1_2
+#else
+#define epilogueType float
+#define epilogueSqrtHalf M_SQRT1_2_F
+#endif
+
+#if vecWidth == 1
+#define epilogueVectorType epilogueType
+#define epilogueConversion(data) ((epilogueType)(data))
+#else
+#define epilogueVectorType vectorFunctionExpansion(epilogueType, vecWidth)
+#define epilogueConversion vectorFunctionExpansion(convert_, epilogueVectorType)
+#endif
+
+#if activation == 1
+#define activationApplying(value) fmax(value, (epilogueType)0)
+#elif activation == 2
+#define activationApplying(value) ((epilogueType)0.5 * (value) * ((epilogueType)1 + erf((value) * epilogueSqrtHalf)))
+#else
+#define activationApplying(value) (value)
+#endif
+
+#ifdef biasAdd
+#define epilogueArgs , const epilogueType alpha, const epilogueType beta, __global const epilogueType* bias
+#define biasLoad(col) + bias[col]
+#define biasVectorLoad(col) + vectorLoad(0, bias + (col))
+#else
+#define epilogueArgs , const epilogueType alpha, const epilogueType beta
+#define biasLoad(col)
+#define biasVectorLoad(col)
+#endif
+
+#define epilogueApplying(data, offset, col) activationApplying(alpha * (epilogueType)(data) \
+	+ (beta != 0 ? beta * (epilogueType)elementLoad(offset, resultMatrix) : (epilogueType)0) biasLoad(col))
+#define vectorEpilogueApplying(data, offset, col) activationApplying(alpha * epilogueConversion(data) \
+	+ (beta != 0 ? beta * epilogueConversion(globalVectorLoad(0, resultMatrix + (offset))) : (epilogueVectorType)(0)) biasVectorLoad(col))
+#else
+#define epilogueArgs
+#define epilogueApplying(data, offset, col) (data)
+#define vectorEpilogueApplying(data, offset, col) (data)
+#endif
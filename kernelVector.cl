@@ -1,107 +1,147 @@
-__kernel void matrixMultiplication(
-									__global const float* firstMatrix,
-									__global const float* secondMatrix,
-									__global float* resultMatrix,
-									const unsigned int colFirstRowSecond,
-									const unsigned int colQuantity,
-									const unsigned int rowQuantity,
-									const unsigned int normalColRow)
-{
-	const unsigned int currCol = get_global_id(0);
-	const unsigned int currRow = get_global_id(1);
-
-	const unsigned char currLocalCol = get_local_id(0);
-	const unsigned char currLocalRow = get_local_id(1);
-
-	floatType currElResultMatrix = (floatType)(0.0f);
-
-	__local floatType localFM[LSIZE][LSIZE / vecWidth];
-	__local float localSM[LSIZE][LSIZE + 1];
-
-	for(unsigned int i = 0; i < normalColRow; i++)
-	{
-		unsigned int currLSIZE = i * LSIZE;
-
-		if(currRow < rowQuantity && (currLocalCol * vecWidth + currLSIZE + vecWidth - 1) < colFirstRowSecond)
-		{
-			localFM[currLocalRow][currLocalCol] = vload4(0, firstMatrix + (currRow * colFirstRowSecond + currLocalCol * vecWidth + currLSIZE));
-		}
-		else if(currRow < rowQuantity && (currLocalCol * vecWidth + currLSIZE) < colFirstRowSecond)
-		{
-			unsigned int k = colFirstRowSecond - (currLocalCol * vecWidth + currLSIZE);
-			if(k == 1)
-			{
-				localFM[currLocalRow][currLocalCol].s0 = firstMatrix[currRow * colFirstRowSecond + currLocalCol * vecWidth + currLSIZE];
-				localFM[currLocalRow][currLocalCol].s123 = (float3)(0.0f);
-			}
-			if(k == 2)
-			{
-				localFM[currLocalRow][currLocalCol].s01 = vload2(0, firstMatrix + (currRow * colFirstRowSecond + currLocalCol * vecWidth + currLSIZE));
-				localFM[currLocalRow][currLocalCol].s23 = (float2)(0.0f);
-			}
-			if(k == 3)
-			{
-				localFM[currLocalRow][currLocalCol].s012 = vload3(0, firstMatrix + (currRow * colFirstRowSecond + currLocalCol * vecWidth + currLSIZE));
-				localFM[currLocalRow][currLocalCol].s3 = 0.0f;
-			}
-		}
-		else
-		{
-			localFM[currLocalRow][currLocalCol] = (floatType)(0.0f);
-		}
-
-		for(unsigned int m = 0; m < vecWidth; m++)
-		{
-			if(currLocalRow < colFirstRowSecond - currLSIZE && currLocalCol * vecWidth + m < colQuantity)
-				localSM[currLocalRow][currLocalCol * vecWidth + m] = secondMatrix[(currCol * vecWidth + m) * colFirstRowSecond + currLocalRow + currLSIZE];
-			else
-				localSM[currLocalRow][currLocalCol * vecWidth + m] = 0;
-		}
-
-		barrier(CLK_LOCAL_MEM_FENCE);
-		float currElemFM;
-
-		for(unsigned int j = 0; j < LSIZE / vecWidth; j++)
-		{
-			floatType elemFM = localFM[currLocalRow][j];
-
-			for(unsigned int m = 0; m < vecWidth; m++)
-			{
-				switch(m)
-				{
-					case 0: currElemFM = elemFM.s0; break;
-					case 1: currElemFM = elemFM.s1; break;
-					case 2: currElemFM = elemFM.s2; break;
-					case 3: currElemFM = elemFM.s3; break;
-				}
-
-				currElResultMatrix.s0 += currElemFM * localSM[j * vecWidth + m][currLocalCol * vecWidth];
-				currElResultMatrix.s1 += currElemFM * localSM[j * vecWidth + m][currLocalCol * vecWidth + 1];
-				currElResultMatrix.s2 += currElemFM * localSM[j * vecWidth + m][currLocalCol * vecWidth + 2];
-				currElResultMatrix.s3 += currElemFM * localSM[j * vecWidth + m][currLocalCol * vecWidth + 3];
-			}
-		}
-
-		barrier(CLK_LOCAL_MEM_FENCE);
-	}
-
-	int k = colQuantity - (currCol * vecWidth);
-
-	if(currRow < rowQuantity && (currCol * vecWidth + vecWidth - 1) < colQuantity)
-	{
-		vstore4(currElResultMatrix, 0, resultMatrix + (currRow * colQuantity + currCol * vecWidth));
-	}
-	else
-	{
-		int k = colQuantity - currCol * vecWidth;
-
-		if(k == 1)
-			resultMatrix[currRow * colQuantity + currCol * vecWidth] = currElResultMatrix.s0;
-
-		if(k == 2)
-			vstore2(currElResultMatrix.s01, 0, resultMatrix + (currRow * colQuantity + currCol * vecWidth));
-
-		if(k == 3)
-			vstore3(currElResultMatrix.s012, 0, resultMatrix + (currRow * colQuantity + currCol * vecWidth));
-	}
+__kernel void matrixMultiplication(
+									__global const elemType* firstMatrix,
+									__global const elemType* secondMatrix,
+									__global resultType* resultMatrix,
+									unsigned int colFirstRowSecond,
+									const unsigned int colQuantity,
+									const unsigned int rowQuantity,
+									unsigned int normalColRow,
+									const unsigned int firstLeadingDim,
+									const unsigned int secondLeadingDim,
+									const unsigned int resultLeadingDim
+									epilogueArgs)
+{
+	// The third dimension selects the pair of a batch; each matrix of a batch takes its stored rows times its leading dimension.
+	// With splitK it selects a slice of normalColRow tiles of K instead, and the partial products are stored one after another
+	const size_t batch = get_global_id(2);
+#ifdef splitK
+	const unsigned int sliceStart = batch * normalColRow * LSIZE;
+	firstMatrix += firstIndex(0, sliceStart);
+	secondMatrix += secondIndex(sliceStart, 0);
+	colFirstRowSecond -= sliceStart;
+	normalColRow = min(normalColRow, (colFirstRowSecond + LSIZE - 1) / LSIZE);
+#else
+	firstMatrix += batch * firstStoredRows * firstLeadingDim;
+	secondMatrix += batch * secondStoredRows * secondLeadingDim;
+#endif
+	resultMatrix += batch * rowQuantity * resultLeadingDim;
+
+	const unsigned int currCol = get_global_id(0);
+	const unsigned int currRow = get_global_id(1);
+
+	const unsigned char currLocalCol = get_local_id(0);
+	const unsigned char currLocalRow = get_local_id(1);
+
+	floatType currElResultMatrix = (floatType)(0);
+
+	__local accType localFM[LSIZE][LSIZE + 1];
+	__local accType localSM[LSIZE][LSIZE + 1];
+
+	// Every work-item loads vecWidth consecutive elements of a stored row of each tile; for a transposed matrix they run
+	// across the tile's rows, so they are spread over local memory one by one
+	const unsigned int tileRow = get_group_id(1) * LSIZE;
+	const unsigned int tileCol = get_group_id(0) * LSIZE;
+	const unsigned int currLocalVec = currLocalCol * vecWidth;
+	accType currElems[vecWidth];
+
+	for(unsigned int i = 0; i < normalColRow; i++)
+	{
+		unsigned int currLSIZE = i * LSIZE;
+
+#ifdef firstTransposed
+		const unsigned int currRowFM = tileRow + currLocalVec;
+		const unsigned int currKFM = currLSIZE + currLocalRow;
+
+		if(currKFM < colFirstRowSecond && currRowFM + vecWidth - 1 < rowQuantity)
+		{
+			vectorStore(globalVectorLoad(0, firstMatrix + firstIndex(currRowFM, currKFM)), 0, currElems);
+		}
+		else
+		{
+			for(unsigned int m = 0; m < vecWidth; m++)
+				currElems[m] = currKFM < colFirstRowSecond && currRowFM + m < rowQuantity ? elementLoad(firstIndex(currRowFM + m, currKFM), firstMatrix) : 0;
+		}
+
+		for(unsigned int m = 0; m < vecWidth; m++)
+			localFM[currLocalVec + m][currLocalRow] = currElems[m];
+#else
+		const unsigned int currRowFM = tileRow + currLocalRow;
+		const unsigned int currKFM = currLSIZE + currLocalVec;
+
+		if(currRowFM < rowQuantity && currKFM + vecWidth - 1 < colFirstRowSecond)
+		{
+			vectorStore(globalVectorLoad(0, firstMatrix + firstIndex(currRowFM, currKFM)), 0, &localFM[currLocalRow][currLocalVec]);
+		}
+		else
+		{
+			for(unsigned int m = 0; m < vecWidth; m++)
+			{
+				if(currRowFM < rowQuantity && currKFM + m < colFirstRowSecond)
+					localFM[currLocalRow][currLocalVec + m] = elementLoad(firstIndex(currRowFM, currKFM + m), firstMatrix);
+				else
+					localFM[currLocalRow][currLocalVec + m] = 0;
+			}
+		}
+#endif
+
+#ifdef secondTransposed
+		const unsigned int currColSM = tileCol + currLocalRow;
+		const unsigned int currKSM = currLSIZE + currLocalVec;
+
+		if(currColSM < colQuantity && currKSM + vecWidth - 1 < colFirstRowSecond)
+		{
+			vectorStore(globalVectorLoad(0, secondMatrix + secondIndex(currKSM, currColSM)), 0, currElems);
+		}
+		else
+		{
+			for(unsigned int m = 0; m < vecWidth; m++)
+				currElems[m] = currColSM < colQuantity && currKSM + m < colFirstRowSecond ? elementLoad(secondIndex(currKSM + m, currColSM), secondMatrix) : 0;
+		}
+
+		for(unsigned int m = 0; m < vecWidth; m++)
+			localSM[currLocalVec + m][currLocalRow] = currElems[m];
+#else
+		const unsigned int currColSM = tileCol + currLocalVec;
+		const unsigned int currKSM = currLSIZE + currLocalRow;
+
+		if(currKSM < colFirstRowSecond && currColSM + vecWidth - 1 < colQuantity)
+		{
+			vectorStore(globalVectorLoad(0, secondMatrix + secondIndex(currKSM, currColSM)), 0, &localSM[currLocalRow][currLocalVec]);
+		}
+		else
+		{
+			for(unsigned int m = 0; m < vecWidth; m++)
+			{
+				if(currKSM < colFirstRowSecond && currColSM + m < colQuantity)
+					localSM[currLocalRow][currLocalVec + m] = elementLoad(secondIndex(currKSM, currColSM + m), secondMatrix);
+				else
+					localSM[currLocalRow][currLocalVec + m] = 0;
+			}
+		}
+#endif
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for(unsigned int j = 0; j < LSIZE; j++)
+			currElResultMatrix += localFM[currLocalRow][j] * vectorLoad(0, &localSM[j][currLocalCol * vecWidth]);
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if(currRow < rowQuantity && (currCol * vecWidth + vecWidth - 1) < colQuantity)
+	{
+		const unsigned int currOffset = resultIndex(currRow, currCol * vecWidth);
+		globalVectorStore(vectorEpilogueApplying(currElResultMatrix, currOffset, currCol * vecWidth), 0, resultMatrix + currOffset);
+	}
+	else if(currRow < rowQuantity)
+	{
+		accType currElemsResultMatrix[vecWidth];
+		vectorStore(currElResultMatrix, 0, currElemsResultMatrix);
+
+		for(unsigned int m = 0; m < vecWidth && currCol * vecWidth + m < colQuantity; m++)
+		{
+			const unsigned int currOffset = resultIndex(currRow, currCol * vecWidth + m);
+			elementStore(epilogueApplying(currElemsResultMatrix[m], currOffset, currCol * vecWidth + m), currOffset, resultMatrix);
+		}
+	}
 }
\ No newline at end of file
@@ -1,957 +1,818 @@
-﻿#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-
-#ifdef __APPLE__
-#include <OpenCL/cl.h>
-#else
-#include <CL/cl.h>
-#pragma comment(lib, "opencl.lib")
-#endif
-
-#define CL_TARGET_OPENCL_VERSION 120
-
-struct sizes
-{
-	unsigned int rowFirstMatrix;
-	unsigned int colSecondMatrix;
-	unsigned int colFirstRowSecond;
-	unsigned int firstMatrix;
-	unsigned int secondMatrix;
-	unsigned int resultMatrix;
-};
-
-struct deviceInfo
-{
-	cl_device_id ID;
-	cl_device_type type;
-	cl_bool hostUnifiedMem;
-	cl_uint sortID;
-};
-
-void errCodeOutput(cl_int errCode, char* errLog)
-{
-	fprintf(stderr, "Error code %d. The method that caused this is '%s'.\n", errCode, errLog);
-}
-
-unsigned char matrixSizing(FILE* inputFile, struct sizes* size)
-{
-	if (fscanf(inputFile, "%u ", &size->colSecondMatrix) < 1)
-		return 1;
-
-	if (fscanf(inputFile, "%u ", &size->colFirstRowSecond) < 1)
-		return 1;
-
-	if (fscanf(inputFile, "%u\n", &size->rowFirstMatrix) < 1)
-		return 1;
-
-	size->firstMatrix = size->rowFirstMatrix * size->colFirstRowSecond;
-	size->secondMatrix = size->colFirstRowSecond * size->colSecondMatrix;
-	size->resultMatrix = size->rowFirstMatrix * size->colSecondMatrix;
-
-	return 0;
-}
-
-unsigned char readFile(FILE* inputFile, float* firstMatrix, float* secondMatrix, struct sizes* size)
-{
-	for (unsigned int i = 0; i < size->firstMatrix; i++)
-	{
-		if (fscanf(inputFile, "%f", &firstMatrix[i]) <= 0)
-			return 1;
-	}
-
-	for (unsigned int i = 0; i < size->colFirstRowSecond; i++)
-	{
-		for (unsigned int j = 0; j < size->colSecondMatrix; j++)
-		{
-			if (fscanf(inputFile, "%f", &secondMatrix[j * size->colFirstRowSecond + i]) <= 0)
-				return 1;
-		}
-	}
-
-	return 0;
-}
-
-unsigned char writeFile(FILE* outputFile, float* matrix, struct sizes* size)
-{
-	if (fprintf(outputFile, "%u %u\n", size->colSecondMatrix, size->rowFirstMatrix) < 0)
-		return 1;
-
-	for (unsigned int i = 0; i < size->rowFirstMatrix; i++)
-	{
-		unsigned int currLine = size->colSecondMatrix * i;
-
-		for (unsigned int j = 0; j < size->colSecondMatrix; j++)
-		{
-			unsigned int currElIndex = currLine + j;
-
-			if (fprintf(outputFile, "%f ", matrix[currElIndex]) < 0)
-				return 1;
-		}
-
-		if (fprintf(outputFile, "\n") < 0)
-			return 1;
-	}
-
-	return 0;
-}
-
-unsigned char getDeviceNameAndMaxLocalGroupSize(cl_device_id device, size_t* maxLocalGroupSize, const int implementationType)
-{
-	cl_int errCodeReturn = CL_SUCCESS;
-	size_t deviceNameSize = 0;
-
-	errCodeReturn = clGetDeviceInfo(device, CL_DEVICE_NAME, 0, NULL, &deviceNameSize);
-	if (errCodeReturn != CL_SUCCESS)
-	{
-		errCodeOutput(errCodeReturn, "clGetDeviceInfo");
-		return 1;
-	}
-
-	char* deviceName = (char*)malloc(sizeof(char) * deviceNameSize);
-	if (deviceName == NULL)
-	{
-		fprintf(stderr, "Insufficient memory available!\n");
-		free(deviceName);
-		return 1;
-	}
-
-	errCodeReturn = clGetDeviceInfo(device, CL_DEVICE_NAME, deviceNameSize, deviceName, 0);
-	if (errCodeReturn != CL_SUCCESS)
-	{
-		errCodeOutput(errCodeReturn, "clGetDeviceInfo");
-		free(deviceName);
-		return 1;
-	}
-
-	if (implementationType != 1)
-	{
-		errCodeReturn = clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(maxLocalGroupSize), maxLocalGroupSize, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clGetDeviceInfo");
-			free(deviceName);
-			return 1;
-		}
-
-		*maxLocalGroupSize = sqrt(*maxLocalGroupSize);
-
-		if (*maxLocalGroupSize > 32 && implementationType == 2)
-			*maxLocalGroupSize = 32;
-	}
-
-	printf("Device: %s\n", deviceName);
-
-	free(deviceName);
-	return 0;
-}
-
-unsigned char kernelFileProcessing(const char* kernelFilePath, size_t* kernelFileSize, unsigned char** kernelFileText)
-{
-	FILE* kernelFile = fopen(kernelFilePath, "rb");
-	if (kernelFile == NULL)
-		return 1;
-
-	fseek(kernelFile, 0L, SEEK_END);
-	*kernelFileSize = ftell(kernelFile);
-	rewind(kernelFile);
-
-	*kernelFileText = (unsigned char*)malloc(sizeof(unsigned char) * *kernelFileSize);
-
-	if (fread(*kernelFileText, sizeof(char), *kernelFileSize, kernelFile) != *kernelFileSize)
-		return 1;
-
-	fclose(kernelFile);
-	return 0;
-}
-
-cl_uint getDeviceNumber(cl_uint* platformNum)
-{
-	cl_int errCodeReturn = CL_SUCCESS;
-	cl_uint deviceNum = 0;
-
-	errCodeReturn = clGetPlatformIDs(0, NULL, platformNum);
-	if (errCodeReturn != CL_SUCCESS) { errCodeOutput(errCodeReturn, "clGetPlatformIDs"); return 0; }
-
-	if (!*platformNum)
-		return 0;
-
-	cl_platform_id* platformIDs = (cl_platform_id*)malloc(sizeof(cl_platform_id) * *platformNum);
-	if (platformIDs == NULL)
-	{
-		fprintf(stderr, "Insufficient memory available!\n");
-		free(platformIDs);
-		return 0;
-	}
-
-	errCodeReturn = clGetPlatformIDs(*platformNum, platformIDs, NULL);
-	if (errCodeReturn != CL_SUCCESS)
-	{
-		errCodeOutput(errCodeReturn, "clGetPlatformIDs");
-		free(platformIDs);
-		return 0;
-	}
-
-	for (cl_uint i = 0; i < *platformNum; i++)
-	{
-		cl_uint platformDeviceNum = 0;
-		errCodeReturn = clGetDeviceIDs(platformIDs[i], CL_DEVICE_TYPE_ALL, 0, NULL, &platformDeviceNum);
-		//if (errCodeReturn != CL_SUCCESS && errCodeReturn != -1)
-		//{
-		//	errCodeOutput(errCodeReturn, "clGetDeviceIDs");
-		//	free(platformIDs);
-		//	return 0;
-		//}
-
-		deviceNum += platformDeviceNum;
-	}
-
-	free(platformIDs);
-	return deviceNum;
-}
-
-unsigned char getDeviceInfo(struct deviceInfo* devices, cl_uint deviceNum, cl_uint platformNum)
-{
-	cl_int errCodeReturn = CL_SUCCESS;
-
-	cl_platform_id* platformIDs = (cl_platform_id*)malloc(sizeof(cl_platform_id) * platformNum);
-	if (platformIDs == NULL)
-	{
-		fprintf(stderr, "Insufficient memory available!\n");
-		free(platformIDs);
-		return 0;
-	}
-
-	errCodeReturn = clGetPlatformIDs(platformNum, platformIDs, NULL);
-	if (errCodeReturn != CL_SUCCESS)
-	{
-		errCodeOutput(errCodeReturn, "clGetPlatformIDs");
-		free(platformIDs);
-		return 0;
-	}
-
-	cl_uint currDeviceNum = 0;
-
-	for (cl_uint i = 0; i < platformNum; i++)
-	{
-		cl_uint platformDeviceNum;
-		errCodeReturn = clGetDeviceIDs(platformIDs[i], CL_DEVICE_TYPE_ALL, 0, NULL, &platformDeviceNum);
-		if (errCodeReturn != CL_SUCCESS && errCodeReturn != -1)
-		{
-			errCodeOutput(errCodeReturn, "clGetDeviceIDs");
-			free(platformIDs);
-			return 0;
-		}
-
-		if (!platformDeviceNum)
-			continue;
-
-		cl_device_id* deviceIDs = (cl_device_id*)malloc(sizeof(cl_device_id) * platformDeviceNum);
-		if (deviceIDs == NULL)
-		{
-			fprintf(stderr, "Insufficient memory available!\n");
-			free(platformIDs);
-			free(deviceIDs);
-			return 0;
-		}
-
-		errCodeReturn = clGetDeviceIDs(platformIDs[i], CL_DEVICE_TYPE_ALL, platformDeviceNum, deviceIDs, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clGetDeviceIDs");
-			free(platformIDs);
-			free(deviceIDs);
-			return 0;
-		}
-
-		for (cl_uint d = 0; d < platformDeviceNum; d++)
-		{
-			devices[currDeviceNum].ID = deviceIDs[d];
-
-			errCodeReturn = clGetDeviceInfo(deviceIDs[d], CL_DEVICE_TYPE, sizeof(cl_device_type), &devices[currDeviceNum].type, NULL);
-			if (errCodeReturn != CL_SUCCESS)
-			{
-				errCodeOutput(errCodeReturn, "clGetDeviceInfo");
-				free(platformIDs);
-				free(deviceIDs);
-				return 0;
-			}
-
-			errCodeReturn = clGetDeviceInfo(deviceIDs[d], CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &devices[currDeviceNum].hostUnifiedMem, NULL);
-			if (errCodeReturn != CL_SUCCESS)
-			{
-				errCodeOutput(errCodeReturn, "clGetDeviceInfo");
-				free(platformIDs);
-				free(deviceIDs);
-				return 0;
-			}
-
-			currDeviceNum++;
-		}
-
-		free(deviceIDs);
-	}
-
-	free(platformIDs);
-	return 0;
-}
-
-void deviceSorting(struct deviceInfo* devices, cl_uint deviceNum)
-{
-	cl_uint currDeviceNum = 0;
-
-	for (cl_uint i = 0; i < deviceNum; i++)
-	{
-		if (devices[i].type == CL_DEVICE_TYPE_GPU) {
-			if (devices[i].hostUnifiedMem == 0)
-			{
-				devices[i].sortID = currDeviceNum;
-				currDeviceNum++;
-			}
-		}
-	}
-
-	for (cl_uint i = 0; i < deviceNum; i++)
-	{
-		if (devices[i].type == CL_DEVICE_TYPE_GPU) {
-			if (devices[i].hostUnifiedMem == 1)
-			{
-				devices[i].sortID = currDeviceNum;
-				currDeviceNum++;
-			}
-		}
-	}
-
-	for (cl_uint i = 0; i < deviceNum; i++)
-	{
-		if (devices[i].type == CL_DEVICE_TYPE_CPU)
-		{
-			devices[i].sortID = currDeviceNum;
-			currDeviceNum++;
-		}
-	}
-
-	for (cl_uint i = 0; i < deviceNum; i++)
-	{
-		if (devices[i].type != CL_DEVICE_TYPE_GPU && devices[i].type != CL_DEVICE_TYPE_CPU)
-		{
-			devices[i].sortID = currDeviceNum;
-			currDeviceNum++;
-		}
-	}
-}
-
-void deviceSelection(struct deviceInfo* devices, cl_uint deviceNum, cl_device_id* device, unsigned int selectedDeviceID)
-{
-	for (cl_uint i = 0; i < deviceNum; i++)
-	{
-		if (devices[i].sortID == selectedDeviceID)
-			*device = devices[i].ID;
-	}
-}
-
-unsigned char buildDefCreation(const char* buildDef, char** buildDefStr, size_t vectorWidth, size_t maxLocalGroupSize)
-{
-	unsigned int buildDefSize = snprintf(NULL, 0, buildDef, maxLocalGroupSize, vectorWidth, vectorWidth) + 1;
-	*buildDefStr = (char*)malloc(sizeof(char) * buildDefSize + 1);
-	if (*buildDefStr == NULL)
-	{
-		fprintf(stderr, "Insufficient memory available!\n");
-		return 1;
-	}
-
-	if (snprintf(*buildDefStr, buildDefSize, buildDef, maxLocalGroupSize, vectorWidth, vectorWidth) + 1 != buildDefSize)
-	{
-		fprintf(stderr, "Failed to form build definitions string!\n");
-		return 1;
-	}
-
-	return 0;
-}
-
-unsigned int dimensionAlignment(unsigned int dim, size_t maxLocalGroupSize)
-{
-	unsigned int alignedDim = (dim / maxLocalGroupSize) * maxLocalGroupSize;
-	if (alignedDim < dim)
-		alignedDim += maxLocalGroupSize;
-
-	return alignedDim;
-}
-
-int main(int argc, char* argv[])
-{
-	if (argc == 5)
-	{
-		int selectedDeviceID = atoi(argv[1]);
-		const int implementationType = atoi(argv[4]);
-
-		if (1 > implementationType || implementationType > 3)
-		{
-			fprintf(stderr, "Incorrect implementation type!\n");
-			return 1;
-		}
-
-		FILE* inputFile = fopen(argv[2], "r");
-		if (inputFile == NULL)
-		{
-			fprintf(stderr, "Input file open error!\n");
-			return 1;
-		}
-
-		cl_uint platformNum;
-		cl_uint deviceNum = getDeviceNumber(&platformNum);
-		if (!deviceNum)
-		{
-			fprintf(stderr, "Number of devices: 0\n");
-			fclose(inputFile);
-			return 1;
-		}
-
-		if (0 > selectedDeviceID || selectedDeviceID >= deviceNum)
-			selectedDeviceID = 0;
-
-		struct deviceInfo* devices = (struct deviceInfo*)malloc(sizeof(struct deviceInfo) * deviceNum);
-		if (devices == NULL)
-		{
-			fprintf(stderr, "Insufficient memory available!\n");
-			fclose(inputFile);
-			free(devices);
-			return 1;
-		}
-
-		if (getDeviceInfo(devices, deviceNum, platformNum))
-		{
-			fprintf(stderr, "Number of devices: 0\n");
-			fclose(inputFile);
-			free(devices);
-			return 1;
-		}
-
-		deviceSorting(devices, deviceNum);
-
-		cl_device_id device;
-		deviceSelection(devices, deviceNum, &device, selectedDeviceID);
-
-		free(devices);
-
-		size_t maxLocalGroupSize = 1;
-		if (getDeviceNameAndMaxLocalGroupSize(device, &maxLocalGroupSize, implementationType))
-		{
-			fclose(inputFile);
-			return 1;
-		}
-
-		struct sizes size;
-		if (matrixSizing(inputFile, &size))
-		{
-			fprintf(stderr, "Invalid matrix sizes!\n");
-			fclose(inputFile);
-			return 1;
-		}
-
-		float* firstMatrix = (float*)malloc(sizeof(float) * size.firstMatrix);
-		if (firstMatrix == NULL)
-		{
-			fprintf(stderr, "Insufficient memory available!\n");
-			free(firstMatrix);
-			fclose(inputFile);
-			return 1;
-		}
-
-		float* secondMatrix = (float*)malloc(sizeof(float) * size.secondMatrix);
-		if (secondMatrix == NULL)
-		{
-			fprintf(stderr, "Insufficient memory available!\n");
-			free(firstMatrix);
-			free(secondMatrix);
-			fclose(inputFile);
-			return 1;
-		}
-
-		if (readFile(inputFile, firstMatrix, secondMatrix, &size))
-		{
-			fprintf(stderr, "Invalid file format!\n");
-			free(firstMatrix);
-			free(secondMatrix);
-			fclose(inputFile);
-			return 1;
-		}
-
-		fclose(inputFile);
-
-		size_t kernelFileSize;
-		unsigned char* kernelFileText;
-
-		char* kernelFilePath = "kernel.cl";
-
-		if (implementationType == 2)
-			kernelFilePath = "kernelLocalMem.cl";
-
-		if (implementationType == 3)
-			kernelFilePath = "kernelVector.cl";
-
-		if (kernelFileProcessing(kernelFilePath, &kernelFileSize, &kernelFileText))
-		{
-			fprintf(stderr, "Kernel file open error!\n");
-			free(firstMatrix);
-			free(secondMatrix);
-			return 1;
-		}
-
-		cl_int errCodeReturn = CL_SUCCESS;
-		cl_context context = clCreateContext(NULL, 1, &device, NULL, NULL, &errCodeReturn);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clCreateContext");
-			free(firstMatrix);
-			free(secondMatrix);
-			return 1;
-		}
-
-		cl_command_queue queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &errCodeReturn);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clCreateCommandQueue");
-			free(firstMatrix);
-			free(secondMatrix);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		cl_program program = clCreateProgramWithSource(context, 1, (const char**)&kernelFileText, &kernelFileSize, &errCodeReturn);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clCreateProgramWithSource");
-			free(firstMatrix);
-			free(secondMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		size_t vectorWidth = 1;
-		if (implementationType == 3)
-			vectorWidth = 4;
-
-		const char buildDef[] = "-D LSIZE=%uU -D vecWidth=%zu -D floatType=float%zu";
-		char* buildDefStr;
-		if (buildDefCreation(buildDef, &buildDefStr, vectorWidth, maxLocalGroupSize))
-		{
-			free(firstMatrix);
-			free(secondMatrix);
-			free(buildDefStr);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clBuildProgram(program, 1, &device, buildDefStr, NULL, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			size_t errLogSize;
-			errCodeReturn = clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &errLogSize);
-			if (errCodeReturn != CL_SUCCESS)
-			{
-				errCodeOutput(errCodeReturn, "clGetProgramBuildInfo");
-				free(firstMatrix);
-				free(secondMatrix);
-				free(buildDefStr);
-				clFlush(queue);
-				clFinish(queue);
-				clReleaseProgram(program);
-				clReleaseCommandQueue(queue);
-				clReleaseContext(context);
-				return 1;
-			}
-
-			unsigned char* errLog = (unsigned char*)malloc(sizeof(char) * errLogSize);
-			if (errLog == NULL)
-			{
-				fprintf(stderr, "Insufficient memory available!\n");
-				free(firstMatrix);
-				free(secondMatrix);
-				free(buildDefStr);
-				free(errLog);
-				clFlush(queue);
-				clFinish(queue);
-				clReleaseProgram(program);
-				clReleaseCommandQueue(queue);
-				clReleaseContext(context);
-				return 1;
-			}
-
-			errCodeReturn = clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, errLogSize, errLog, NULL);
-			if (errCodeReturn != CL_SUCCESS)
-			{
-				errCodeOutput(errCodeReturn, "clGetProgramBuildInfo");
-				free(firstMatrix);
-				free(secondMatrix);
-				free(buildDefStr);
-				free(errLog);
-				clFlush(queue);
-				clFinish(queue);
-				clReleaseProgram(program);
-				clReleaseCommandQueue(queue);
-				clReleaseContext(context);
-				return 1;
-			}
-
-			fprintf(stderr, "Build log: %s\n", errLog);
-			free(firstMatrix);
-			free(secondMatrix);
-			free(buildDefStr);
-			free(errLog);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		free(buildDefStr);
-
-		cl_kernel kernel = clCreateKernel(program, "matrixMultiplication", &errCodeReturn);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "matrixMultiplication");
-			free(firstMatrix);
-			free(secondMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		float* resultMatrix = (float*)malloc(sizeof(float) * size.resultMatrix);
-		if (resultMatrix == NULL)
-		{
-			fprintf(stderr, "Insufficient memory available!\n");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		unsigned int alignedRowSize = dimensionAlignment(size.rowFirstMatrix, maxLocalGroupSize);
-		unsigned int alignedColSize = dimensionAlignment(size.colSecondMatrix, maxLocalGroupSize);
-		unsigned int alignedColRowSize = dimensionAlignment(size.colFirstRowSecond, maxLocalGroupSize);
-
-		unsigned int alignedfirstMatrixSize = alignedRowSize * alignedColRowSize;
-		unsigned int alignedSecondMatrixSize = alignedColRowSize * alignedColSize;
-		unsigned int alignedResultMatrixSize = alignedRowSize * alignedColSize;
-
-		alignedColRowSize /= maxLocalGroupSize;
-
-		cl_mem firstMatrixMem = clCreateBuffer(context, CL_MEM_READ_ONLY, (size_t)(alignedfirstMatrixSize * sizeof(float)), NULL, &errCodeReturn);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clCreateBuffer");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		cl_mem secondMatrixMem = clCreateBuffer(context, CL_MEM_READ_ONLY, (size_t)(alignedSecondMatrixSize * sizeof(float)), NULL, &errCodeReturn);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clCreateBuffer");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseMemObject(firstMatrixMem);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		cl_mem resultMatrixMem = clCreateBuffer(context, CL_MEM_WRITE_ONLY, (size_t)(alignedResultMatrixSize * sizeof(float)), NULL, &errCodeReturn);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clCreateBuffer");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseMemObject(firstMatrixMem);
-			clReleaseMemObject(secondMatrixMem);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		const cl_uint work_dim = 2;
-		size_t global_item_size[2];
-		const size_t local_item_size[2] = { maxLocalGroupSize / vectorWidth, maxLocalGroupSize };
-
-		if (implementationType == 1)
-		{
-			global_item_size[0] = size.colSecondMatrix; 
-			global_item_size[1] = size.rowFirstMatrix;
-		}
-		else
-		{
-			global_item_size[0] = alignedColSize / vectorWidth;
-			global_item_size[1] = alignedRowSize;
-		}
-
-		cl_event event_start_transfer, event_end_transfer;
-
-		errCodeReturn = clEnqueueWriteBuffer(queue, firstMatrixMem, CL_FALSE, 0, (size_t)(size.firstMatrix * sizeof(float)), firstMatrix, 0, NULL, &event_start_transfer);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseMemObject(firstMatrixMem);
-			clReleaseMemObject(secondMatrixMem);
-			clReleaseMemObject(resultMatrixMem);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clEnqueueWriteBuffer(queue, secondMatrixMem, CL_TRUE, 0, (size_t)(size.secondMatrix * sizeof(float)), secondMatrix, 0, NULL, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseMemObject(firstMatrixMem);
-			clReleaseMemObject(secondMatrixMem);
-			clReleaseMemObject(resultMatrixMem);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clSetKernelArg(kernel, 0, sizeof(cl_mem), &firstMatrixMem);
-		errCodeReturn = clSetKernelArg(kernel, 1, sizeof(cl_mem), &secondMatrixMem);
-		errCodeReturn = clSetKernelArg(kernel, 2, sizeof(cl_mem), &resultMatrixMem);
-		errCodeReturn = clSetKernelArg(kernel, 3, sizeof(cl_uint), &size.colFirstRowSecond);
-		errCodeReturn = clSetKernelArg(kernel, 4, sizeof(cl_uint), &size.colSecondMatrix);
-
-		if (implementationType != 1)
-		{
-			errCodeReturn = clSetKernelArg(kernel, 5, sizeof(cl_uint), &size.rowFirstMatrix);
-			errCodeReturn = clSetKernelArg(kernel, 6, sizeof(cl_uint), &alignedColRowSize);
-		}
-
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clSetKernelArg");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseMemObject(firstMatrixMem);
-			clReleaseMemObject(secondMatrixMem);
-			clReleaseMemObject(resultMatrixMem);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		cl_event event_kernel;
-		cl_ulong kernel_start_time, kernel_end_time;
-		cl_ulong transfer_start_time, transfer_end_time;
-
-		if (implementationType == 1)
-			errCodeReturn = clEnqueueNDRangeKernel(queue, kernel, work_dim, NULL, global_item_size, NULL, 0, NULL, &event_kernel);
-		else
-			errCodeReturn = clEnqueueNDRangeKernel(queue, kernel, work_dim, NULL, global_item_size, local_item_size, 0, NULL, &event_kernel);
-
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseMemObject(firstMatrixMem);
-			clReleaseMemObject(secondMatrixMem);
-			clReleaseMemObject(resultMatrixMem);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clEnqueueReadBuffer(queue, resultMatrixMem, CL_TRUE, 0, sizeof(float) * size.resultMatrix, resultMatrix, 0, NULL, &event_end_transfer);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clEnqueueReadBuffer");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseMemObject(firstMatrixMem);
-			clReleaseMemObject(secondMatrixMem);
-			clReleaseMemObject(resultMatrixMem);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clReleaseMemObject(firstMatrixMem);
-		errCodeReturn = clReleaseMemObject(secondMatrixMem);
-		errCodeReturn = clReleaseMemObject(resultMatrixMem);
-
-		errCodeReturn = clGetEventProfilingInfo(event_kernel, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start_time, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clGetEventProfilingInfo(event_kernel, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end_time, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clGetEventProfilingInfo(event_start_transfer, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &transfer_start_time, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clGetEventProfilingInfo(event_end_transfer, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &transfer_end_time, NULL);
-		if (errCodeReturn != CL_SUCCESS)
-		{
-			errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
-			free(firstMatrix);
-			free(secondMatrix);
-			free(resultMatrix);
-			clFlush(queue);
-			clFinish(queue);
-			clReleaseKernel(kernel);
-			clReleaseProgram(program);
-			clReleaseCommandQueue(queue);
-			clReleaseContext(context);
-			return 1;
-		}
-
-		errCodeReturn = clFlush(queue);
-		errCodeReturn = clFinish(queue);
-		errCodeReturn = clReleaseKernel(kernel);
-		errCodeReturn = clReleaseProgram(program);
-		errCodeReturn = clReleaseCommandQueue(queue);
-		errCodeReturn = clReleaseContext(context);
-
-		free(firstMatrix);
-		free(secondMatrix);
-
-		double kernel_runtime = (kernel_end_time - kernel_start_time) / 1000000.0;
-		double transfer_runtime = (transfer_end_time - transfer_start_time) / 1000000.0;
-
-		printf("Time: %g\t%g\n", kernel_runtime, transfer_runtime);
-
-		if (implementationType == 2)
-			printf("LOCAL_WORK_SIZE[%i, %i]\n", maxLocalGroupSize, maxLocalGroupSize);
-
-		if (implementationType == 3)
-		{
-			printf("LOCAL_WORK_SIZE[%i, %i]\n", maxLocalGroupSize, maxLocalGroupSize / (int)vectorWidth);
-			printf("WI_WORK %i\n", (int)vectorWidth);
-		}
-
-		FILE* outputFile = fopen(argv[3], "wb");
-		if (outputFile == NULL)
-		{
-			fprintf(stderr, "Output file open error!\n");
-			free(resultMatrix);
-			return 1;
-		}
-
-		if (writeFile(outputFile, resultMatrix, &size))
-		{
-			fprintf(stderr, "File write error!\n");
-			free(resultMatrix);
-			fclose(outputFile);
-			return 1;
-		}
-
-		fclose(outputFile);
-		free(resultMatrix);
-	}
-	else
-	{
-		fprintf(stderr, "Wrong number of arguments!\n");
-		return 1;
-	}
-}
+﻿#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "matmul.h"
+#include "matrixIO.h"
+#include "streaming.h"
+#include "multiDevice.h"
+#include "benchmark.h"
+
+// Reads both matrices of an input file into host allocations; inputBinary tells how the result is to be written
+unsigned char jobInputReading(const char* inputFilePath, float** firstMatrix, float** secondMatrix, struct sizes* size, unsigned char* inputBinary)
+{
+	FILE* inputFile = fopen(inputFilePath, "rb");
+	if (inputFile == NULL)
+	{
+		fprintf(stderr, "Input file open error!\n");
+		return 1;
+	}
+
+	*inputBinary = isBinaryFile(inputFile);
+	unsigned int inputKind = BINARY_KIND_INPUT;
+
+	if (*inputBinary ? binaryMatrixSizing(inputFile, size, &inputKind) || inputKind != BINARY_KIND_INPUT : matrixSizing(inputFile, size))
+	{
+		fprintf(stderr, "Invalid matrix sizes!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	*firstMatrix = matmulHostAllocation(size->firstMatrix);
+	if (*firstMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	*secondMatrix = matmulHostAllocation(size->secondMatrix);
+	if (*secondMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		matmulHostRelease(*firstMatrix);
+		fclose(inputFile);
+		return 1;
+	}
+
+	if (*inputBinary ? readBinaryFile(inputFile, *firstMatrix, *secondMatrix, size) : readFileParallel(inputFile, *firstMatrix, *secondMatrix, size))
+	{
+		fprintf(stderr, "Invalid file format!\n");
+		matmulHostRelease(*firstMatrix);
+		matmulHostRelease(*secondMatrix);
+		fclose(inputFile);
+		return 1;
+	}
+
+	fclose(inputFile);
+	return 0;
+}
+
+unsigned char jobResultWriting(const char* outputFilePath, float* resultMatrix, struct sizes* size, unsigned char inputBinary)
+{
+	FILE* outputFile = fopen(outputFilePath, "wb");
+	if (outputFile == NULL)
+	{
+		fprintf(stderr, "Output file open error!\n");
+		return 1;
+	}
+
+	if (inputBinary ? writeBinaryFile(outputFile, resultMatrix, size) : writeFileParallel(outputFile, resultMatrix, size))
+	{
+		fprintf(stderr, "File write error!\n");
+		fclose(outputFile);
+		return 1;
+	}
+
+	fclose(outputFile);
+	return 0;
+}
+
+// Double and int8 jobs read and write text files of their own type; the binary container only holds float32 matrices
+unsigned char typedJobProcessing(struct matmulContext* ctx, const char* inputFilePath, const char* outputFilePath, const struct matmulOptions* options,
+	struct matmulTiming* timing)
+{
+	const unsigned int inputType = options->elementType == ELEMENT_TYPE_DOUBLE ? VALUE_TYPE_DOUBLE : VALUE_TYPE_CHAR;
+	const unsigned int resultType = options->elementType == ELEMENT_TYPE_DOUBLE ? VALUE_TYPE_DOUBLE : VALUE_TYPE_INT;
+
+	FILE* inputFile = fopen(inputFilePath, "rb");
+	if (inputFile == NULL)
+	{
+		fprintf(stderr, "Input file open error!\n");
+		return 1;
+	}
+
+	if (isBinaryFile(inputFile))
+	{
+		fprintf(stderr, "Double and int8 matrices are only read from text files!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	struct sizes size;
+	if (matrixSizing(inputFile, &size))
+	{
+		fprintf(stderr, "Invalid matrix sizes!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	// Host allocations are counted in floats
+	const size_t typeSize = elementSize(options->elementType);
+	const size_t resultTypeSize = resultElementSize(options->elementType);
+
+	void* firstMatrix = matmulHostAllocation((size.firstMatrix * typeSize + sizeof(float) - 1) / sizeof(float));
+	void* secondMatrix = matmulHostAllocation((size.secondMatrix * typeSize + sizeof(float) - 1) / sizeof(float));
+	void* resultMatrix = matmulHostAllocation((size.resultMatrix * resultTypeSize + sizeof(float) - 1) / sizeof(float));
+
+	if (firstMatrix == NULL || secondMatrix == NULL || resultMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		matmulHostRelease(firstMatrix);
+		matmulHostRelease(secondMatrix);
+		matmulHostRelease(resultMatrix);
+		fclose(inputFile);
+		return 1;
+	}
+
+	unsigned char errCode = readTypedFile(inputFile, inputType, firstMatrix, secondMatrix, &size);
+	fclose(inputFile);
+
+	if (errCode)
+		fprintf(stderr, "Invalid file format!\n");
+
+	errCode = errCode || matmulTypedBatched(ctx, firstMatrix, secondMatrix, resultMatrix, size.rowFirstMatrix, size.colSecondMatrix, size.colFirstRowSecond,
+		size.batchNum, options, timing);
+
+	matmulHostRelease(firstMatrix);
+	matmulHostRelease(secondMatrix);
+
+	if (!errCode)
+	{
+		FILE* outputFile = fopen(outputFilePath, "wb");
+		if (outputFile == NULL)
+		{
+			fprintf(stderr, "Output file open error!\n");
+			errCode = 1;
+		}
+		else
+		{
+			if (writeTypedFile(outputFile, resultType, resultMatrix, &size))
+			{
+				fprintf(stderr, "File write error!\n");
+				errCode = 1;
+			}
+
+			fclose(outputFile);
+		}
+	}
+
+	matmulHostRelease(resultMatrix);
+	return errCode;
+}
+
+// Sparse files keep the first matrix in CSR form, which is multiplied by the sparse kernel whatever its density
+unsigned char sparseJobProcessing(struct matmulContext* ctx, const char* inputFilePath, const char* outputFilePath, const struct matmulOptions* options,
+	struct matmulTiming* timing)
+{
+	FILE* inputFile = fopen(inputFilePath, "rb");
+	if (inputFile == NULL)
+	{
+		fprintf(stderr, "Input file open error!\n");
+		return 1;
+	}
+
+	struct sizes size;
+	unsigned int nonZeroNum;
+
+	if (sparseMatrixSizing(inputFile, &size, &nonZeroNum))
+	{
+		fprintf(stderr, "Invalid matrix sizes!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	struct csrMatrix firstMatrix = { size.rowFirstMatrix, size.colFirstRowSecond, NULL, NULL, NULL };
+	firstMatrix.rowPointers = (unsigned int*)malloc(sizeof(unsigned int) * ((size_t)size.rowFirstMatrix + 1));
+	firstMatrix.colIndices = (unsigned int*)malloc(sizeof(unsigned int) * (nonZeroNum ? nonZeroNum : 1));
+	firstMatrix.values = (float*)malloc(sizeof(float) * (nonZeroNum ? nonZeroNum : 1));
+
+	float* secondMatrix = matmulHostAllocation(size.secondMatrix);
+	float* resultMatrix = matmulHostAllocation(size.resultMatrix);
+
+	if (firstMatrix.rowPointers == NULL || firstMatrix.colIndices == NULL || firstMatrix.values == NULL || secondMatrix == NULL || resultMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		csrRelease(&firstMatrix);
+		matmulHostRelease(secondMatrix);
+		matmulHostRelease(resultMatrix);
+		fclose(inputFile);
+		return 1;
+	}
+
+	unsigned char errCode = readSparseFile(inputFile, firstMatrix.rowPointers, firstMatrix.colIndices, firstMatrix.values, secondMatrix, &size, nonZeroNum);
+	fclose(inputFile);
+
+	if (errCode)
+		fprintf(stderr, "Invalid file format!\n");
+
+	errCode = errCode || matmulSparse(ctx, &firstMatrix, secondMatrix, resultMatrix, size.colSecondMatrix, options, timing);
+
+	csrRelease(&firstMatrix);
+	matmulHostRelease(secondMatrix);
+
+	errCode = errCode || jobResultWriting(outputFilePath, resultMatrix, &size, 0);
+
+	matmulHostRelease(resultMatrix);
+	return errCode;
+}
+
+// Element type of a "half", "double" or "int8" argument, -1 for anything else
+int elementTypeParsing(const char* elementTypeName)
+{
+	if (!strcmp(elementTypeName, "half"))
+		return ELEMENT_TYPE_HALF;
+
+	if (!strcmp(elementTypeName, "double"))
+		return ELEMENT_TYPE_DOUBLE;
+
+	if (!strcmp(elementTypeName, "int8"))
+		return ELEMENT_TYPE_INT8;
+
+	return -1;
+}
+
+// Results computed from half matrices or by the Strassen-Winograd recursion are checked against the plain float product,
+// whose error is then given in maxAbsError and maxRelError
+unsigned char jobProcessing(struct matmulContext* ctx, const char* inputFilePath, const char* outputFilePath, const struct matmulOptions* options, struct matmulTiming* timing,
+	double* maxAbsError, double* maxRelError)
+{
+	*maxAbsError = 0.0;
+	*maxRelError = 0.0;
+
+	FILE* inputFile = fopen(inputFilePath, "rb");
+	const unsigned char inputSparse = inputFile != NULL && isSparseFile(inputFile);
+
+	if (inputFile != NULL)
+		fclose(inputFile);
+
+	if (inputSparse)
+		return sparseJobProcessing(ctx, inputFilePath, outputFilePath, options, timing);
+
+	if (options->elementType == ELEMENT_TYPE_DOUBLE || options->elementType == ELEMENT_TYPE_INT8)
+		return typedJobProcessing(ctx, inputFilePath, outputFilePath, options, timing);
+
+	float* firstMatrix;
+	float* secondMatrix;
+	struct sizes size;
+	unsigned char inputBinary;
+
+	if (jobInputReading(inputFilePath, &firstMatrix, &secondMatrix, &size, &inputBinary))
+		return 1;
+
+	float* resultMatrix = matmulHostAllocation(size.resultMatrix);
+	if (resultMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		matmulHostRelease(firstMatrix);
+		matmulHostRelease(secondMatrix);
+		return 1;
+	}
+
+	// Binary files may hold the second matrix transposed
+	struct matmulOptions jobOptions = *options;
+	jobOptions.layout = size.secondTransposed ? LAYOUT_SECOND_TRANSPOSED : 0;
+
+	unsigned char errCode = matmulBatched(ctx, firstMatrix, secondMatrix, resultMatrix, size.rowFirstMatrix, size.colSecondMatrix, size.colFirstRowSecond, size.batchNum,
+		&jobOptions, timing);
+
+	if (!errCode && (options->elementType != ELEMENT_TYPE_FLOAT || options->strassen) && !matmulDeviceNative(ctx))
+	{
+		float* referenceMatrix = matmulHostAllocation(size.resultMatrix);
+		if (referenceMatrix == NULL)
+		{
+			fprintf(stderr, "Insufficient memory available!\n");
+			errCode = 1;
+		}
+		else
+		{
+			struct matmulOptions referenceOptions = jobOptions;
+			referenceOptions.elementType = ELEMENT_TYPE_FLOAT;
+			referenceOptions.strassen = 0;
+
+			errCode = matmulBatched(ctx, firstMatrix, secondMatrix, referenceMatrix, size.rowFirstMatrix, size.colSecondMatrix, size.colFirstRowSecond, size.batchNum,
+				&referenceOptions, NULL);
+
+			if (!errCode)
+				resultErrorCalculation(resultMatrix, referenceMatrix, size.resultMatrix, maxAbsError, maxRelError);
+
+			matmulHostRelease(referenceMatrix);
+		}
+	}
+
+	matmulHostRelease(firstMatrix);
+	matmulHostRelease(secondMatrix);
+
+	errCode = errCode || jobResultWriting(outputFilePath, resultMatrix, &size, inputBinary);
+
+	matmulHostRelease(resultMatrix);
+	return errCode;
+}
+
+// One job per line: "<input file> <output file> <operating mode>", answered with
+// "OK <kernel time> <transfer time>" or "ERR <reason>"; "half" after the mode keeps the matrices as half on the device and
+// adds the largest absolute and relative error against the float result to the answer, "double" and "int8" multiply typed text files. "stats" reports the buffer pool, "quit" stops the server
+unsigned char jobStreamProcessing(struct matmulContext* ctx, FILE* jobInput, FILE* jobOutput)
+{
+	char jobLine[4096];
+	char inputFilePath[2048];
+	char outputFilePath[2048];
+
+	while (fgets(jobLine, sizeof(jobLine), jobInput) != NULL)
+	{
+		// The commands are whole words, so input files whose names start with them are still jobs
+		char command[8] = "";
+		sscanf(jobLine, "%7s", command);
+
+		if (!strcmp(command, "quit"))
+			return 1;
+
+		if (!strcmp(command, "stats"))
+		{
+			struct bufferPoolStats stats;
+			matmulMemoryInfo(ctx, &stats);
+
+			fprintf(jobOutput, "OK %zu %zu %zu %zu %llu %llu %llu\n", stats.allocatedBytes, stats.inUseBytes, stats.highWaterMark, stats.memoryCap,
+				stats.allocationNum, stats.reuseNum, stats.evictionNum);
+			fflush(jobOutput);
+			continue;
+		}
+
+		struct matmulOptions options;
+		struct matmulTiming timing;
+		double maxAbsError, maxRelError;
+		char elementTypeName[16] = "float";
+		options.layout = 0;
+		options.leadingDims = NULL;
+		options.pipelined = 0;
+		options.strassen = 0;
+		options.exactKernel = 0;
+		options.epilogue = NULL;
+
+		int fieldNum = sscanf(jobLine, "%2047s %2047s %d %15s", inputFilePath, outputFilePath, &options.implementationType, elementTypeName);
+		options.elementType = fieldNum == 4 ? elementTypeParsing(elementTypeName) : ELEMENT_TYPE_FLOAT;
+
+		if (fieldNum < 3 || options.elementType < 0)
+			fprintf(jobOutput, "ERR Wrong job format\n");
+		else if (1 > options.implementationType || options.implementationType > IMPLEMENTATION_TYPE_NUM)
+			fprintf(jobOutput, "ERR Incorrect implementation type\n");
+		else if (jobProcessing(ctx, inputFilePath, outputFilePath, &options, &timing, &maxAbsError, &maxRelError))
+			fprintf(jobOutput, "ERR Job failed\n");
+		else if (options.elementType == ELEMENT_TYPE_HALF)
+			fprintf(jobOutput, "OK %g\t%g\t%g\t%g\n", timing.kernelTime, timing.transferTime, maxAbsError, maxRelError);
+		else
+			fprintf(jobOutput, "OK %g\t%g\n", timing.kernelTime, timing.transferTime);
+
+		fflush(jobOutput);
+	}
+
+	return 0;
+}
+
+unsigned char serverMode(int selectedDeviceID, const char* socketPath)
+{
+	struct matmulContext* ctx;
+	if (matmulCreate(&ctx, selectedDeviceID))
+		return 1;
+
+	fprintf(stderr, "Device: %s\n", matmulDeviceName(ctx));
+
+	if (socketPath == NULL)
+	{
+		jobStreamProcessing(ctx, stdin, stdout);
+		matmulRelease(ctx);
+		return 0;
+	}
+
+#ifdef _WIN32
+	fprintf(stderr, "Unix sockets are not supported on this platform!\n");
+	matmulRelease(ctx);
+	return 1;
+#else
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr, "Socket path is too long!\n");
+		matmulRelease(ctx);
+		return 1;
+	}
+
+	strcpy(address.sun_path, socketPath);
+	signal(SIGPIPE, SIG_IGN);
+
+	int serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (serverSocket < 0)
+	{
+		fprintf(stderr, "Socket creation error!\n");
+		matmulRelease(ctx);
+		return 1;
+	}
+
+	unlink(socketPath);
+
+	if (bind(serverSocket, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(serverSocket, 16) != 0)
+	{
+		fprintf(stderr, "Socket bind error!\n");
+		close(serverSocket);
+		matmulRelease(ctx);
+		return 1;
+	}
+
+	unsigned char quit = 0;
+
+	while (!quit)
+	{
+		int clientSocket = accept(serverSocket, NULL, NULL);
+		if (clientSocket < 0)
+			continue;
+
+		FILE* jobInput = fdopen(clientSocket, "r");
+		FILE* jobOutput = fdopen(dup(clientSocket), "w");
+
+		if (jobInput != NULL && jobOutput != NULL)
+			quit = jobStreamProcessing(ctx, jobInput, jobOutput);
+
+		if (jobInput != NULL)
+			fclose(jobInput);
+		else
+			close(clientSocket);
+
+		if (jobOutput != NULL)
+			fclose(jobOutput);
+	}
+
+	close(serverSocket);
+	unlink(socketPath);
+	matmulRelease(ctx);
+	return 0;
+#endif
+}
+
+// Shapes are given as "NxKxM" like the names of the test files
+unsigned char tuningMode(int selectedDeviceID, int implementationType, char** shapes, int shapeNum)
+{
+	if (1 > implementationType || implementationType > IMPLEMENTATION_TYPE_NUM)
+	{
+		fprintf(stderr, "Incorrect implementation type!\n");
+		return 1;
+	}
+
+	struct matmulContext* ctx;
+	if (matmulCreate(&ctx, selectedDeviceID))
+		return 1;
+
+	printf("Device: %s\n", matmulDeviceName(ctx));
+
+	for (int i = 0; i < shapeNum; i++)
+	{
+		unsigned int colSecondMatrix, colFirstRowSecond, rowFirstMatrix;
+		if (sscanf(shapes[i], "%ux%ux%u", &colSecondMatrix, &colFirstRowSecond, &rowFirstMatrix) != 3 || !colSecondMatrix || !colFirstRowSecond || !rowFirstMatrix)
+		{
+			fprintf(stderr, "Invalid matrix sizes!\n");
+			matmulRelease(ctx);
+			return 1;
+		}
+
+		printf("Shape: %ux%ux%u\n", colSecondMatrix, colFirstRowSecond, rowFirstMatrix);
+
+		struct kernelParams bestParams;
+		double bestTime;
+		if (matmulTuning(ctx, implementationType, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, &bestParams, &bestTime))
+		{
+			matmulRelease(ctx);
+			return 1;
+		}
+
+		printf("Best: LSIZE %zu vecWidth %zu TM %zu TN %zu: %g\n", bestParams.localGroupSize, bestParams.vectorWidth, bestParams.tileRows, bestParams.tileCols, bestTime);
+	}
+
+	matmulRelease(ctx);
+	return 0;
+}
+
+// Host memory for the streamed blocks is given in megabytes
+unsigned char streamMode(int selectedDeviceID, const char* inputFilePath, const char* outputFilePath, int implementationType, const char* hostMemLimit)
+{
+	struct matmulOptions options;
+	options.implementationType = implementationType;
+	options.elementType = ELEMENT_TYPE_FLOAT;
+	options.layout = 0;
+	options.leadingDims = NULL;
+	options.pipelined = 0;
+	options.strassen = 0;
+	options.exactKernel = 0;
+	options.epilogue = NULL;
+
+	if (1 > options.implementationType || options.implementationType > IMPLEMENTATION_TYPE_NUM)
+	{
+		fprintf(stderr, "Incorrect implementation type!\n");
+		return 1;
+	}
+
+	unsigned long long hostMemSize = hostMemLimit != NULL ? strtoull(hostMemLimit, NULL, 10) : STREAM_HOST_MEMORY_DEFAULT;
+	if (!hostMemSize)
+	{
+		fprintf(stderr, "Incorrect host memory limit!\n");
+		return 1;
+	}
+
+	struct matmulContext* ctx;
+	if (matmulCreate(&ctx, selectedDeviceID))
+		return 1;
+
+	printf("Device: %s\n", matmulDeviceName(ctx));
+
+	struct matmulTiming timing;
+	if (streamProcessing(ctx, inputFilePath, outputFilePath, &options, hostMemSize << 20, &timing))
+	{
+		matmulRelease(ctx);
+		return 1;
+	}
+
+	printf("Time: %g\t%g\n", timing.kernelTime, timing.transferTime);
+
+	matmulRelease(ctx);
+	return 0;
+}
+
+// Sub-devices per CPU split them further, so the scheduler also has something to balance on a single CPU
+unsigned char multiMode(const char* inputFilePath, const char* outputFilePath, int implementationType, const char* subDeviceLimit)
+{
+	struct matmulOptions options;
+	options.implementationType = implementationType;
+	options.elementType = ELEMENT_TYPE_FLOAT;
+	options.layout = 0;
+	options.leadingDims = NULL;
+	options.pipelined = 0;
+	options.strassen = 0;
+	options.exactKernel = 0;
+	options.epilogue = NULL;
+
+	if (1 > options.implementationType || options.implementationType > IMPLEMENTATION_TYPE_NUM)
+	{
+		fprintf(stderr, "Incorrect implementation type!\n");
+		return 1;
+	}
+
+	const int subDeviceNum = subDeviceLimit != NULL ? atoi(subDeviceLimit) : 1;
+	if (subDeviceNum < 1)
+	{
+		fprintf(stderr, "Incorrect number of sub-devices!\n");
+		return 1;
+	}
+
+	struct deviceWorker* workers;
+	size_t workerNum;
+	if (deviceWorkersCreation(&workers, &workerNum, (unsigned int)subDeviceNum))
+		return 1;
+
+	float* firstMatrix;
+	float* secondMatrix;
+	struct sizes size;
+	unsigned char inputBinary;
+
+	if (jobInputReading(inputFilePath, &firstMatrix, &secondMatrix, &size, &inputBinary))
+	{
+		deviceWorkersRelease(workers, workerNum);
+		return 1;
+	}
+
+	if (size.batchNum > 1)
+	{
+		fprintf(stderr, "Batches cannot be split across devices!\n");
+		matmulHostRelease(firstMatrix);
+		matmulHostRelease(secondMatrix);
+		deviceWorkersRelease(workers, workerNum);
+		return 1;
+	}
+
+	float* resultMatrix = matmulHostAllocation(size.resultMatrix);
+	if (resultMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		matmulHostRelease(firstMatrix);
+		matmulHostRelease(secondMatrix);
+		deviceWorkersRelease(workers, workerNum);
+		return 1;
+	}
+
+	options.layout = size.secondTransposed ? LAYOUT_SECOND_TRANSPOSED : 0;
+
+	struct matmulTiming timing;
+	const double startTime = wallTime();
+
+	unsigned char errCode = multiDeviceProcessing(workers, workerNum, firstMatrix, secondMatrix, resultMatrix,
+		size.rowFirstMatrix, size.colSecondMatrix, size.colFirstRowSecond, &options, &timing);
+
+	const double elapsedTime = (wallTime() - startTime) * 1000.0;
+
+	matmulHostRelease(firstMatrix);
+	matmulHostRelease(secondMatrix);
+
+	errCode = errCode || jobResultWriting(outputFilePath, resultMatrix, &size, inputBinary);
+	matmulHostRelease(resultMatrix);
+
+	if (!errCode)
+	{
+		for (size_t i = 0; i < workerNum; i++)
+			printf("Device %zu: %s: %u rows, %u panels, %u stolen, %g rows/ms\n", i, matmulDeviceName(workers[i].ctx),
+				workers[i].rowNum, workers[i].panelNum, workers[i].stolenNum, workers[i].throughput);
+
+		printf("Time: %g\t%g\t%g\n", timing.kernelTime, timing.transferTime, elapsedTime);
+	}
+
+	deviceWorkersRelease(workers, workerNum);
+	return errCode;
+}
+
+// The results go to stdout as CSV or JSON; an element type may come before the shape grids, float is used otherwise
+unsigned char benchmarkMode(const char* formatName, const char* repeatNumStr, char** grids, int gridNum)
+{
+	int format;
+	if (!strcmp(formatName, "csv"))
+		format = BENCHMARK_FORMAT_CSV;
+	else if (!strcmp(formatName, "json"))
+		format = BENCHMARK_FORMAT_JSON;
+	else
+	{
+		fprintf(stderr, "Incorrect output format!\n");
+		return 1;
+	}
+
+	const int repeatNum = atoi(repeatNumStr);
+	if (repeatNum < 1)
+	{
+		fprintf(stderr, "Incorrect number of repetitions!\n");
+		return 1;
+	}
+
+	int elementType = ELEMENT_TYPE_FLOAT;
+	if (gridNum > 1 && elementTypeParsing(grids[0]) >= 0)
+	{
+		elementType = elementTypeParsing(grids[0]);
+		grids++;
+		gridNum--;
+	}
+
+	struct benchmarkShape* shapes = NULL;
+	size_t shapeNum = 0;
+
+	for (int i = 0; i < gridNum; i++)
+	{
+		if (shapeGridParsing(grids[i], &shapes, &shapeNum))
+		{
+			fprintf(stderr, "Invalid matrix sizes!\n");
+			free(shapes);
+			return 1;
+		}
+	}
+
+	unsigned char errCode = benchmarkProcessing(shapes, shapeNum, elementType, (unsigned int)repeatNum, format);
+
+	free(shapes);
+	return errCode;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 4 && !strcmp(argv[1], "convert"))
+	{
+		return fileConversion(argv[2], argv[3]);
+	}
+	else if (argc == 3 && !strcmp(argv[1], "parse-bench"))
+	{
+		return parserBenchmark(argv[2]);
+	}
+	else if (argc == 3 && !strcmp(argv[1], "format-bench"))
+	{
+		return formatterBenchmark(argv[2]);
+	}
+	else if (argc >= 5 && !strcmp(argv[1], "tune"))
+	{
+		return tuningMode(atoi(argv[2]), atoi(argv[3]), argv + 4, argc - 4);
+	}
+	else if ((argc == 6 || argc == 7) && !strcmp(argv[1], "stream"))
+	{
+		return streamMode(atoi(argv[2]), argv[3], argv[4], atoi(argv[5]), argc == 7 ? argv[6] : NULL);
+	}
+	else if ((argc == 5 || argc == 6) && !strcmp(argv[1], "multi"))
+	{
+		return multiMode(argv[2], argv[3], atoi(argv[4]), argc == 6 ? argv[5] : NULL);
+	}
+	else if (argc >= 5 && !strcmp(argv[1], "benchmark"))
+	{
+		return benchmarkMode(argv[2], argv[3], argv + 4, argc - 4);
+	}
+	else if ((argc == 3 || argc == 4) && !strcmp(argv[1], "serve"))
+	{
+		return serverMode(atoi(argv[2]), argc == 4 ? argv[3] : NULL);
+	}
+	else if (argc >= 5 && argc <= 8)
+	{
+		// "pipeline" in front of the usual arguments overlaps transfers and kernels of row panels,
+		// "half" keeps the matrices as half on the device and reports the error against the float result,
+		// "double" and "int8" multiply text files of doubles or of integers from -128 to 127 into doubles or ints,
+		// "relu" and "gelu" apply the activation to the result in the kernel,
+		// "strassen" splits large products by the Strassen-Winograd recursion and reports the error against the plain kernel
+		char** args = argv + argc - 5;
+		struct matmulEpilogue epilogue = { 1.0, 0.0, NULL, ACTIVATION_NONE };
+
+		struct matmulOptions options;
+		options.implementationType = atoi(args[4]);
+		options.elementType = ELEMENT_TYPE_FLOAT;
+		options.layout = 0;
+		options.leadingDims = NULL;
+		options.pipelined = 0;
+		options.strassen = 0;
+		options.exactKernel = 0;
+		options.epilogue = NULL;
+
+		for (int i = 1; i < argc - 4; i++)
+		{
+			if (!strcmp(argv[i], "pipeline") && !options.pipelined)
+				options.pipelined = 1;
+			else if (!strcmp(argv[i], "strassen") && !options.strassen)
+				options.strassen = 1;
+			else if (elementTypeParsing(argv[i]) >= 0 && options.elementType == ELEMENT_TYPE_FLOAT)
+				options.elementType = elementTypeParsing(argv[i]);
+			else if (!strcmp(argv[i], "relu") && options.epilogue == NULL)
+			{
+				epilogue.activation = ACTIVATION_RELU;
+				options.epilogue = &epilogue;
+			}
+			else if (!strcmp(argv[i], "gelu") && options.epilogue == NULL)
+			{
+				epilogue.activation = ACTIVATION_GELU;
+				options.epilogue = &epilogue;
+			}
+			else
+			{
+				fprintf(stderr, "Wrong number of arguments!\n");
+				return 1;
+			}
+		}
+
+		if (1 > options.implementationType || options.implementationType > IMPLEMENTATION_TYPE_NUM)
+		{
+			fprintf(stderr, "Incorrect implementation type!\n");
+			return 1;
+		}
+
+		struct matmulContext* ctx;
+		if (matmulCreate(&ctx, atoi(args[1])))
+			return 1;
+
+		printf("Device: %s\n", matmulDeviceName(ctx));
+
+		struct matmulTiming timing;
+		double maxAbsError, maxRelError;
+		if (jobProcessing(ctx, args[2], args[3], &options, &timing, &maxAbsError, &maxRelError))
+		{
+			matmulRelease(ctx);
+			return 1;
+		}
+
+		printf("Time: %g\t%g\n", timing.kernelTime, timing.transferTime);
+
+		if ((options.elementType == ELEMENT_TYPE_HALF || options.strassen) && !matmulDeviceNative(ctx))
+			printf("Error: %g\t%g\n", maxAbsError, maxRelError);
+
+		const struct kernelParams params = timing.params;
+		const unsigned char native = matmulDeviceNative(ctx);
+
+		if (options.pipelined && !native)
+			printf("Overlap: %g\t%g%%\n", timing.overlapTime, timing.overlapTime / (timing.transferTime + timing.overlapTime) * 100.0);
+
+		if (options.implementationType == 2 && !native)
+			printf("LOCAL_WORK_SIZE[%i, %i]\n", (int)params.localGroupSize, (int)params.localGroupSize);
+
+		if (options.implementationType == 3 && !native)
+		{
+			printf("LOCAL_WORK_SIZE[%i, %i]\n", (int)params.localGroupSize, (int)(params.localGroupSize / params.vectorWidth));
+			printf("WI_WORK %i\n", (int)params.vectorWidth);
+		}
+
+		if (options.implementationType == 4 && !native)
+		{
+			printf("LOCAL_WORK_SIZE[%i, %i]\n", (int)params.localGroupSize, (int)params.localGroupSize);
+			printf("WI_WORK %i x %i\n", (int)params.tileRows, (int)params.tileCols);
+		}
+
+		matmulRelease(ctx);
+	}
+	else
+	{
+		fprintf(stderr, "Wrong number of arguments!\n");
+		return 1;
+	}
+}
@@ -0,0 +1,3444 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <malloc.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "matmul.h"
+#include "matrixIO.h"
+#include "bufferPool.h"
+#include "tuning.h"
+#include "cpuBackend.h"
+
+void errCodeOutput(cl_int errCode, char* errLog)
+{
+	fprintf(stderr, "Error code %d. The method that caused this is '%s'.\n", errCode, errLog);
+}
+
+unsigned char getMaxLocalGroupSize(cl_device_id device, size_t* maxLocalGroupSize, const int implementationType)
+{
+	cl_int errCodeReturn = CL_SUCCESS;
+
+	if (implementationType != 1)
+	{
+		errCodeReturn = clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(maxLocalGroupSize), maxLocalGroupSize, NULL);
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+			return 1;
+		}
+
+		// The sparse kernel's work-groups are SPARSE_LANE_NUM lanes of result columns
+		if (implementationType == IMPLEMENTATION_SPARSE)
+		{
+			*maxLocalGroupSize /= SPARSE_LANE_NUM;
+
+			if (*maxLocalGroupSize > SPARSE_COL_NUM)
+				*maxLocalGroupSize = SPARSE_COL_NUM;
+
+			return !*maxLocalGroupSize;
+		}
+
+		*maxLocalGroupSize = sqrt(*maxLocalGroupSize);
+
+		if (*maxLocalGroupSize > 32 && implementationType == 2)
+			*maxLocalGroupSize = 32;
+
+		// Keeps the two double-buffered tiles of each matrix within 32 KB of local memory
+		if (*maxLocalGroupSize > 16 && implementationType == 4)
+			*maxLocalGroupSize = 16;
+	}
+
+	return 0;
+}
+
+unsigned char kernelFileProcessing(const char* kernelFilePath, size_t* kernelFileSize, unsigned char** kernelFileText)
+{
+	FILE* kernelFile = fopen(kernelFilePath, "rb");
+	if (kernelFile == NULL)
+		return 1;
+
+	fseek(kernelFile, 0L, SEEK_END);
+	*kernelFileSize = ftell(kernelFile);
+	rewind(kernelFile);
+
+	*kernelFileText = (unsigned char*)malloc(sizeof(unsigned char) * *kernelFileSize);
+
+	if (fread(*kernelFileText, sizeof(char), *kernelFileSize, kernelFile) != *kernelFileSize)
+		return 1;
+
+	fclose(kernelFile);
+	return 0;
+}
+
+unsigned char deviceStringInfo(cl_device_id device, cl_device_info paramName, char** paramValue)
+{
+	size_t paramValueSize = 0;
+
+	cl_int errCodeReturn = clGetDeviceInfo(device, paramName, 0, NULL, &paramValueSize);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+		return 1;
+	}
+
+	*paramValue = (char*)malloc(sizeof(char) * (paramValueSize + 1));
+	if (*paramValue == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	errCodeReturn = clGetDeviceInfo(device, paramName, paramValueSize, *paramValue, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+		free(*paramValue);
+		*paramValue = NULL;
+		return 1;
+	}
+
+	(*paramValue)[paramValueSize] = '\0';
+	return 0;
+}
+
+unsigned char buildLogOutput(cl_program program, cl_device_id device)
+{
+	size_t errLogSize;
+	cl_int errCodeReturn = clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &errLogSize);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetProgramBuildInfo");
+		return 1;
+	}
+
+	unsigned char* errLog = (unsigned char*)malloc(sizeof(char) * errLogSize);
+	if (errLog == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	errCodeReturn = clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, errLogSize, errLog, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetProgramBuildInfo");
+		free(errLog);
+		return 1;
+	}
+
+	fprintf(stderr, "Build log: %s\n", errLog);
+	free(errLog);
+	return 0;
+}
+
+// The cache key names everything that can make a binary unusable: device, driver, OpenCL version,
+// kernel source and build options. It is stored in the cache file and compared in full on load
+unsigned char kernelCacheKeyCreation(cl_device_id device, const unsigned char* kernelFileText, size_t kernelFileSize, const char* buildDefStr, char** cacheKey, char** cacheFilePath)
+{
+	const char* cacheDir = getenv("MATMUL_KERNEL_CACHE");
+	if (cacheDir == NULL)
+		cacheDir = KERNEL_CACHE_DIR;
+
+	if (!*cacheDir)
+		return 1;
+
+	char* deviceName = NULL;
+	char* driverVersion = NULL;
+	char* deviceVersion = NULL;
+
+	if (deviceStringInfo(device, CL_DEVICE_NAME, &deviceName) || deviceStringInfo(device, CL_DRIVER_VERSION, &driverVersion) || deviceStringInfo(device, CL_DEVICE_VERSION, &deviceVersion))
+	{
+		free(deviceName);
+		free(driverVersion);
+		free(deviceVersion);
+		return 1;
+	}
+
+	const char keyDef[] = "device=%s\ndriver=%s\nversion=%s\noptions=%s\nsource=%016llx\n";
+	unsigned long long sourceHash = hashCalculation(kernelFileText, kernelFileSize, FNV_OFFSET_BASIS);
+
+	size_t cacheKeySize = snprintf(NULL, 0, keyDef, deviceName, driverVersion, deviceVersion, buildDefStr, sourceHash) + 1;
+	*cacheKey = (char*)malloc(sizeof(char) * cacheKeySize);
+	*cacheFilePath = (char*)malloc(sizeof(char) * (strlen(cacheDir) + 32));
+	if (*cacheKey == NULL || *cacheFilePath == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(deviceName);
+		free(driverVersion);
+		free(deviceVersion);
+		free(*cacheKey);
+		free(*cacheFilePath);
+		*cacheKey = NULL;
+		*cacheFilePath = NULL;
+		return 1;
+	}
+
+	snprintf(*cacheKey, cacheKeySize, keyDef, deviceName, driverVersion, deviceVersion, buildDefStr, sourceHash);
+	sprintf(*cacheFilePath, "%s/%016llx.bin", cacheDir, hashCalculation(*cacheKey, cacheKeySize - 1, FNV_OFFSET_BASIS));
+
+	free(deviceName);
+	free(driverVersion);
+	free(deviceVersion);
+	return 0;
+}
+
+unsigned char cachedProgramLoading(cl_context context, cl_device_id device, const char* cacheFilePath, const char* cacheKey, const char* buildDefStr, cl_program* program)
+{
+	FILE* cacheFile = fopen(cacheFilePath, "rb");
+	if (cacheFile == NULL)
+		return 1;
+
+	size_t fileSize;
+	const unsigned char* fileData = (const unsigned char*)mapFile(cacheFile, &fileSize);
+	fclose(cacheFile);
+
+	if (fileData == NULL)
+		return 1;
+
+	size_t cacheKeySize = strlen(cacheKey);
+	size_t headerSize = sizeof(KERNEL_CACHE_MAGIC) - 1 + 8 + cacheKeySize + 16;
+
+	unsigned char valid = fileSize >= headerSize && !memcmp(fileData, KERNEL_CACHE_MAGIC, sizeof(KERNEL_CACHE_MAGIC) - 1);
+	const unsigned char* curr = fileData + sizeof(KERNEL_CACHE_MAGIC) - 1;
+
+	valid = valid && loadLittleEndian(curr, 8) == cacheKeySize && !memcmp(curr + 8, cacheKey, cacheKeySize);
+	curr += 8 + cacheKeySize;
+
+	size_t binarySize = valid ? (size_t)loadLittleEndian(curr, 8) : 0;
+	valid = valid && binarySize && binarySize == fileSize - headerSize;
+	valid = valid && loadLittleEndian(curr + 8, 8) == hashCalculation(curr + 16, binarySize, FNV_OFFSET_BASIS);
+
+	if (!valid)
+	{
+		unmapFile((void*)fileData, fileSize);
+		remove(cacheFilePath);
+		return 1;
+	}
+
+	const unsigned char* binary = curr + 16;
+	cl_int binaryStatus = CL_SUCCESS;
+	cl_int errCodeReturn = CL_SUCCESS;
+
+	*program = clCreateProgramWithBinary(context, 1, &device, &binarySize, &binary, &binaryStatus, &errCodeReturn);
+	unmapFile((void*)fileData, fileSize);
+
+	if (errCodeReturn != CL_SUCCESS || binaryStatus != CL_SUCCESS)
+	{
+		if (errCodeReturn == CL_SUCCESS)
+			clReleaseProgram(*program);
+
+		fprintf(stderr, "Cached kernel binary rejected, rebuilding from source.\n");
+		remove(cacheFilePath);
+		return 1;
+	}
+
+	errCodeReturn = clBuildProgram(*program, 1, &device, buildDefStr, NULL, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		clReleaseProgram(*program);
+		fprintf(stderr, "Cached kernel binary rejected, rebuilding from source.\n");
+		remove(cacheFilePath);
+		return 1;
+	}
+
+	return 0;
+}
+
+// Contexts of one process may build the same kernel at the same time, e.g. on sub-devices of one CPU
+unsigned int cacheFileCounter = 0;
+
+// The binary is written to a temporary file and renamed, so concurrent runs never see a partial entry
+unsigned char cachedProgramSaving(cl_program program, const char* cacheFilePath, const char* cacheKey)
+{
+	size_t binarySize = 0;
+	cl_int errCodeReturn = clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, NULL);
+	if (errCodeReturn != CL_SUCCESS || !binarySize)
+		return 1;
+
+	size_t cacheKeySize = strlen(cacheKey);
+	size_t headerSize = sizeof(KERNEL_CACHE_MAGIC) - 1 + 8 + cacheKeySize + 16;
+
+	unsigned char* fileData = (unsigned char*)malloc(headerSize + binarySize);
+	if (fileData == NULL)
+		return 1;
+
+	unsigned char* binary = fileData + headerSize;
+	errCodeReturn = clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(unsigned char*), &binary, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		free(fileData);
+		return 1;
+	}
+
+	unsigned char* curr = fileData;
+	memcpy(curr, KERNEL_CACHE_MAGIC, sizeof(KERNEL_CACHE_MAGIC) - 1);
+	curr += sizeof(KERNEL_CACHE_MAGIC) - 1;
+	storeLittleEndian(curr, cacheKeySize, 8);
+	memcpy(curr + 8, cacheKey, cacheKeySize);
+	curr += 8 + cacheKeySize;
+	storeLittleEndian(curr, binarySize, 8);
+	storeLittleEndian(curr + 8, hashCalculation(binary, binarySize, FNV_OFFSET_BASIS), 8);
+
+	const char* cacheDir = getenv("MATMUL_KERNEL_CACHE");
+	if (cacheDir == NULL)
+		cacheDir = KERNEL_CACHE_DIR;
+
+#ifdef _WIN32
+	_mkdir(cacheDir);
+	int processID = _getpid();
+#else
+	mkdir(cacheDir, 0755);
+	int processID = (int)getpid();
+#endif
+
+	unsigned int fileNumber;
+#pragma omp atomic capture
+	fileNumber = cacheFileCounter++;
+
+	char* tmpFilePath = (char*)malloc(strlen(cacheFilePath) + 32);
+	if (tmpFilePath == NULL)
+	{
+		free(fileData);
+		return 1;
+	}
+
+	sprintf(tmpFilePath, "%s.%d.%u", cacheFilePath, processID, fileNumber);
+
+	FILE* tmpFile = fopen(tmpFilePath, "wb");
+	if (tmpFile == NULL)
+	{
+		free(fileData);
+		free(tmpFilePath);
+		return 1;
+	}
+
+	unsigned char errCode = fwrite(fileData, 1, headerSize + binarySize, tmpFile) != headerSize + binarySize;
+	errCode |= fclose(tmpFile) != 0;
+
+#ifdef _WIN32
+	if (!errCode)
+		remove(cacheFilePath);
+#endif
+
+	if (errCode || rename(tmpFilePath, cacheFilePath) != 0)
+	{
+		remove(tmpFilePath);
+		errCode = 1;
+	}
+
+	free(fileData);
+	free(tmpFilePath);
+	return errCode;
+}
+
+unsigned char programCreation(cl_context context, cl_device_id device, const unsigned char* kernelFileText, size_t kernelFileSize, const char* buildDefStr, cl_program* program)
+{
+	char* cacheKey = NULL;
+	char* cacheFilePath = NULL;
+
+	if (!kernelCacheKeyCreation(device, kernelFileText, kernelFileSize, buildDefStr, &cacheKey, &cacheFilePath))
+	{
+		if (!cachedProgramLoading(context, device, cacheFilePath, cacheKey, buildDefStr, program))
+		{
+			free(cacheKey);
+			free(cacheFilePath);
+			return 0;
+		}
+	}
+
+	cl_int errCodeReturn = CL_SUCCESS;
+	*program = clCreateProgramWithSource(context, 1, (const char**)&kernelFileText, &kernelFileSize, &errCodeReturn);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateProgramWithSource");
+		free(cacheKey);
+		free(cacheFilePath);
+		return 1;
+	}
+
+	errCodeReturn = clBuildProgram(*program, 1, &device, buildDefStr, NULL, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		buildLogOutput(*program, device);
+		clReleaseProgram(*program);
+		free(cacheKey);
+		free(cacheFilePath);
+		return 1;
+	}
+
+	if (cacheKey != NULL)
+		cachedProgramSaving(*program, cacheFilePath, cacheKey);
+
+	free(cacheKey);
+	free(cacheFilePath);
+	return 0;
+}
+
+cl_uint getDeviceNumber(cl_uint* platformNum)
+{
+	cl_int errCodeReturn = CL_SUCCESS;
+	cl_uint deviceNum = 0;
+
+	errCodeReturn = clGetPlatformIDs(0, NULL, platformNum);
+	if (errCodeReturn == PLATFORM_NOT_FOUND) { *platformNum = 0; return 0; }
+	if (errCodeReturn != CL_SUCCESS) { errCodeOutput(errCodeReturn, "clGetPlatformIDs"); return 0; }
+
+	if (!*platformNum)
+		return 0;
+
+	cl_platform_id* platformIDs = (cl_platform_id*)malloc(sizeof(cl_platform_id) * *platformNum);
+	if (platformIDs == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(platformIDs);
+		return 0;
+	}
+
+	errCodeReturn = clGetPlatformIDs(*platformNum, platformIDs, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetPlatformIDs");
+		free(platformIDs);
+		return 0;
+	}
+
+	for (cl_uint i = 0; i < *platformNum; i++)
+	{
+		cl_uint platformDeviceNum = 0;
+		errCodeReturn = clGetDeviceIDs(platformIDs[i], CL_DEVICE_TYPE_ALL, 0, NULL, &platformDeviceNum);
+		//if (errCodeReturn != CL_SUCCESS && errCodeReturn != -1)
+		//{
+		//	errCodeOutput(errCodeReturn, "clGetDeviceIDs");
+		//	free(platformIDs);
+		//	return 0;
+		//}
+
+		deviceNum += platformDeviceNum;
+	}
+
+	free(platformIDs);
+	return deviceNum;
+}
+
+unsigned char getDeviceInfo(struct deviceInfo* devices, cl_uint deviceNum, cl_uint platformNum)
+{
+	cl_int errCodeReturn = CL_SUCCESS;
+
+	cl_platform_id* platformIDs = (cl_platform_id*)malloc(sizeof(cl_platform_id) * platformNum);
+	if (platformIDs == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(platformIDs);
+		return 0;
+	}
+
+	errCodeReturn = clGetPlatformIDs(platformNum, platformIDs, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetPlatformIDs");
+		free(platformIDs);
+		return 0;
+	}
+
+	cl_uint currDeviceNum = 0;
+
+	for (cl_uint i = 0; i < platformNum; i++)
+	{
+		cl_uint platformDeviceNum;
+		errCodeReturn = clGetDeviceIDs(platformIDs[i], CL_DEVICE_TYPE_ALL, 0, NULL, &platformDeviceNum);
+		if (errCodeReturn != CL_SUCCESS && errCodeReturn != -1)
+		{
+			errCodeOutput(errCodeReturn, "clGetDeviceIDs");
+			free(platformIDs);
+			return 0;
+		}
+
+		if (!platformDeviceNum)
+			continue;
+
+		cl_device_id* deviceIDs = (cl_device_id*)malloc(sizeof(cl_device_id) * platformDeviceNum);
+		if (deviceIDs == NULL)
+		{
+			fprintf(stderr, "Insufficient memory available!\n");
+			free(platformIDs);
+			free(deviceIDs);
+			return 0;
+		}
+
+		errCodeReturn = clGetDeviceIDs(platformIDs[i], CL_DEVICE_TYPE_ALL, platformDeviceNum, deviceIDs, NULL);
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clGetDeviceIDs");
+			free(platformIDs);
+			free(deviceIDs);
+			return 0;
+		}
+
+		for (cl_uint d = 0; d < platformDeviceNum; d++)
+		{
+			devices[currDeviceNum].ID = deviceIDs[d];
+
+			errCodeReturn = clGetDeviceInfo(deviceIDs[d], CL_DEVICE_TYPE, sizeof(cl_device_type), &devices[currDeviceNum].type, NULL);
+			if (errCodeReturn != CL_SUCCESS)
+			{
+				errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+				free(platformIDs);
+				free(deviceIDs);
+				return 0;
+			}
+
+			errCodeReturn = clGetDeviceInfo(deviceIDs[d], CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &devices[currDeviceNum].hostUnifiedMem, NULL);
+			if (errCodeReturn != CL_SUCCESS)
+			{
+				errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+				free(platformIDs);
+				free(deviceIDs);
+				return 0;
+			}
+
+			currDeviceNum++;
+		}
+
+		free(deviceIDs);
+	}
+
+	free(platformIDs);
+	return 0;
+}
+
+void deviceSorting(struct deviceInfo* devices, cl_uint deviceNum)
+{
+	cl_uint currDeviceNum = 0;
+
+	for (cl_uint i = 0; i < deviceNum; i++)
+	{
+		if (devices[i].type == CL_DEVICE_TYPE_GPU) {
+			if (devices[i].hostUnifiedMem == 0)
+			{
+				devices[i].sortID = currDeviceNum;
+				currDeviceNum++;
+			}
+		}
+	}
+
+	for (cl_uint i = 0; i < deviceNum; i++)
+	{
+		if (devices[i].type == CL_DEVICE_TYPE_GPU) {
+			if (devices[i].hostUnifiedMem == 1)
+			{
+				devices[i].sortID = currDeviceNum;
+				currDeviceNum++;
+			}
+		}
+	}
+
+	for (cl_uint i = 0; i < deviceNum; i++)
+	{
+		if (devices[i].type == CL_DEVICE_TYPE_CPU)
+		{
+			devices[i].sortID = currDeviceNum;
+			currDeviceNum++;
+		}
+	}
+
+	for (cl_uint i = 0; i < deviceNum; i++)
+	{
+		if (devices[i].type != CL_DEVICE_TYPE_GPU && devices[i].type != CL_DEVICE_TYPE_CPU)
+		{
+			devices[i].sortID = currDeviceNum;
+			currDeviceNum++;
+		}
+	}
+}
+
+void deviceSelection(struct deviceInfo* devices, cl_uint deviceNum, cl_device_id* device, unsigned int selectedDeviceID)
+{
+	for (cl_uint i = 0; i < deviceNum; i++)
+	{
+		if (devices[i].sortID == selectedDeviceID)
+			*device = devices[i].ID;
+	}
+}
+
+unsigned char buildDefCreation(const char* buildDef, const char* typeDef, char** buildDefStr, const struct kernelParams* params)
+{
+	unsigned int buildDefSize = snprintf(NULL, 0, buildDef, params->localGroupSize, params->vectorWidth, params->tileRows, params->tileCols, typeDef) + 1;
+	*buildDefStr = (char*)malloc(sizeof(char) * buildDefSize + 1);
+	if (*buildDefStr == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	if (snprintf(*buildDefStr, buildDefSize, buildDef, params->localGroupSize, params->vectorWidth, params->tileRows, params->tileCols, typeDef) + 1 != buildDefSize)
+	{
+		fprintf(stderr, "Failed to form build definitions string!\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+// Kernels built with different epilogue definitions are told apart by this number, 0 for none
+int epilogueVariant(const struct matmulEpilogue* epilogue)
+{
+	if (epilogue == NULL)
+		return 0;
+
+	return 1 + (epilogue->bias != NULL) + 2 * epilogue->activation;
+}
+
+// alpha, beta and the bias buffer follow the kernel's own arguments from argIndex on, in the epilogue type of the kernel
+cl_int epilogueArgsSetting(cl_kernel kernel, cl_uint argIndex, int elementType, const struct matmulEpilogue* epilogue, const cl_mem* biasMem)
+{
+	cl_int errCodeReturn;
+
+	if (elementType == ELEMENT_TYPE_DOUBLE)
+	{
+		const cl_double alpha = epilogue->alpha, beta = epilogue->beta;
+		errCodeReturn = clSetKernelArg(kernel, argIndex, sizeof(cl_double), &alpha);
+		errCodeReturn |= clSetKernelArg(kernel, argIndex + 1, sizeof(cl_double), &beta);
+	}
+	else
+	{
+		const cl_float alpha = (cl_float)epilogue->alpha, beta = (cl_float)epilogue->beta;
+		errCodeReturn = clSetKernelArg(kernel, argIndex, sizeof(cl_float), &alpha);
+		errCodeReturn |= clSetKernelArg(kernel, argIndex + 1, sizeof(cl_float), &beta);
+	}
+
+	if (epilogue->bias != NULL)
+		errCodeReturn |= clSetKernelArg(kernel, argIndex + 2, sizeof(cl_mem), biasMem);
+
+	return errCodeReturn;
+}
+
+// Stored rows and row length of the first and the second matrix of a layout
+void storedShapes(unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, int layout,
+	unsigned int* firstShape, unsigned int* secondShape)
+{
+	firstShape[0] = layout & LAYOUT_FIRST_TRANSPOSED ? colFirstRowSecond : rowFirstMatrix;
+	firstShape[1] = layout & LAYOUT_FIRST_TRANSPOSED ? rowFirstMatrix : colFirstRowSecond;
+	secondShape[0] = layout & LAYOUT_SECOND_TRANSPOSED ? colSecondMatrix : colFirstRowSecond;
+	secondShape[1] = layout & LAYOUT_SECOND_TRANSPOSED ? colFirstRowSecond : colSecondMatrix;
+}
+
+// Packed row lengths stand in for missing leading dimensions; shorter ones would make stored rows overlap
+unsigned char leadingDimsResolving(unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, int layout,
+	const struct matmulLeadingDims* leadingDims, struct matmulLeadingDims* resolvedDims)
+{
+	unsigned int firstShape[2], secondShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, firstShape, secondShape);
+
+	resolvedDims->first = leadingDims != NULL ? leadingDims->first : firstShape[1];
+	resolvedDims->second = leadingDims != NULL ? leadingDims->second : secondShape[1];
+	resolvedDims->result = leadingDims != NULL ? leadingDims->result : colSecondMatrix;
+
+	return resolvedDims->first < firstShape[1] || resolvedDims->second < secondShape[1] || resolvedDims->result < colSecondMatrix;
+}
+
+// Uploads rowNum rows of rowLength elements that are leadingDim elements apart in matrix to rows bufferLeadingDim elements apart
+// in the buffer, in one contiguous write when both are packed
+cl_int matrixUploading(cl_command_queue queue, cl_mem mem, size_t bufferLeadingDim, const void* matrix, size_t leadingDim, size_t rowNum, size_t rowLength,
+	size_t typeSize, cl_uint waitEventNum, const cl_event* waitEvents, cl_event* event)
+{
+	if (leadingDim == rowLength && bufferLeadingDim == rowLength)
+		return clEnqueueWriteBuffer(queue, mem, CL_FALSE, 0, typeSize * rowNum * rowLength, matrix, waitEventNum, waitEvents, event);
+
+	const size_t origin[3] = { 0, 0, 0 };
+	const size_t region[3] = { typeSize * rowLength, rowNum, 1 };
+
+	return clEnqueueWriteBufferRect(queue, mem, CL_FALSE, origin, origin, region, typeSize * bufferLeadingDim, 0, typeSize * leadingDim, 0,
+		matrix, waitEventNum, waitEvents, event);
+}
+
+// matrixUploading the other way round; the host elements between the rows are left untouched
+cl_int matrixDownloading(cl_command_queue queue, cl_mem mem, size_t bufferLeadingDim, void* matrix, size_t leadingDim, size_t rowNum, size_t rowLength,
+	size_t typeSize, cl_bool blocking, cl_uint waitEventNum, const cl_event* waitEvents, cl_event* event)
+{
+	if (leadingDim == rowLength && bufferLeadingDim == rowLength)
+		return clEnqueueReadBuffer(queue, mem, blocking, 0, typeSize * rowNum * rowLength, matrix, waitEventNum, waitEvents, event);
+
+	const size_t origin[3] = { 0, 0, 0 };
+	const size_t region[3] = { typeSize * rowLength, rowNum, 1 };
+
+	return clEnqueueReadBufferRect(queue, mem, blocking, origin, origin, region, typeSize * bufferLeadingDim, 0, typeSize * leadingDim, 0,
+		matrix, waitEventNum, waitEvents, event);
+}
+
+// The leading dimensions of the first, second and result matrix follow the kernel's own arguments from argIndex on
+cl_int leadingDimsArgsSetting(cl_kernel kernel, cl_uint argIndex, const struct matmulLeadingDims* leadingDims)
+{
+	cl_int errCodeReturn = clSetKernelArg(kernel, argIndex, sizeof(cl_uint), &leadingDims->first);
+	errCodeReturn |= clSetKernelArg(kernel, argIndex + 1, sizeof(cl_uint), &leadingDims->second);
+	errCodeReturn |= clSetKernelArg(kernel, argIndex + 2, sizeof(cl_uint), &leadingDims->result);
+
+	return errCodeReturn;
+}
+
+unsigned int dimensionAlignment(unsigned int dim, size_t maxLocalGroupSize)
+{
+	unsigned int alignedDim = (dim / maxLocalGroupSize) * maxLocalGroupSize;
+	if (alignedDim < dim)
+		alignedDim += maxLocalGroupSize;
+
+	return alignedDim;
+}
+
+struct matmulKernel
+{
+	cl_program program;
+	cl_kernel kernel;
+	int implementationType;
+	int elementType;
+	int layout;
+	int variant;
+	int epilogueVariant;
+	struct kernelParams params;
+};
+
+struct matmulContext
+{
+	cl_device_id device;
+	cl_context context;
+	cl_command_queue queue;
+	cl_command_queue uploadQueue;
+	cl_command_queue downloadQueue;
+	char* deviceName;
+	char* deviceKey;
+	unsigned char native;
+	unsigned char zeroCopy;
+
+	struct matmulKernel* kernels;
+	size_t kernelNum;
+	size_t kernelCapacity;
+
+	struct tuningEntry* tuningEntries;
+	size_t tuningEntryNum;
+
+	struct bufferPool bufferPool;
+};
+
+unsigned char nativeContextCreation(struct matmulContext** ctx)
+{
+	*ctx = (struct matmulContext*)calloc(1, sizeof(struct matmulContext));
+	if (*ctx == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	const char nameDef[] = "Native CPU (%s, %d threads)";
+	size_t deviceNameSize = snprintf(NULL, 0, nameDef, CPU_SIMD_NAME, threadNumber()) + 1;
+
+	(*ctx)->native = 1;
+	(*ctx)->deviceName = (char*)malloc(sizeof(char) * deviceNameSize);
+	if ((*ctx)->deviceName == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	snprintf((*ctx)->deviceName, deviceNameSize, nameDef, CPU_SIMD_NAME, threadNumber());
+	return 0;
+}
+
+unsigned char matmulCreate(struct matmulContext** ctx, int selectedDeviceID)
+{
+	cl_uint platformNum = 0;
+	cl_uint deviceNum = getDeviceNumber(&platformNum);
+
+	// The native CPU backend is the device after the OpenCL ones, so it is device 0 on hosts without OpenCL devices
+	if (0 > selectedDeviceID || (cl_uint)selectedDeviceID > deviceNum)
+		selectedDeviceID = 0;
+
+	if ((cl_uint)selectedDeviceID == deviceNum)
+		return nativeContextCreation(ctx);
+
+	struct deviceInfo* devices = (struct deviceInfo*)malloc(sizeof(struct deviceInfo) * deviceNum);
+	if (devices == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	if (getDeviceInfo(devices, deviceNum, platformNum))
+	{
+		fprintf(stderr, "Number of devices: 0\n");
+		free(devices);
+		return 1;
+	}
+
+	deviceSorting(devices, deviceNum);
+
+	cl_device_id device = NULL;
+	deviceSelection(devices, deviceNum, &device, selectedDeviceID);
+	free(devices);
+
+	return matmulDeviceCreate(ctx, device);
+}
+
+// Everything matmulCreate sets up for a device that is already chosen, e.g. a sub-device of a CPU
+unsigned char matmulDeviceCreate(struct matmulContext** ctx, cl_device_id device)
+{
+	*ctx = (struct matmulContext*)calloc(1, sizeof(struct matmulContext));
+	if (*ctx == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	(*ctx)->device = device;
+
+	cl_bool hostUnifiedMem = CL_FALSE;
+	clGetDeviceInfo((*ctx)->device, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &hostUnifiedMem, NULL);
+
+	const char* zeroCopyStr = getenv(ZERO_COPY_ENV);
+	(*ctx)->zeroCopy = hostUnifiedMem == CL_TRUE && (zeroCopyStr == NULL || strcmp(zeroCopyStr, "0"));
+
+	if (deviceStringInfo((*ctx)->device, CL_DEVICE_NAME, &(*ctx)->deviceName))
+	{
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	char* driverVersion;
+	if (deviceStringInfo((*ctx)->device, CL_DRIVER_VERSION, &driverVersion))
+	{
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	// Tuning results are kept per device name and driver version
+	size_t deviceKeySize = strlen((*ctx)->deviceName) + strlen(driverVersion) + 2;
+	(*ctx)->deviceKey = (char*)malloc(sizeof(char) * deviceKeySize);
+	if ((*ctx)->deviceKey == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(driverVersion);
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	snprintf((*ctx)->deviceKey, deviceKeySize, "%s\t%s", (*ctx)->deviceName, driverVersion);
+	free(driverVersion);
+
+	if (tuningDatabaseLoading((*ctx)->deviceKey, &(*ctx)->tuningEntries, &(*ctx)->tuningEntryNum))
+	{
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	cl_int errCodeReturn = CL_SUCCESS;
+	(*ctx)->context = clCreateContext(NULL, 1, &(*ctx)->device, NULL, NULL, &errCodeReturn);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateContext");
+		(*ctx)->context = NULL;
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	(*ctx)->queue = clCreateCommandQueue((*ctx)->context, (*ctx)->device, CL_QUEUE_PROFILING_ENABLE, &errCodeReturn);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateCommandQueue");
+		(*ctx)->queue = NULL;
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	// Transfers of the pipelined mode get queues of their own so they can run beside the kernels
+	(*ctx)->uploadQueue = clCreateCommandQueue((*ctx)->context, (*ctx)->device, CL_QUEUE_PROFILING_ENABLE, &errCodeReturn);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateCommandQueue");
+		(*ctx)->uploadQueue = NULL;
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	(*ctx)->downloadQueue = clCreateCommandQueue((*ctx)->context, (*ctx)->device, CL_QUEUE_PROFILING_ENABLE, &errCodeReturn);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateCommandQueue");
+		(*ctx)->downloadQueue = NULL;
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	// Pooled buffer sizes are rounded to whole tiles of the largest local group
+	size_t maxLocalGroupSize = 1;
+	if (getMaxLocalGroupSize((*ctx)->device, &maxLocalGroupSize, 3))
+	{
+		matmulRelease(*ctx);
+		return 1;
+	}
+
+	size_t memoryCap = 0;
+	const char* memoryCapStr = getenv(MEMORY_CAP_ENV);
+	if (memoryCapStr != NULL)
+		memoryCap = (size_t)strtoull(memoryCapStr, NULL, 10) << 20;
+
+	bufferPoolInit(&(*ctx)->bufferPool, (*ctx)->context, sizeof(float) * maxLocalGroupSize * maxLocalGroupSize, memoryCap);
+
+	return 0;
+}
+
+void matmulRelease(struct matmulContext* ctx)
+{
+	if (ctx == NULL)
+		return;
+
+	cl_command_queue queues[3] = { ctx->queue, ctx->uploadQueue, ctx->downloadQueue };
+
+	for (size_t i = 0; i < 3; i++)
+	{
+		if (queues[i] != NULL)
+		{
+			clFlush(queues[i]);
+			clFinish(queues[i]);
+		}
+	}
+
+	for (size_t i = 0; i < ctx->kernelNum; i++)
+	{
+		clReleaseKernel(ctx->kernels[i].kernel);
+		clReleaseProgram(ctx->kernels[i].program);
+	}
+
+	free(ctx->kernels);
+	free(ctx->tuningEntries);
+
+	bufferPoolRelease(&ctx->bufferPool);
+
+	for (size_t i = 0; i < 3; i++)
+	{
+		if (queues[i] != NULL)
+			clReleaseCommandQueue(queues[i]);
+	}
+
+	if (ctx->context != NULL)
+		clReleaseContext(ctx->context);
+
+	free(ctx->deviceName);
+	free(ctx->deviceKey);
+	free(ctx);
+}
+
+const char* matmulDeviceName(const struct matmulContext* ctx)
+{
+	return ctx->deviceName;
+}
+
+unsigned char matmulDeviceNative(const struct matmulContext* ctx)
+{
+	return ctx->native;
+}
+
+// Largest single buffer and the memory the buffer pool may use on the device; unlimited for the native backend
+unsigned char matmulMemoryLimits(const struct matmulContext* ctx, unsigned long long* maxBufferSize, unsigned long long* deviceMemSize)
+{
+	*maxBufferSize = ~0ULL;
+	*deviceMemSize = ~0ULL;
+
+	if (ctx->native)
+		return 0;
+
+	cl_ulong maxAllocSize, globalMemSize;
+	cl_int errCodeReturn = clGetDeviceInfo(ctx->device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &maxAllocSize, NULL);
+	errCodeReturn |= clGetDeviceInfo(ctx->device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &globalMemSize, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+		return 1;
+	}
+
+	*maxBufferSize = maxAllocSize;
+	*deviceMemSize = globalMemSize;
+
+	if (ctx->bufferPool.memoryCap && ctx->bufferPool.memoryCap < *deviceMemSize)
+		*deviceMemSize = ctx->bufferPool.memoryCap;
+
+	return 0;
+}
+
+// The size is rounded up to whole alignment blocks as well, which is what drivers need to use host memory in place
+float* matmulHostAllocation(size_t count)
+{
+	size_t size = (sizeof(float) * count + HOST_BUFFER_ALIGNMENT - 1) / HOST_BUFFER_ALIGNMENT * HOST_BUFFER_ALIGNMENT;
+	if (!size)
+		size = HOST_BUFFER_ALIGNMENT;
+
+#ifdef _WIN32
+	return (float*)_aligned_malloc(size, HOST_BUFFER_ALIGNMENT);
+#else
+	void* matrix;
+	return posix_memalign(&matrix, HOST_BUFFER_ALIGNMENT, size) ? NULL : (float*)matrix;
+#endif
+}
+
+void matmulHostRelease(float* matrix)
+{
+#ifdef _WIN32
+	_aligned_free(matrix);
+#else
+	free(matrix);
+#endif
+}
+
+size_t elementSize(int elementType)
+{
+	switch (elementType)
+	{
+	case ELEMENT_TYPE_HALF:
+		return sizeof(cl_half);
+	case ELEMENT_TYPE_DOUBLE:
+		return sizeof(cl_double);
+	case ELEMENT_TYPE_INT8:
+		return sizeof(cl_char);
+	default:
+		return sizeof(cl_float);
+	}
+}
+
+// int8 products are summed and stored as int32, the other types keep their own
+size_t resultElementSize(int elementType)
+{
+	return elementType == ELEMENT_TYPE_INT8 ? sizeof(cl_int) : elementSize(elementType);
+}
+
+// Rounds to nearest even like vstore_half; values past the half range become infinities
+cl_half floatToHalf(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(float));
+
+	const unsigned int sign = (bits >> 16) & 0x8000;
+	const int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	unsigned int mantissa = bits & 0x7FFFFF;
+
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return (cl_half)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+	if (exponent >= 31)
+		return (cl_half)(sign | 0x7C00);
+
+	// Subnormal halves keep the implicit bit in the mantissa
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return (cl_half)sign;
+
+		mantissa |= 0x800000;
+		const unsigned int shift = 14 - exponent;
+		const unsigned int remainder = mantissa & ((1U << shift) - 1);
+		const unsigned int halfway = 1U << (shift - 1);
+
+		unsigned int halfBits = mantissa >> shift;
+		if (remainder > halfway || (remainder == halfway && (halfBits & 1)))
+			halfBits++;
+
+		return (cl_half)(sign | halfBits);
+	}
+
+	// A carry out of the mantissa moves on to the next exponent, or to infinity
+	unsigned int halfBits = sign | ((unsigned int)exponent << 10) | (mantissa >> 13);
+	const unsigned int remainder = mantissa & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (halfBits & 1)))
+		halfBits++;
+
+	return (cl_half)halfBits;
+}
+
+float halfToFloat(cl_half value)
+{
+	const unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+	const unsigned int exponent = (value >> 10) & 0x1F;
+	const unsigned int mantissa = value & 0x3FF;
+
+	unsigned int bits;
+	if (exponent == 0x1F)
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else if (exponent)
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	else
+	{
+		// Subnormal halves are exact multiples of 2^-24
+		float subnormal = mantissa / 16777216.0f;
+		memcpy(&bits, &subnormal, sizeof(float));
+		bits |= sign;
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(float));
+	return result;
+}
+
+void halfConversion(const float* matrix, cl_half* halfMatrix, size_t count)
+{
+#pragma omp parallel for
+	for (long long i = 0; i < (long long)count; i++)
+		halfMatrix[i] = floatToHalf(matrix[i]);
+}
+
+void floatConversion(const cl_half* halfMatrix, float* matrix, size_t count)
+{
+#pragma omp parallel for
+	for (long long i = 0; i < (long long)count; i++)
+		matrix[i] = halfToFloat(halfMatrix[i]);
+}
+
+// Packs rowNum rows of rowLength elements, leadingDim elements apart, into a half matrix
+void halfRowsConversion(const float* matrix, size_t leadingDim, cl_half* halfMatrix, size_t rowNum, size_t rowLength)
+{
+#pragma omp parallel for
+	for (long long i = 0; i < (long long)(rowNum * rowLength); i++)
+		halfMatrix[i] = floatToHalf(matrix[i / rowLength * leadingDim + i % rowLength]);
+}
+
+// halfRowsConversion the other way round; the elements between the rows are left untouched
+void floatRowsConversion(const cl_half* halfMatrix, float* matrix, size_t leadingDim, size_t rowNum, size_t rowLength)
+{
+#pragma omp parallel for
+	for (long long i = 0; i < (long long)(rowNum * rowLength); i++)
+		matrix[i / rowLength * leadingDim + i % rowLength] = halfToFloat(halfMatrix[i]);
+}
+
+// Nonzeros of a rowNum x colNum matrix whose element (row, col) is at row * rowStride + col * colStride. Rows are counted
+// in bands of about nonZeroLimit elements and the count stops at the first band that reaches the limit, so a dense matrix
+// costs one band; the count is only exact below the limit
+size_t nonZeroCounting(const float* matrix, unsigned int rowNum, unsigned int colNum, size_t rowStride, size_t colStride, size_t nonZeroLimit)
+{
+	size_t nonZeroNum = 0;
+	const size_t bandRowNum = colNum && nonZeroLimit / colNum ? nonZeroLimit / colNum : 1;
+
+	for (size_t bandStart = 0; bandStart < rowNum && nonZeroNum < nonZeroLimit; bandStart += bandRowNum)
+	{
+		const long long bandEnd = (long long)(bandStart + bandRowNum < rowNum ? bandStart + bandRowNum : rowNum);
+
+#pragma omp parallel for reduction(+:nonZeroNum)
+		for (long long row = (long long)bandStart; row < bandEnd; row++)
+		{
+			for (size_t col = 0; col < colNum; col++)
+				nonZeroNum += matrix[(size_t)row * rowStride + col * colStride] != 0.0f;
+		}
+	}
+
+	return nonZeroNum;
+}
+
+// Takes the strides of nonZeroCounting, so a transposed matrix is compressed by its logical rows; every row is counted first,
+// then filled in at its own offset
+unsigned char csrBuilding(const float* matrix, unsigned int rowNum, unsigned int colNum, size_t rowStride, size_t colStride, struct csrMatrix* csr)
+{
+	csr->rowNum = rowNum;
+	csr->colNum = colNum;
+	csr->rowPointers = (unsigned int*)malloc(sizeof(unsigned int) * ((size_t)rowNum + 1));
+	csr->colIndices = NULL;
+	csr->values = NULL;
+
+	if (csr->rowPointers == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+#pragma omp parallel for
+	for (long long row = 0; row < (long long)rowNum; row++)
+	{
+		unsigned int rowNonZeroNum = 0;
+		for (size_t col = 0; col < colNum; col++)
+			rowNonZeroNum += matrix[(size_t)row * rowStride + col * colStride] != 0.0f;
+
+		csr->rowPointers[row + 1] = rowNonZeroNum;
+	}
+
+	size_t nonZeroNum = 0;
+	csr->rowPointers[0] = 0;
+
+	for (unsigned int row = 0; row < rowNum; row++)
+	{
+		nonZeroNum += csr->rowPointers[row + 1];
+		csr->rowPointers[row + 1] = (unsigned int)nonZeroNum;
+	}
+
+	if (nonZeroNum > UINT_MAX)
+	{
+		fprintf(stderr, "Too many nonzeros for a sparse matrix!\n");
+		csrRelease(csr);
+		return 1;
+	}
+
+	csr->colIndices = (unsigned int*)malloc(sizeof(unsigned int) * (nonZeroNum ? nonZeroNum : 1));
+	csr->values = (float*)malloc(sizeof(float) * (nonZeroNum ? nonZeroNum : 1));
+
+	if (csr->colIndices == NULL || csr->values == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		csrRelease(csr);
+		return 1;
+	}
+
+#pragma omp parallel for
+	for (long long row = 0; row < (long long)rowNum; row++)
+	{
+		unsigned int nonZero = csr->rowPointers[row];
+
+		for (size_t col = 0; col < colNum; col++)
+		{
+			const float value = matrix[(size_t)row * rowStride + col * colStride];
+			if (value != 0.0f)
+			{
+				csr->colIndices[nonZero] = (unsigned int)col;
+				csr->values[nonZero++] = value;
+			}
+		}
+	}
+
+	return 0;
+}
+
+void csrRelease(struct csrMatrix* csr)
+{
+	free(csr->rowPointers);
+	free(csr->colIndices);
+	free(csr->values);
+
+	csr->rowPointers = NULL;
+	csr->colIndices = NULL;
+	csr->values = NULL;
+}
+
+// Consecutive rows are grouped while their nonzeros plus one store per row stay within SPARSE_BLOCK_NONZEROS, so a longer row
+// is a block of its own; rowBlocks gets the first row of every block followed by the number of rows
+unsigned char rowBlocksBuilding(const struct csrMatrix* csr, unsigned int** rowBlocks, unsigned int* blockNum)
+{
+	*rowBlocks = (unsigned int*)malloc(sizeof(unsigned int) * ((size_t)csr->rowNum + 1));
+	if (*rowBlocks == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	unsigned long long blockCost = 0;
+	*blockNum = 0;
+
+	for (unsigned int row = 0; row < csr->rowNum; row++)
+	{
+		const unsigned long long rowCost = csr->rowPointers[row + 1] - csr->rowPointers[row] + 1ULL;
+
+		if (!row || blockCost + rowCost > SPARSE_BLOCK_NONZEROS)
+		{
+			(*rowBlocks)[(*blockNum)++] = row;
+			blockCost = 0;
+		}
+
+		blockCost += rowCost;
+	}
+
+	(*rowBlocks)[*blockNum] = csr->rowNum;
+	return 0;
+}
+
+// The relative error is taken against the largest reference element, as single elements of a product may cancel to nearly zero
+void resultErrorCalculation(const float* resultMatrix, const float* referenceMatrix, size_t count, double* maxAbsError, double* maxRelError)
+{
+	double maxReference = 0.0;
+	*maxAbsError = 0.0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const double absError = fabs((double)resultMatrix[i] - referenceMatrix[i]);
+		if (absError > *maxAbsError || absError != absError)
+			*maxAbsError = absError;
+
+		if (fabs(referenceMatrix[i]) > maxReference)
+			maxReference = fabs(referenceMatrix[i]);
+	}
+
+	*maxRelError = maxReference > 0.0 ? *maxAbsError / maxReference : *maxAbsError;
+}
+
+void matmulMemoryInfo(const struct matmulContext* ctx, struct bufferPoolStats* stats)
+{
+	*stats = ctx->bufferPool.stats;
+}
+
+// Lowering the cap below the current allocation frees idle buffers right away
+void matmulMemoryCapSetting(struct matmulContext* ctx, size_t memoryCap)
+{
+	ctx->bufferPool.memoryCap = memoryCap;
+	ctx->bufferPool.stats.memoryCap = memoryCap;
+	bufferPoolEviction(&ctx->bufferPool, 0);
+}
+
+void kernelDefaultParams(cl_device_id device, int implementationType, struct kernelParams* params)
+{
+	params->localGroupSize = 1;
+	getMaxLocalGroupSize(device, &params->localGroupSize, implementationType);
+
+	params->vectorWidth = 1;
+	if (implementationType == 3 || implementationType == IMPLEMENTATION_GEMV)
+		params->vectorWidth = 4;
+
+	params->tileRows = 1;
+	params->tileCols = 1;
+	if (implementationType == 4)
+	{
+		params->tileRows = REGISTER_TILE_SIZE;
+		params->tileCols = REGISTER_TILE_SIZE;
+	}
+
+	if (implementationType == IMPLEMENTATION_SPARSE)
+		params->tileRows = SPARSE_LANE_NUM;
+
+	// CPU devices get their native SIMD width (e.g. 16 floats with AVX-512) when the kernel can be built with it
+	cl_device_type deviceType;
+	cl_uint preferredVectorWidth;
+
+	if (implementationType == 3
+		&& clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(cl_device_type), &deviceType, NULL) == CL_SUCCESS && (deviceType & CL_DEVICE_TYPE_CPU)
+		&& clGetDeviceInfo(device, CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT, sizeof(cl_uint), &preferredVectorWidth, NULL) == CL_SUCCESS
+		&& preferredVectorWidth <= 16 && preferredVectorWidth && !(preferredVectorWidth & (preferredVectorWidth - 1)))
+	{
+		struct kernelParams preferredParams = *params;
+		preferredParams.vectorWidth = preferredVectorWidth;
+
+		if (!kernelParamsValidation(device, implementationType, &preferredParams, sizeof(cl_float)))
+			*params = preferredParams;
+	}
+}
+
+// Parameters tuned for the nearest shape if the tuning database has any for this device, the defaults otherwise
+void kernelParamsSelection(struct matmulContext* ctx, int implementationType, unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	struct kernelParams* params)
+{
+	const struct tuningEntry* entry = tuningEntrySearch(ctx->tuningEntries, ctx->tuningEntryNum, implementationType, rowFirstMatrix, colSecondMatrix, colFirstRowSecond);
+
+	if (entry != NULL && !kernelParamsValidation(ctx->device, implementationType, &entry->params, sizeof(cl_float)))
+		*params = entry->params;
+	else
+		kernelDefaultParams(ctx->device, implementationType, params);
+}
+
+// Kernels are built on first use of an implementation type, element type, layout, build variant, epilogue and parameter set
+// and kept for the lifetime of the context
+unsigned char kernelPreparation(struct matmulContext* ctx, int implementationType, int elementType, int layout, int variant,
+	const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulKernel** kernel)
+{
+	static const char* kernelFilePaths[IMPLEMENTATION_GEMV] = { "kernel.cl", "kernelLocalMem.cl", "kernelVector.cl", "kernelRegister.cl", "kernelSparse.cl",
+		"kernelAddition.cl", "kernelReduction.cl", "kernelGemv.cl" };
+	static const char* typesFilePath = "kernelTypes.cl";
+
+	if (1 > implementationType || implementationType > IMPLEMENTATION_GEMV)
+	{
+		fprintf(stderr, "Incorrect implementation type!\n");
+		return 1;
+	}
+
+	for (size_t i = 0; i < ctx->kernelNum; i++)
+	{
+		if (ctx->kernels[i].implementationType == implementationType && ctx->kernels[i].elementType == elementType && ctx->kernels[i].layout == layout
+			&& ctx->kernels[i].variant == variant && ctx->kernels[i].epilogueVariant == epilogueVariant(epilogue) && !memcmp(&ctx->kernels[i].params, params, sizeof(struct kernelParams)))
+		{
+			*kernel = &ctx->kernels[i];
+			return 0;
+		}
+	}
+
+	if (ctx->kernelNum == ctx->kernelCapacity)
+	{
+		size_t kernelCapacity = ctx->kernelCapacity ? ctx->kernelCapacity * 2 : IMPLEMENTATION_TYPE_NUM;
+		struct matmulKernel* kernels = (struct matmulKernel*)realloc(ctx->kernels, sizeof(struct matmulKernel) * kernelCapacity);
+		if (kernels == NULL)
+		{
+			fprintf(stderr, "Insufficient memory available!\n");
+			return 1;
+		}
+
+		ctx->kernels = kernels;
+		ctx->kernelCapacity = kernelCapacity;
+	}
+
+	size_t typesFileSize, kernelFileSize;
+	unsigned char* typesFileText;
+	unsigned char* kernelFileText;
+
+	if (kernelFileProcessing(typesFilePath, &typesFileSize, &typesFileText))
+	{
+		fprintf(stderr, "Kernel file open error!\n");
+		return 1;
+	}
+
+	if (kernelFileProcessing(kernelFilePaths[implementationType - 1], &kernelFileSize, &kernelFileText))
+	{
+		fprintf(stderr, "Kernel file open error!\n");
+		free(typesFileText);
+		return 1;
+	}
+
+	// The type definitions go in front of the kernel source
+	unsigned char* sourceText = (unsigned char*)malloc(typesFileSize + 1 + kernelFileSize);
+	if (sourceText == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(typesFileText);
+		free(kernelFileText);
+		return 1;
+	}
+
+	memcpy(sourceText, typesFileText, typesFileSize);
+	sourceText[typesFileSize] = '\n';
+	memcpy(sourceText + typesFileSize + 1, kernelFileText, kernelFileSize);
+	free(typesFileText);
+	free(kernelFileText);
+
+	kernelFileText = sourceText;
+	kernelFileSize += typesFileSize + 1;
+
+	// Storage, accumulator and result types of every element type; kernelTypes.cl derives the rest from them
+	static const char* typeDefs[ELEMENT_TYPE_NUM] = {
+		"-D elemType=float -D accType=float -D resultType=float",
+		"-D elemType=half -D accType=float -D resultType=half -D halfStorage",
+		"-D elemType=double -D accType=double -D resultType=double -D doublePrecision",
+		"-D elemType=char -D accType=int -D resultType=int" };
+
+	static const char* variantDefs[KERNEL_VARIANT_NUM] = { "", " -D splitK", " -D vectorFirst" };
+
+	char typeDef[256];
+	snprintf(typeDef, sizeof(typeDef), "%s%s%s%s", typeDefs[elementType], layout & LAYOUT_FIRST_TRANSPOSED ? " -D firstTransposed" : "",
+		layout & LAYOUT_SECOND_TRANSPOSED ? " -D secondTransposed" : "", variantDefs[variant]);
+
+	if (epilogue != NULL)
+		snprintf(typeDef + strlen(typeDef), sizeof(typeDef) - strlen(typeDef), " -D epilogue -D activation=%d%s", epilogue->activation,
+			epilogue->bias != NULL ? " -D biasAdd" : "");
+
+	const char buildDef[] = "-D LSIZE=%zuU -D vecWidth=%zu -D TM=%zuU -D TN=%zuU %s";
+	char* buildDefStr;
+	if (buildDefCreation(buildDef, typeDef, &buildDefStr, params))
+	{
+		free(kernelFileText);
+		free(buildDefStr);
+		return 1;
+	}
+
+	cl_program program;
+	unsigned char errCode = programCreation(ctx->context, ctx->device, kernelFileText, kernelFileSize, buildDefStr, &program);
+
+	free(kernelFileText);
+	free(buildDefStr);
+
+	if (errCode)
+		return 1;
+
+	char* kernelName = "matrixMultiplication";
+	if (implementationType == IMPLEMENTATION_SPARSE)
+		kernelName = "sparseMultiplication";
+	else if (implementationType == IMPLEMENTATION_ADDITION)
+		kernelName = "matrixAddition";
+	else if (implementationType == IMPLEMENTATION_REDUCTION)
+		kernelName = "partialReduction";
+	else if (implementationType == IMPLEMENTATION_GEMV)
+		kernelName = "matrixVectorMultiplication";
+
+	cl_int errCodeReturn = CL_SUCCESS;
+	cl_kernel newKernel = clCreateKernel(program, kernelName, &errCodeReturn);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, kernelName);
+		clReleaseProgram(program);
+		return 1;
+	}
+
+	*kernel = &ctx->kernels[ctx->kernelNum++];
+	(*kernel)->program = program;
+	(*kernel)->kernel = newKernel;
+	(*kernel)->implementationType = implementationType;
+	(*kernel)->elementType = elementType;
+	(*kernel)->layout = layout;
+	(*kernel)->variant = variant;
+	(*kernel)->epilogueVariant = epilogueVariant(epilogue);
+	(*kernel)->params = *params;
+	return 0;
+}
+
+void eventsRelease(cl_event* events, size_t eventNum)
+{
+	for (size_t i = 0; i < eventNum; i++)
+	{
+		if (events[i] != NULL)
+			clReleaseEvent(events[i]);
+	}
+}
+
+void memObjectsRelease(cl_mem* mems, size_t memNum)
+{
+	for (size_t i = 0; i < memNum; i++)
+	{
+		if (mems[i] != NULL)
+			clReleaseMemObject(mems[i]);
+	}
+}
+
+unsigned char matmulExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing)
+{
+	if (ctx->native)
+	{
+		if (elementType != ELEMENT_TYPE_FLOAT)
+		{
+			fprintf(stderr, "The native backend only multiplies float matrices!\n");
+			return 1;
+		}
+
+		if (epilogue != NULL)
+		{
+			fprintf(stderr, "The native backend has no epilogue!\n");
+			return 1;
+		}
+
+		double computeTime;
+		if (cpuMatmul(firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, batchNum, layout,
+			leadingDims->first, leadingDims->second, leadingDims->result, &computeTime))
+			return 1;
+
+		if (timing != NULL)
+		{
+			timing->kernelTime = computeTime;
+			timing->transferTime = computeTime;
+			timing->overlapTime = 0;
+			timing->params = *params;
+		}
+
+		return 0;
+	}
+
+	if (ctx->zeroCopy)
+		return matmulZeroCopyExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, batchNum,
+			implementationType, elementType, layout, leadingDims, params, epilogue, timing);
+
+	struct matmulKernel* kernel;
+	if (kernelPreparation(ctx, implementationType, elementType, layout, KERNEL_VARIANT_PLAIN, params, epilogue, &kernel))
+		return 1;
+
+	const size_t typeSize = elementSize(elementType);
+	const size_t resultTypeSize = resultElementSize(elementType);
+	const size_t maxLocalGroupSize = kernel->params.localGroupSize;
+	const size_t vectorWidth = kernel->params.vectorWidth;
+	const size_t tileRows = kernel->params.tileRows;
+	const size_t tileCols = kernel->params.tileCols;
+
+	unsigned int alignedRowSize = dimensionAlignment(rowFirstMatrix, maxLocalGroupSize * tileRows);
+	unsigned int alignedColSize = dimensionAlignment(colSecondMatrix, maxLocalGroupSize * tileCols);
+	unsigned int alignedColRowSize = dimensionAlignment(colFirstRowSecond, maxLocalGroupSize) / maxLocalGroupSize;
+
+	// The buffers keep the leading dimensions of the host matrices, whose stored rows of all the batch follow one another;
+	// the kernels never touch elements past the real matrix sizes
+	unsigned int firstShape[2], secondShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, firstShape, secondShape);
+
+	const size_t firstRowNum = (size_t)firstShape[0] * batchNum;
+	const size_t secondRowNum = (size_t)secondShape[0] * batchNum;
+	const size_t resultRowNum = (size_t)rowFirstMatrix * batchNum;
+
+	// With a non-zero beta the kernel reads the result matrix, which is then uploaded with the others
+	const unsigned char resultReading = epilogue != NULL && epilogue->beta != 0;
+	const size_t biasTypeSize = elementType == ELEMENT_TYPE_DOUBLE ? sizeof(cl_double) : sizeof(cl_float);
+
+	cl_mem mems[4] = { NULL, NULL, NULL, NULL };
+	cl_mem* firstMatrixMem = &mems[0];
+	cl_mem* secondMatrixMem = &mems[1];
+	cl_mem* resultMatrixMem = &mems[2];
+	cl_mem* biasMem = &mems[3];
+
+	if (bufferAcquiring(&ctx->bufferPool, firstRowNum * leadingDims->first * typeSize, CL_MEM_READ_ONLY, firstMatrixMem)
+		|| bufferAcquiring(&ctx->bufferPool, secondRowNum * leadingDims->second * typeSize, CL_MEM_READ_ONLY, secondMatrixMem)
+		|| bufferAcquiring(&ctx->bufferPool, resultRowNum * leadingDims->result * resultTypeSize, resultReading ? CL_MEM_READ_WRITE : CL_MEM_WRITE_ONLY, resultMatrixMem)
+		|| (epilogue != NULL && epilogue->bias != NULL && bufferAcquiring(&ctx->bufferPool, biasTypeSize * colSecondMatrix, CL_MEM_READ_ONLY, biasMem)))
+	{
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	const cl_uint work_dim = 3;
+	size_t global_item_size[3] = { 0, 0, batchNum };
+	const size_t local_item_size[3] = { maxLocalGroupSize / vectorWidth, maxLocalGroupSize, 1 };
+
+	if (implementationType == 1)
+	{
+		global_item_size[0] = colSecondMatrix;
+		global_item_size[1] = rowFirstMatrix;
+	}
+	else
+	{
+		global_item_size[0] = alignedColSize / (vectorWidth * tileCols);
+		global_item_size[1] = alignedRowSize / tileRows;
+	}
+
+	cl_event events[3] = { NULL, NULL, NULL };
+	cl_event* event_start_transfer = &events[0];
+	cl_event* event_kernel = &events[1];
+	cl_event* event_end_transfer = &events[2];
+
+	cl_int errCodeReturn = matrixUploading(ctx->queue, *firstMatrixMem, leadingDims->first, firstMatrix, leadingDims->first, firstRowNum, firstShape[1], typeSize,
+		0, NULL, event_start_transfer);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = matrixUploading(ctx->queue, *secondMatrixMem, leadingDims->second, secondMatrix, leadingDims->second, secondRowNum, secondShape[1], typeSize, 0, NULL, NULL);
+
+	if (errCodeReturn == CL_SUCCESS && resultReading)
+		errCodeReturn = matrixUploading(ctx->queue, *resultMatrixMem, leadingDims->result, resultMatrix, leadingDims->result, resultRowNum, colSecondMatrix, resultTypeSize,
+			0, NULL, NULL);
+
+	if (errCodeReturn == CL_SUCCESS && *biasMem != NULL)
+		errCodeReturn = clEnqueueWriteBuffer(ctx->queue, *biasMem, CL_FALSE, 0, biasTypeSize * colSecondMatrix, epilogue->bias, 0, NULL, NULL);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = clSetKernelArg(kernel->kernel, 0, sizeof(cl_mem), firstMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 1, sizeof(cl_mem), secondMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 2, sizeof(cl_mem), resultMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 3, sizeof(cl_uint), &colFirstRowSecond);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 4, sizeof(cl_uint), &colSecondMatrix);
+
+	if (implementationType != 1)
+	{
+		errCodeReturn |= clSetKernelArg(kernel->kernel, 5, sizeof(cl_uint), &rowFirstMatrix);
+		errCodeReturn |= clSetKernelArg(kernel->kernel, 6, sizeof(cl_uint), &alignedColRowSize);
+	}
+
+	errCodeReturn |= leadingDimsArgsSetting(kernel->kernel, implementationType == 1 ? 5 : 7, leadingDims);
+
+	if (epilogue != NULL)
+		errCodeReturn |= epilogueArgsSetting(kernel->kernel, implementationType == 1 ? 8 : 10, elementType, epilogue, biasMem);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	if (implementationType == 1)
+		errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, work_dim, NULL, global_item_size, NULL, 0, NULL, event_kernel);
+	else
+		errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, work_dim, NULL, global_item_size, local_item_size, 0, NULL, event_kernel);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = matrixDownloading(ctx->queue, *resultMatrixMem, leadingDims->result, resultMatrix, leadingDims->result, resultRowNum, colSecondMatrix, resultTypeSize,
+		CL_TRUE, 0, NULL, event_end_transfer);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueReadBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	cl_ulong kernel_start_time, kernel_end_time;
+	cl_ulong transfer_start_time, transfer_end_time;
+
+	errCodeReturn = clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_start_transfer, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &transfer_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_end_transfer, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &transfer_end_time, NULL);
+
+	eventsRelease(events, 3);
+	buffersReturning(&ctx->bufferPool, mems, 4);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+		return 1;
+	}
+
+	if (timing != NULL)
+	{
+		timing->kernelTime = (kernel_end_time - kernel_start_time) / 1000000.0;
+		timing->transferTime = (transfer_end_time - transfer_start_time) / 1000000.0;
+		timing->overlapTime = 0;
+		timing->params = *params;
+	}
+
+	return 0;
+}
+
+// Slices of K for a product whose result tiles are too few to give every compute unit SPLIT_K_GROUPS_PER_UNIT work-groups,
+// 1 when it is not split. The naive kernel has no tiles of K to split, and half partial products would lose the float sums
+unsigned int splitKSlices(cl_device_id device, int implementationType, int elementType, unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	const struct kernelParams* params)
+{
+	cl_uint computeUnitNum;
+	if (implementationType == 1 || elementType == ELEMENT_TYPE_HALF
+		|| clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnitNum, NULL) != CL_SUCCESS)
+		return 1;
+
+	const size_t tileRowNum = params->localGroupSize * params->tileRows;
+	const size_t tileColNum = params->localGroupSize * params->tileCols;
+	const size_t groupNum = (size_t)(dimensionAlignment(rowFirstMatrix, tileRowNum) / tileRowNum) * (dimensionAlignment(colSecondMatrix, tileColNum) / tileColNum);
+	const size_t targetGroupNum = (size_t)computeUnitNum * SPLIT_K_GROUPS_PER_UNIT;
+
+	if (!groupNum || groupNum >= targetGroupNum)
+		return 1;
+
+	size_t sliceNum = (targetGroupNum + groupNum - 1) / groupNum;
+	const size_t tileNum = dimensionAlignment(colFirstRowSecond, params->localGroupSize) / params->localGroupSize;
+
+	if (sliceNum > tileNum / SPLIT_K_MIN_TILES)
+		sliceNum = tileNum / SPLIT_K_MIN_TILES;
+
+	if (sliceNum > SPLIT_K_SLICE_MAX)
+		sliceNum = SPLIT_K_SLICE_MAX;
+
+	return sliceNum > 1 ? (unsigned int)sliceNum : 1;
+}
+
+// The matrix-vector kernel takes results of at most GEMV_VECTOR_MAX rows or columns, unless its grid has fewer work-groups than
+// the device has compute units and split-K can spread a long K over them instead, as for a single dot product
+unsigned char gemvSelection(cl_device_id device, int implementationType, int elementType, unsigned int rowFirstMatrix, unsigned int colSecondMatrix,
+	unsigned int colFirstRowSecond, const struct kernelParams* params, const struct kernelParams* gemvParams)
+{
+	if (!rowFirstMatrix || !colSecondMatrix || (rowFirstMatrix > GEMV_VECTOR_MAX && colSecondMatrix > GEMV_VECTOR_MAX))
+		return 0;
+
+	const unsigned char vectorFirst = rowFirstMatrix < colSecondMatrix;
+	const unsigned int outQuantity = vectorFirst ? colSecondMatrix : rowFirstMatrix;
+	const size_t groupNum = (size_t)(dimensionAlignment(outQuantity, gemvParams->localGroupSize) / gemvParams->localGroupSize)
+		* (vectorFirst ? rowFirstMatrix : colSecondMatrix);
+
+	cl_uint computeUnitNum;
+	if (clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnitNum, NULL) != CL_SUCCESS || groupNum >= computeUnitNum)
+		return 1;
+
+	return splitKSlices(device, implementationType, elementType, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, params) == 1;
+}
+
+unsigned char matmulSplitKExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int sliceNum,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing)
+{
+	// The kernels array may grow with the second kernel, so the first is taken out of it before
+	struct matmulKernel* kernel;
+	if (kernelPreparation(ctx, implementationType, elementType, layout, KERNEL_VARIANT_SPLIT_K, params, NULL, &kernel))
+		return 1;
+
+	cl_kernel partialKernel = kernel->kernel;
+
+	struct kernelParams reductionParams;
+	kernelDefaultParams(ctx->device, IMPLEMENTATION_REDUCTION, &reductionParams);
+
+	if (kernelPreparation(ctx, IMPLEMENTATION_REDUCTION, elementType, 0, KERNEL_VARIANT_PLAIN, &reductionParams, epilogue, &kernel))
+		return 1;
+
+	cl_kernel reductionKernel = kernel->kernel;
+
+	const size_t typeSize = elementSize(elementType);
+	const size_t resultTypeSize = resultElementSize(elementType);
+	const size_t maxLocalGroupSize = params->localGroupSize;
+	const size_t vectorWidth = params->vectorWidth;
+	const size_t tileRows = params->tileRows;
+	const size_t tileCols = params->tileCols;
+	const size_t reductionGroupSize = reductionParams.localGroupSize;
+
+	unsigned int alignedRowSize = dimensionAlignment(rowFirstMatrix, maxLocalGroupSize * tileRows);
+	unsigned int alignedColSize = dimensionAlignment(colSecondMatrix, maxLocalGroupSize * tileCols);
+
+	// Every slice takes the same number of tiles of K, so the last one may be shorter and there may be fewer slices than asked for
+	const unsigned int tileNum = dimensionAlignment(colFirstRowSecond, maxLocalGroupSize) / maxLocalGroupSize;
+	unsigned int sliceTileNum = (tileNum + sliceNum - 1) / sliceNum;
+	sliceNum = (tileNum + sliceTileNum - 1) / sliceTileNum;
+
+	unsigned int firstShape[2], secondShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, firstShape, secondShape);
+
+	// The partial products are packed and kept in the accumulator type, which is the result type of every element type but half
+	const struct matmulLeadingDims partialLeadingDims = { leadingDims->first, leadingDims->second, colSecondMatrix };
+	const unsigned char resultReading = epilogue != NULL && epilogue->beta != 0;
+	const size_t biasTypeSize = elementType == ELEMENT_TYPE_DOUBLE ? sizeof(cl_double) : sizeof(cl_float);
+
+	cl_mem mems[5] = { NULL, NULL, NULL, NULL, NULL };
+	cl_mem* firstMatrixMem = &mems[0];
+	cl_mem* secondMatrixMem = &mems[1];
+	cl_mem* partialMatricesMem = &mems[2];
+	cl_mem* resultMatrixMem = &mems[3];
+	cl_mem* biasMem = &mems[4];
+
+	if (bufferAcquiring(&ctx->bufferPool, (size_t)firstShape[0] * leadingDims->first * typeSize, CL_MEM_READ_ONLY, firstMatrixMem)
+		|| bufferAcquiring(&ctx->bufferPool, (size_t)secondShape[0] * leadingDims->second * typeSize, CL_MEM_READ_ONLY, secondMatrixMem)
+		|| bufferAcquiring(&ctx->bufferPool, (size_t)sliceNum * rowFirstMatrix * colSecondMatrix * resultTypeSize, CL_MEM_READ_WRITE, partialMatricesMem)
+		|| bufferAcquiring(&ctx->bufferPool, (size_t)rowFirstMatrix * leadingDims->result * resultTypeSize, resultReading ? CL_MEM_READ_WRITE : CL_MEM_WRITE_ONLY, resultMatrixMem)
+		|| (epilogue != NULL && epilogue->bias != NULL && bufferAcquiring(&ctx->bufferPool, biasTypeSize * colSecondMatrix, CL_MEM_READ_ONLY, biasMem)))
+	{
+		buffersReturning(&ctx->bufferPool, mems, 5);
+		return 1;
+	}
+
+	const size_t global_item_size[3] = { alignedColSize / (vectorWidth * tileCols), alignedRowSize / tileRows, sliceNum };
+	const size_t local_item_size[3] = { maxLocalGroupSize / vectorWidth, maxLocalGroupSize, 1 };
+	const size_t reduction_global_item_size[2] = { dimensionAlignment(colSecondMatrix, reductionGroupSize), dimensionAlignment(rowFirstMatrix, reductionGroupSize) };
+	const size_t reduction_local_item_size[2] = { reductionGroupSize, reductionGroupSize };
+
+	cl_event events[4] = { NULL, NULL, NULL, NULL };
+	cl_event* event_start_transfer = &events[0];
+	cl_event* event_kernel = &events[1];
+	cl_event* event_reduction = &events[2];
+	cl_event* event_end_transfer = &events[3];
+
+	cl_int errCodeReturn = matrixUploading(ctx->queue, *firstMatrixMem, leadingDims->first, firstMatrix, leadingDims->first, firstShape[0], firstShape[1], typeSize,
+		0, NULL, event_start_transfer);
+
+	if (errCodeReturn == CL_SUCCESS)
+		errCodeReturn = matrixUploading(ctx->queue, *secondMatrixMem, leadingDims->second, secondMatrix, leadingDims->second, secondShape[0], secondShape[1], typeSize,
+			0, NULL, NULL);
+
+	if (errCodeReturn == CL_SUCCESS && resultReading)
+		errCodeReturn = matrixUploading(ctx->queue, *resultMatrixMem, leadingDims->result, resultMatrix, leadingDims->result, rowFirstMatrix, colSecondMatrix, resultTypeSize,
+			0, NULL, NULL);
+
+	if (errCodeReturn == CL_SUCCESS && *biasMem != NULL)
+		errCodeReturn = clEnqueueWriteBuffer(ctx->queue, *biasMem, CL_FALSE, 0, biasTypeSize * colSecondMatrix, epilogue->bias, 0, NULL, NULL);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 4);
+		buffersReturning(&ctx->bufferPool, mems, 5);
+		return 1;
+	}
+
+	errCodeReturn = clSetKernelArg(partialKernel, 0, sizeof(cl_mem), firstMatrixMem);
+	errCodeReturn |= clSetKernelArg(partialKernel, 1, sizeof(cl_mem), secondMatrixMem);
+	errCodeReturn |= clSetKernelArg(partialKernel, 2, sizeof(cl_mem), partialMatricesMem);
+	errCodeReturn |= clSetKernelArg(partialKernel, 3, sizeof(cl_uint), &colFirstRowSecond);
+	errCodeReturn |= clSetKernelArg(partialKernel, 4, sizeof(cl_uint), &colSecondMatrix);
+	errCodeReturn |= clSetKernelArg(partialKernel, 5, sizeof(cl_uint), &rowFirstMatrix);
+	errCodeReturn |= clSetKernelArg(partialKernel, 6, sizeof(cl_uint), &sliceTileNum);
+	errCodeReturn |= leadingDimsArgsSetting(partialKernel, 7, &partialLeadingDims);
+
+	errCodeReturn |= clSetKernelArg(reductionKernel, 0, sizeof(cl_mem), partialMatricesMem);
+	errCodeReturn |= clSetKernelArg(reductionKernel, 1, sizeof(cl_mem), resultMatrixMem);
+	errCodeReturn |= clSetKernelArg(reductionKernel, 2, sizeof(cl_uint), &colSecondMatrix);
+	errCodeReturn |= clSetKernelArg(reductionKernel, 3, sizeof(cl_uint), &rowFirstMatrix);
+	errCodeReturn |= clSetKernelArg(reductionKernel, 4, sizeof(cl_uint), &sliceNum);
+	errCodeReturn |= clSetKernelArg(reductionKernel, 5, sizeof(cl_uint), &leadingDims->result);
+
+	if (epilogue != NULL)
+		errCodeReturn |= epilogueArgsSetting(reductionKernel, 6, elementType, epilogue, biasMem);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		clFinish(ctx->queue);
+		eventsRelease(events, 4);
+		buffersReturning(&ctx->bufferPool, mems, 5);
+		return 1;
+	}
+
+	errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, partialKernel, 3, NULL, global_item_size, local_item_size, 0, NULL, event_kernel);
+
+	if (errCodeReturn == CL_SUCCESS)
+		errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, reductionKernel, 2, NULL, reduction_global_item_size, reduction_local_item_size, 0, NULL, event_reduction);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+		clFinish(ctx->queue);
+		eventsRelease(events, 4);
+		buffersReturning(&ctx->bufferPool, mems, 5);
+		return 1;
+	}
+
+	errCodeReturn = matrixDownloading(ctx->queue, *resultMatrixMem, leadingDims->result, resultMatrix, leadingDims->result, rowFirstMatrix, colSecondMatrix, resultTypeSize,
+		CL_TRUE, 0, NULL, event_end_transfer);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueReadBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 4);
+		buffersReturning(&ctx->bufferPool, mems, 5);
+		return 1;
+	}
+
+	// The kernel time runs from the start of the partial products to the end of their reduction
+	cl_ulong kernel_start_time, kernel_end_time;
+	cl_ulong transfer_start_time, transfer_end_time;
+
+	errCodeReturn = clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_reduction, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_start_transfer, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &transfer_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_end_transfer, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &transfer_end_time, NULL);
+
+	eventsRelease(events, 4);
+	buffersReturning(&ctx->bufferPool, mems, 5);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+		return 1;
+	}
+
+	if (timing != NULL)
+	{
+		timing->kernelTime = (kernel_end_time - kernel_start_time) / 1000000.0;
+		timing->transferTime = (transfer_end_time - transfer_start_time) / 1000000.0;
+		timing->overlapTime = 0;
+		timing->params = *params;
+	}
+
+	return 0;
+}
+
+// The matrix-vector kernel takes the vectors from the smaller of the first matrix's rows and the second matrix's columns;
+// a work-group sums along K for LSIZE results of one vector, so the grid is padded along the other dimension only
+unsigned char matmulGemvExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing)
+{
+	const unsigned char vectorFirst = rowFirstMatrix < colSecondMatrix;
+
+	struct matmulKernel* kernel;
+	if (kernelPreparation(ctx, IMPLEMENTATION_GEMV, elementType, layout, vectorFirst ? KERNEL_VARIANT_VECTOR_FIRST : KERNEL_VARIANT_PLAIN, params, epilogue, &kernel))
+		return 1;
+
+	const size_t typeSize = elementSize(elementType);
+	const size_t resultTypeSize = resultElementSize(elementType);
+	const size_t maxLocalGroupSize = params->localGroupSize;
+
+	// The lanes summing along K are local id 0 when the stored rows of the matrix run along K, as in the kernel
+	const unsigned char matrixAlongK = vectorFirst ? (layout & LAYOUT_SECOND_TRANSPOSED) != 0 : !(layout & LAYOUT_FIRST_TRANSPOSED);
+	const unsigned int alignedOutSize = dimensionAlignment(vectorFirst ? colSecondMatrix : rowFirstMatrix, maxLocalGroupSize);
+	const unsigned int vectorNum = vectorFirst ? rowFirstMatrix : colSecondMatrix;
+
+	unsigned int firstShape[2], secondShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, firstShape, secondShape);
+
+	const unsigned char resultReading = epilogue != NULL && epilogue->beta != 0;
+	const size_t biasTypeSize = elementType == ELEMENT_TYPE_DOUBLE ? sizeof(cl_double) : sizeof(cl_float);
+
+	cl_mem mems[4] = { NULL, NULL, NULL, NULL };
+	cl_mem* firstMatrixMem = &mems[0];
+	cl_mem* secondMatrixMem = &mems[1];
+	cl_mem* resultMatrixMem = &mems[2];
+	cl_mem* biasMem = &mems[3];
+
+	if (bufferAcquiring(&ctx->bufferPool, (size_t)firstShape[0] * leadingDims->first * typeSize, CL_MEM_READ_ONLY, firstMatrixMem)
+		|| bufferAcquiring(&ctx->bufferPool, (size_t)secondShape[0] * leadingDims->second * typeSize, CL_MEM_READ_ONLY, secondMatrixMem)
+		|| bufferAcquiring(&ctx->bufferPool, (size_t)rowFirstMatrix * leadingDims->result * resultTypeSize, resultReading ? CL_MEM_READ_WRITE : CL_MEM_WRITE_ONLY, resultMatrixMem)
+		|| (epilogue != NULL && epilogue->bias != NULL && bufferAcquiring(&ctx->bufferPool, biasTypeSize * colSecondMatrix, CL_MEM_READ_ONLY, biasMem)))
+	{
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	const size_t global_item_size[3] = { matrixAlongK ? maxLocalGroupSize : alignedOutSize, matrixAlongK ? alignedOutSize : maxLocalGroupSize, vectorNum };
+	const size_t local_item_size[3] = { maxLocalGroupSize, maxLocalGroupSize, 1 };
+
+	cl_event events[3] = { NULL, NULL, NULL };
+	cl_event* event_start_transfer = &events[0];
+	cl_event* event_kernel = &events[1];
+	cl_event* event_end_transfer = &events[2];
+
+	cl_int errCodeReturn = matrixUploading(ctx->queue, *firstMatrixMem, leadingDims->first, firstMatrix, leadingDims->first, firstShape[0], firstShape[1], typeSize,
+		0, NULL, event_start_transfer);
+
+	if (errCodeReturn == CL_SUCCESS)
+		errCodeReturn = matrixUploading(ctx->queue, *secondMatrixMem, leadingDims->second, secondMatrix, leadingDims->second, secondShape[0], secondShape[1], typeSize,
+			0, NULL, NULL);
+
+	if (errCodeReturn == CL_SUCCESS && resultReading)
+		errCodeReturn = matrixUploading(ctx->queue, *resultMatrixMem, leadingDims->result, resultMatrix, leadingDims->result, rowFirstMatrix, colSecondMatrix, resultTypeSize,
+			0, NULL, NULL);
+
+	if (errCodeReturn == CL_SUCCESS && *biasMem != NULL)
+		errCodeReturn = clEnqueueWriteBuffer(ctx->queue, *biasMem, CL_FALSE, 0, biasTypeSize * colSecondMatrix, epilogue->bias, 0, NULL, NULL);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = clSetKernelArg(kernel->kernel, 0, sizeof(cl_mem), firstMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 1, sizeof(cl_mem), secondMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 2, sizeof(cl_mem), resultMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 3, sizeof(cl_uint), &colFirstRowSecond);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 4, sizeof(cl_uint), &colSecondMatrix);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 5, sizeof(cl_uint), &rowFirstMatrix);
+	errCodeReturn |= leadingDimsArgsSetting(kernel->kernel, 6, leadingDims);
+
+	if (epilogue != NULL)
+		errCodeReturn |= epilogueArgsSetting(kernel->kernel, 9, elementType, epilogue, biasMem);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, 3, NULL, global_item_size, local_item_size, 0, NULL, event_kernel);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = matrixDownloading(ctx->queue, *resultMatrixMem, leadingDims->result, resultMatrix, leadingDims->result, rowFirstMatrix, colSecondMatrix, resultTypeSize,
+		CL_TRUE, 0, NULL, event_end_transfer);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueReadBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	cl_ulong kernel_start_time, kernel_end_time;
+	cl_ulong transfer_start_time, transfer_end_time;
+
+	errCodeReturn = clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_start_transfer, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &transfer_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_end_transfer, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &transfer_end_time, NULL);
+
+	eventsRelease(events, 3);
+	buffersReturning(&ctx->bufferPool, mems, 4);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+		return 1;
+	}
+
+	if (timing != NULL)
+	{
+		timing->kernelTime = (kernel_end_time - kernel_start_time) / 1000000.0;
+		timing->transferTime = (transfer_end_time - transfer_start_time) / 1000000.0;
+		timing->overlapTime = 0;
+		timing->params = *params;
+	}
+
+	return 0;
+}
+
+// The kernels never touch elements past the real matrix sizes, so the host matrices can be used without padding
+unsigned char matmulZeroCopyExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing)
+{
+	struct matmulKernel* kernel;
+	if (kernelPreparation(ctx, implementationType, elementType, layout, KERNEL_VARIANT_PLAIN, params, epilogue, &kernel))
+		return 1;
+
+	const size_t typeSize = elementSize(elementType);
+	const size_t resultTypeSize = resultElementSize(elementType);
+	const size_t maxLocalGroupSize = kernel->params.localGroupSize;
+	const size_t vectorWidth = kernel->params.vectorWidth;
+	const size_t tileRows = kernel->params.tileRows;
+	const size_t tileCols = kernel->params.tileCols;
+
+	unsigned int alignedRowSize = dimensionAlignment(rowFirstMatrix, maxLocalGroupSize * tileRows);
+	unsigned int alignedColSize = dimensionAlignment(colSecondMatrix, maxLocalGroupSize * tileCols);
+	unsigned int alignedColRowSize = dimensionAlignment(colFirstRowSecond, maxLocalGroupSize) / maxLocalGroupSize;
+
+	// The buffers span the host matrices from their first to their last element, so views into larger matrices are used in place
+	unsigned int firstShape[2], secondShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, firstShape, secondShape);
+
+	const size_t firstMatrixSize = typeSize * (((size_t)firstShape[0] * batchNum - 1) * leadingDims->first + firstShape[1]);
+	const size_t secondMatrixSize = typeSize * (((size_t)secondShape[0] * batchNum - 1) * leadingDims->second + secondShape[1]);
+	const size_t resultMatrixSize = resultTypeSize * (((size_t)rowFirstMatrix * batchNum - 1) * leadingDims->result + colSecondMatrix);
+
+	// The kernel reads the result in place when beta is not zero; the bias row is copied into a buffer of its own
+	const cl_mem_flags resultFlags = epilogue != NULL && epilogue->beta != 0 ? CL_MEM_READ_WRITE : CL_MEM_WRITE_ONLY;
+	const size_t biasTypeSize = elementType == ELEMENT_TYPE_DOUBLE ? sizeof(cl_double) : sizeof(cl_float);
+
+	cl_int errCodeReturn = CL_SUCCESS;
+	cl_mem mems[4] = { NULL, NULL, NULL, NULL };
+
+	mems[0] = clCreateBuffer(ctx->context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, firstMatrixSize, (void*)firstMatrix, &errCodeReturn);
+	if (errCodeReturn == CL_SUCCESS)
+		mems[1] = clCreateBuffer(ctx->context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, secondMatrixSize, (void*)secondMatrix, &errCodeReturn);
+	if (errCodeReturn == CL_SUCCESS)
+		mems[2] = clCreateBuffer(ctx->context, resultFlags | CL_MEM_USE_HOST_PTR, resultMatrixSize, resultMatrix, &errCodeReturn);
+	if (errCodeReturn == CL_SUCCESS && epilogue != NULL && epilogue->bias != NULL)
+		mems[3] = clCreateBuffer(ctx->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, biasTypeSize * colSecondMatrix, (void*)epilogue->bias, &errCodeReturn);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateBuffer");
+		memObjectsRelease(mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = clSetKernelArg(kernel->kernel, 0, sizeof(cl_mem), &mems[0]);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 1, sizeof(cl_mem), &mems[1]);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 2, sizeof(cl_mem), &mems[2]);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 3, sizeof(cl_uint), &colFirstRowSecond);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 4, sizeof(cl_uint), &colSecondMatrix);
+
+	if (implementationType != 1)
+	{
+		errCodeReturn |= clSetKernelArg(kernel->kernel, 5, sizeof(cl_uint), &rowFirstMatrix);
+		errCodeReturn |= clSetKernelArg(kernel->kernel, 6, sizeof(cl_uint), &alignedColRowSize);
+	}
+
+	errCodeReturn |= leadingDimsArgsSetting(kernel->kernel, implementationType == 1 ? 5 : 7, leadingDims);
+
+	if (epilogue != NULL)
+		errCodeReturn |= epilogueArgsSetting(kernel->kernel, implementationType == 1 ? 8 : 10, elementType, epilogue, &mems[3]);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		memObjectsRelease(mems, 4);
+		return 1;
+	}
+
+	cl_event events[2] = { NULL, NULL };
+	cl_event* event_kernel = &events[0];
+	cl_event* event_map = &events[1];
+
+	const size_t local_item_size[3] = { maxLocalGroupSize / vectorWidth, maxLocalGroupSize, 1 };
+
+	if (implementationType == 1)
+	{
+		const size_t global_item_size[3] = { colSecondMatrix, rowFirstMatrix, batchNum };
+		errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, 3, NULL, global_item_size, NULL, 0, NULL, event_kernel);
+	}
+	else
+	{
+		const size_t global_item_size[3] = { alignedColSize / (vectorWidth * tileCols), alignedRowSize / tileRows, batchNum };
+		errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, 3, NULL, global_item_size, local_item_size, 0, NULL, event_kernel);
+	}
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+		clFinish(ctx->queue);
+		memObjectsRelease(mems, 4);
+		return 1;
+	}
+
+	// Mapping the result makes the kernel's writes visible in resultMatrix; on unified memory it copies nothing
+	void* mappedResult = clEnqueueMapBuffer(ctx->queue, mems[2], CL_TRUE, CL_MAP_READ, 0, resultMatrixSize, 0, NULL, event_map, &errCodeReturn);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueMapBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 2);
+		memObjectsRelease(mems, 4);
+		return 1;
+	}
+
+	errCodeReturn = clEnqueueUnmapMemObject(ctx->queue, mems[2], mappedResult, 0, NULL, NULL);
+	clFinish(ctx->queue);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueUnmapMemObject");
+		eventsRelease(events, 2);
+		memObjectsRelease(mems, 4);
+		return 1;
+	}
+
+	cl_ulong kernel_start_time, kernel_end_time, map_end_time;
+
+	errCodeReturn = clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_map, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &map_end_time, NULL);
+
+	eventsRelease(events, 2);
+	memObjectsRelease(mems, 4);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+		return 1;
+	}
+
+	if (timing != NULL)
+	{
+		timing->kernelTime = (kernel_end_time - kernel_start_time) / 1000000.0;
+		timing->transferTime = (map_end_time - kernel_start_time) / 1000000.0;
+		timing->overlapTime = 0;
+		timing->params = *params;
+	}
+
+	return 0;
+}
+
+// The second matrix is uploaded once; every row panel of the first is uploaded on uploadQueue, multiplied on the main queue
+// and its part of the result downloaded on downloadQueue. Panel buffers are reused round-robin, so the upload into a slot
+// waits for the kernel that last read it and the kernel writing a slot waits for the download that last read it
+unsigned char matmulPipelinedExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing)
+{
+	// There is nothing to overlap without transfers
+	if (ctx->native || ctx->zeroCopy)
+		return matmulExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, 1, implementationType, elementType, layout, leadingDims, params, epilogue, timing);
+
+	struct matmulKernel* kernel;
+	if (kernelPreparation(ctx, implementationType, elementType, layout, KERNEL_VARIANT_PLAIN, params, epilogue, &kernel))
+		return 1;
+
+	const size_t typeSize = elementSize(elementType);
+	const size_t resultTypeSize = resultElementSize(elementType);
+	const size_t maxLocalGroupSize = kernel->params.localGroupSize;
+	const size_t vectorWidth = kernel->params.vectorWidth;
+	const size_t tileRows = kernel->params.tileRows;
+	const size_t tileCols = kernel->params.tileCols;
+
+	unsigned int alignedColSize = dimensionAlignment(colSecondMatrix, maxLocalGroupSize * tileCols);
+	unsigned int alignedColRowSize = dimensionAlignment(colFirstRowSecond, maxLocalGroupSize);
+
+	// Panels are whole rows of work-groups
+	const unsigned int panelRowSize = dimensionAlignment((rowFirstMatrix + PIPELINE_PANEL_NUM - 1) / PIPELINE_PANEL_NUM, maxLocalGroupSize * tileRows);
+	const size_t panelNum = (rowFirstMatrix + panelRowSize - 1) / panelRowSize;
+	const size_t slotNum = panelNum < PIPELINE_SLOT_NUM ? panelNum : PIPELINE_SLOT_NUM;
+
+	alignedColRowSize /= maxLocalGroupSize;
+
+	// The buffers keep the leading dimensions of the host matrices, except for panels of a transposed first matrix: those are bands
+	// of columns, gathered into K x panel rows buffers
+	unsigned int firstShape[2], secondShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, firstShape, secondShape);
+
+	const unsigned char firstTransposed = (layout & LAYOUT_FIRST_TRANSPOSED) != 0;
+	const size_t secondMatrixSize = (size_t)secondShape[0] * leadingDims->second;
+	const size_t panelFirstMatrixSize = firstTransposed ? (size_t)colFirstRowSecond * panelRowSize : (size_t)panelRowSize * leadingDims->first;
+	const size_t panelResultMatrixSize = (size_t)panelRowSize * leadingDims->result;
+
+	// With a non-zero beta every result panel is uploaded after the first matrix panel and before its kernel
+	const unsigned char resultReading = epilogue != NULL && epilogue->beta != 0;
+	const size_t biasTypeSize = elementType == ELEMENT_TYPE_DOUBLE ? sizeof(cl_double) : sizeof(cl_float);
+
+	// The second matrix, then the first matrix panels, then the result panels and the bias
+	cl_mem mems[2 + 2 * PIPELINE_SLOT_NUM] = { NULL };
+	const size_t memNum = 2 + 2 * slotNum;
+	cl_mem* biasMem = &mems[memNum - 1];
+
+	unsigned char errCode = bufferAcquiring(&ctx->bufferPool, secondMatrixSize * typeSize, CL_MEM_READ_ONLY, &mems[0]);
+
+	for (size_t i = 0; i < slotNum && !errCode; i++)
+	{
+		errCode = bufferAcquiring(&ctx->bufferPool, panelFirstMatrixSize * typeSize, CL_MEM_READ_ONLY, &mems[1 + i])
+			|| bufferAcquiring(&ctx->bufferPool, panelResultMatrixSize * resultTypeSize, resultReading ? CL_MEM_READ_WRITE : CL_MEM_WRITE_ONLY, &mems[1 + slotNum + i]);
+	}
+
+	if (!errCode && epilogue != NULL && epilogue->bias != NULL)
+		errCode = bufferAcquiring(&ctx->bufferPool, biasTypeSize * colSecondMatrix, CL_MEM_READ_ONLY, biasMem);
+
+	if (errCode)
+	{
+		buffersReturning(&ctx->bufferPool, mems, memNum);
+		return 1;
+	}
+
+	// The upload of the second matrix, then an upload, a kernel and a download per panel and the result uploads
+	const size_t eventNum = 1 + (3 + resultReading) * panelNum;
+	cl_event* events = (cl_event*)calloc(eventNum, sizeof(cl_event));
+	if (events == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		buffersReturning(&ctx->bufferPool, mems, memNum);
+		return 1;
+	}
+
+	cl_event* uploadEvents = events + 1;
+	cl_event* kernelEvents = uploadEvents + panelNum;
+	cl_event* downloadEvents = kernelEvents + panelNum;
+	cl_event* resultUploadEvents = downloadEvents + panelNum;
+
+	// The bias goes first on the in-order upload queue, so it is there once the second matrix is
+	cl_int errCodeReturn = CL_SUCCESS;
+	if (*biasMem != NULL)
+		errCodeReturn = clEnqueueWriteBuffer(ctx->uploadQueue, *biasMem, CL_FALSE, 0, biasTypeSize * colSecondMatrix, epilogue->bias, 0, NULL, NULL);
+
+	if (errCodeReturn == CL_SUCCESS)
+		errCodeReturn = matrixUploading(ctx->uploadQueue, mems[0], leadingDims->second, secondMatrix, leadingDims->second, secondShape[0], secondShape[1], typeSize,
+			0, NULL, &events[0]);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+		errCode = 1;
+	}
+
+	errCodeReturn = clSetKernelArg(kernel->kernel, 1, sizeof(cl_mem), &mems[0]);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 3, sizeof(cl_uint), &colFirstRowSecond);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 4, sizeof(cl_uint), &colSecondMatrix);
+
+	if (implementationType != 1)
+		errCodeReturn |= clSetKernelArg(kernel->kernel, 6, sizeof(cl_uint), &alignedColRowSize);
+
+	errCodeReturn |= leadingDimsArgsSetting(kernel->kernel, implementationType == 1 ? 5 : 7, leadingDims);
+
+	if (epilogue != NULL)
+		errCodeReturn |= epilogueArgsSetting(kernel->kernel, implementationType == 1 ? 8 : 10, elementType, epilogue, biasMem);
+
+	if (!errCode && errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		errCode = 1;
+	}
+
+	const size_t local_item_size[2] = { maxLocalGroupSize / vectorWidth, maxLocalGroupSize };
+
+	for (size_t panel = 0; panel < panelNum && !errCode; panel++)
+	{
+		const size_t slot = panel % slotNum;
+		const size_t rowStart = panel * panelRowSize;
+		const cl_uint rowNum = (cl_uint)(rowFirstMatrix - rowStart < panelRowSize ? rowFirstMatrix - rowStart : panelRowSize);
+
+		const cl_uint panelLeadingDim = firstTransposed ? rowNum : leadingDims->first;
+
+		if (firstTransposed)
+		{
+			errCodeReturn = matrixUploading(ctx->uploadQueue, mems[1 + slot], panelLeadingDim, (const char*)firstMatrix + typeSize * rowStart, leadingDims->first,
+				colFirstRowSecond, rowNum, typeSize, panel >= slotNum, panel >= slotNum ? &kernelEvents[panel - slotNum] : NULL, &uploadEvents[panel]);
+		}
+		else
+		{
+			errCodeReturn = matrixUploading(ctx->uploadQueue, mems[1 + slot], panelLeadingDim, (const char*)firstMatrix + typeSize * rowStart * leadingDims->first,
+				leadingDims->first, rowNum, colFirstRowSecond, typeSize, panel >= slotNum, panel >= slotNum ? &kernelEvents[panel - slotNum] : NULL, &uploadEvents[panel]);
+		}
+
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+			errCode = 1;
+			break;
+		}
+
+		// The result slot is overwritten only after the download that last read it
+		if (resultReading)
+		{
+			errCodeReturn = matrixUploading(ctx->uploadQueue, mems[1 + slotNum + slot], leadingDims->result, (const char*)resultMatrix + resultTypeSize * rowStart * leadingDims->result,
+				leadingDims->result, rowNum, colSecondMatrix, resultTypeSize, panel >= slotNum, panel >= slotNum ? &downloadEvents[panel - slotNum] : NULL,
+				&resultUploadEvents[panel]);
+			if (errCodeReturn != CL_SUCCESS)
+			{
+				errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+				errCode = 1;
+				break;
+			}
+		}
+
+		errCodeReturn = clSetKernelArg(kernel->kernel, 0, sizeof(cl_mem), &mems[1 + slot]);
+		errCodeReturn |= clSetKernelArg(kernel->kernel, 2, sizeof(cl_mem), &mems[1 + slotNum + slot]);
+
+		errCodeReturn |= clSetKernelArg(kernel->kernel, implementationType == 1 ? 5 : 7, sizeof(cl_uint), &panelLeadingDim);
+
+		if (implementationType != 1)
+			errCodeReturn |= clSetKernelArg(kernel->kernel, 5, sizeof(cl_uint), &rowNum);
+
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clSetKernelArg");
+			errCode = 1;
+			break;
+		}
+
+		cl_event waitEvents[3] = { events[0], uploadEvents[panel], resultReading ? resultUploadEvents[panel] : panel >= slotNum ? downloadEvents[panel - slotNum] : NULL };
+		const cl_uint waitEventNum = waitEvents[2] != NULL ? 3 : 2;
+		size_t global_item_size[2];
+
+		if (implementationType == 1)
+		{
+			global_item_size[0] = colSecondMatrix;
+			global_item_size[1] = rowNum;
+
+			errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, 2, NULL, global_item_size, NULL, waitEventNum, waitEvents, &kernelEvents[panel]);
+		}
+		else
+		{
+			global_item_size[0] = alignedColSize / (vectorWidth * tileCols);
+			global_item_size[1] = dimensionAlignment(rowNum, maxLocalGroupSize * tileRows) / tileRows;
+
+			errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, 2, NULL, global_item_size, local_item_size, waitEventNum, waitEvents, &kernelEvents[panel]);
+		}
+
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+			errCode = 1;
+			break;
+		}
+
+		errCodeReturn = matrixDownloading(ctx->downloadQueue, mems[1 + slotNum + slot], leadingDims->result, (char*)resultMatrix + resultTypeSize * rowStart * leadingDims->result,
+			leadingDims->result, rowNum, colSecondMatrix, resultTypeSize, CL_FALSE, 1, &kernelEvents[panel], &downloadEvents[panel]);
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clEnqueueReadBuffer");
+			errCode = 1;
+			break;
+		}
+
+		// Every queue has to start on its part before the next panel is enqueued
+		clFlush(ctx->uploadQueue);
+		clFlush(ctx->queue);
+		clFlush(ctx->downloadQueue);
+	}
+
+	clFinish(ctx->uploadQueue);
+	clFinish(ctx->queue);
+	clFinish(ctx->downloadQueue);
+
+	// Overlap is the sum of all command times less the time from the first upload to the last download
+	cl_ulong firstStartTime = ~(cl_ulong)0, lastEndTime = 0;
+	cl_ulong commandTime = 0, kernelTime = 0;
+
+	for (size_t i = 0; i < eventNum && !errCode; i++)
+	{
+		cl_ulong startTime, endTime;
+
+		errCodeReturn = clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &startTime, NULL);
+		errCodeReturn |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &endTime, NULL);
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+			errCode = 1;
+			break;
+		}
+
+		firstStartTime = startTime < firstStartTime ? startTime : firstStartTime;
+		lastEndTime = endTime > lastEndTime ? endTime : lastEndTime;
+		commandTime += endTime - startTime;
+
+		if (&events[i] >= kernelEvents && &events[i] < downloadEvents)
+			kernelTime += endTime - startTime;
+	}
+
+	eventsRelease(events, eventNum);
+	free(events);
+	buffersReturning(&ctx->bufferPool, mems, memNum);
+
+	if (errCode)
+		return 1;
+
+	if (timing != NULL)
+	{
+		timing->kernelTime = kernelTime / 1000000.0;
+		timing->transferTime = (lastEndTime - firstStartTime) / 1000000.0;
+		timing->overlapTime = commandTime > lastEndTime - firstStartTime ? (commandTime - (lastEndTime - firstStartTime)) / 1000000.0 : 0;
+		timing->params = *params;
+	}
+
+	return 0;
+}
+
+// The crossover can be tuned per device with MATMUL_STRASSEN_CROSSOVER
+unsigned int strassenCrossover(void)
+{
+	const char* crossoverStr = getenv(STRASSEN_CROSSOVER_ENV);
+	if (crossoverStr != NULL && atoi(crossoverStr) > 0)
+		return (unsigned int)atoi(crossoverStr);
+
+	return STRASSEN_CROSSOVER;
+}
+
+// Halvings until the smallest dimension is down to the crossover, 0 for products too small to split
+unsigned int strassenLevels(unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond)
+{
+	unsigned int minDim = rowFirstMatrix < colSecondMatrix ? rowFirstMatrix : colSecondMatrix;
+	if (colFirstRowSecond < minDim)
+		minDim = colFirstRowSecond;
+
+	const unsigned int crossover = strassenCrossover();
+
+	unsigned int levelNum = 0;
+	while (levelNum < STRASSEN_LEVEL_MAX && (minDim >> levelNum) > crossover)
+		levelNum++;
+
+	return levelNum;
+}
+
+// A matrix kept on the device: its first element is offset elements into mem and its stored rows are leadingDim elements apart
+struct deviceMatrix
+{
+	cl_mem mem;
+	size_t offset;
+	unsigned int leadingDim;
+};
+
+// Shared by the whole recursion: the leaf and addition kernels, the arena whose temporaries every level takes on the way down
+// and gives back on the way up, and the events of all the kernels
+struct strassenWorkspace
+{
+	cl_command_queue queue;
+	int implementationType;
+	cl_kernel productKernel;
+	struct kernelParams productParams;
+	cl_kernel additionKernel;
+	size_t additionGroupSize;
+	unsigned int levelNum;
+	cl_mem arena;
+	size_t arenaTop;
+	cl_event* events;
+	size_t eventNum;
+};
+
+void quadrantsSplitting(const struct deviceMatrix* matrix, unsigned int rowNum, unsigned int colNum, struct deviceMatrix* quadrants)
+{
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		quadrants[i].mem = matrix->mem;
+		quadrants[i].offset = matrix->offset + (size_t)(i / 2) * (rowNum / 2) * matrix->leadingDim + (size_t)(i % 2) * (colNum / 2);
+		quadrants[i].leadingDim = matrix->leadingDim;
+	}
+}
+
+// resultMatrix = firstMatrix + secondSign * secondMatrix
+cl_int strassenAddition(struct strassenWorkspace* workspace, const struct deviceMatrix* resultMatrix, const struct deviceMatrix* firstMatrix,
+	const struct deviceMatrix* secondMatrix, cl_float secondSign, unsigned int rowNum, unsigned int colNum)
+{
+	const cl_ulong offsets[3] = { firstMatrix->offset, secondMatrix->offset, resultMatrix->offset };
+	cl_kernel kernel = workspace->additionKernel;
+
+	cl_int errCodeReturn = clSetKernelArg(kernel, 0, sizeof(cl_mem), &firstMatrix->mem);
+	errCodeReturn |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &secondMatrix->mem);
+	errCodeReturn |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &resultMatrix->mem);
+	errCodeReturn |= clSetKernelArg(kernel, 3, sizeof(cl_uint), &colNum);
+	errCodeReturn |= clSetKernelArg(kernel, 4, sizeof(cl_uint), &rowNum);
+	errCodeReturn |= clSetKernelArg(kernel, 5, sizeof(cl_float), &secondSign);
+	errCodeReturn |= clSetKernelArg(kernel, 6, sizeof(cl_ulong), &offsets[0]);
+	errCodeReturn |= clSetKernelArg(kernel, 7, sizeof(cl_ulong), &offsets[1]);
+	errCodeReturn |= clSetKernelArg(kernel, 8, sizeof(cl_ulong), &offsets[2]);
+	errCodeReturn |= clSetKernelArg(kernel, 9, sizeof(cl_uint), &firstMatrix->leadingDim);
+	errCodeReturn |= clSetKernelArg(kernel, 10, sizeof(cl_uint), &secondMatrix->leadingDim);
+	errCodeReturn |= clSetKernelArg(kernel, 11, sizeof(cl_uint), &resultMatrix->leadingDim);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		return errCodeReturn;
+	}
+
+	const size_t groupSize = workspace->additionGroupSize;
+	const size_t global_item_size[2] = { dimensionAlignment(colNum, groupSize), dimensionAlignment(rowNum, groupSize) };
+	const size_t local_item_size[2] = { groupSize, groupSize };
+
+	errCodeReturn = clEnqueueNDRangeKernel(workspace->queue, kernel, 2, NULL, global_item_size, local_item_size, 0, NULL, &workspace->events[workspace->eventNum]);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+		return errCodeReturn;
+	}
+
+	workspace->eventNum++;
+	return CL_SUCCESS;
+}
+
+// A leaf is multiplied by the usual kernel on sub-buffers of the views, whose offsets the kernels do not take
+cl_int strassenLeafProduct(struct strassenWorkspace* workspace, const struct deviceMatrix* resultMatrix, const struct deviceMatrix* firstMatrix,
+	const struct deviceMatrix* secondMatrix, unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond)
+{
+	const struct deviceMatrix* matrices[3] = { firstMatrix, secondMatrix, resultMatrix };
+	const unsigned int rowNums[3] = { rowFirstMatrix, colFirstRowSecond, rowFirstMatrix };
+	const unsigned int colNums[3] = { colFirstRowSecond, colSecondMatrix, colSecondMatrix };
+
+	cl_mem subBuffers[3] = { NULL, NULL, NULL };
+	cl_int errCodeReturn = CL_SUCCESS;
+
+	for (size_t i = 0; i < 3 && errCodeReturn == CL_SUCCESS; i++)
+	{
+		const cl_buffer_region region = { matrices[i]->offset * sizeof(cl_float),
+			((size_t)(rowNums[i] - 1) * matrices[i]->leadingDim + colNums[i]) * sizeof(cl_float) };
+
+		subBuffers[i] = clCreateSubBuffer(matrices[i]->mem, 0, CL_BUFFER_CREATE_TYPE_REGION, &region, &errCodeReturn);
+	}
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clCreateSubBuffer");
+		memObjectsRelease(subBuffers, 3);
+		return errCodeReturn;
+	}
+
+	const int implementationType = workspace->implementationType;
+	const struct kernelParams* params = &workspace->productParams;
+	const struct matmulLeadingDims leadingDims = { firstMatrix->leadingDim, secondMatrix->leadingDim, resultMatrix->leadingDim };
+	const unsigned int alignedColRowSize = dimensionAlignment(colFirstRowSecond, params->localGroupSize) / params->localGroupSize;
+	cl_kernel kernel = workspace->productKernel;
+
+	errCodeReturn = clSetKernelArg(kernel, 0, sizeof(cl_mem), &subBuffers[0]);
+	errCodeReturn |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &subBuffers[1]);
+	errCodeReturn |= clSetKernelArg(kernel, 2, sizeof(cl_mem), &subBuffers[2]);
+	errCodeReturn |= clSetKernelArg(kernel, 3, sizeof(cl_uint), &colFirstRowSecond);
+	errCodeReturn |= clSetKernelArg(kernel, 4, sizeof(cl_uint), &colSecondMatrix);
+
+	if (implementationType != 1)
+	{
+		errCodeReturn |= clSetKernelArg(kernel, 5, sizeof(cl_uint), &rowFirstMatrix);
+		errCodeReturn |= clSetKernelArg(kernel, 6, sizeof(cl_uint), &alignedColRowSize);
+	}
+
+	errCodeReturn |= leadingDimsArgsSetting(kernel, implementationType == 1 ? 5 : 7, &leadingDims);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		memObjectsRelease(subBuffers, 3);
+		return errCodeReturn;
+	}
+
+	size_t global_item_size[3] = { colSecondMatrix, rowFirstMatrix, 1 };
+	const size_t local_item_size[3] = { params->localGroupSize / params->vectorWidth, params->localGroupSize, 1 };
+
+	if (implementationType != 1)
+	{
+		global_item_size[0] = dimensionAlignment(colSecondMatrix, params->localGroupSize * params->tileCols) / (params->vectorWidth * params->tileCols);
+		global_item_size[1] = dimensionAlignment(rowFirstMatrix, params->localGroupSize * params->tileRows) / params->tileRows;
+	}
+
+	errCodeReturn = clEnqueueNDRangeKernel(workspace->queue, kernel, 3, NULL, global_item_size, implementationType == 1 ? NULL : local_item_size,
+		0, NULL, &workspace->events[workspace->eventNum]);
+
+	// The kernel keeps its own references to the sub-buffers
+	memObjectsRelease(subBuffers, 3);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+		return errCodeReturn;
+	}
+
+	workspace->eventNum++;
+	return CL_SUCCESS;
+}
+
+// Winograd's variant in the schedule of Boyer et al., which needs only two temporaries per level: X for sums of first matrix
+// quadrants and Y for sums of second matrix quadrants, with X later reused as P for the product A11 * B11. Each step is
+// result = first + sign * second, or result = first * second for sign 0, on the operands
+// A11 A12 A21 A22 B11 B12 B21 B22 C11 C12 C21 C22 X Y P
+unsigned char strassenProduct(struct strassenWorkspace* workspace, const struct deviceMatrix* resultMatrix, const struct deviceMatrix* firstMatrix,
+	const struct deviceMatrix* secondMatrix, unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int level)
+{
+	static const int schedule[22][4] = {
+		{ -1, 12, 0, 2 },	// X = A11 - A21
+		{ -1, 13, 7, 5 },	// Y = B22 - B12
+		{ 0, 10, 12, 13 },	// C21 = X * Y
+		{ 1, 12, 2, 3 },	// X = A21 + A22
+		{ -1, 13, 5, 4 },	// Y = B12 - B11
+		{ 0, 11, 12, 13 },	// C22 = X * Y
+		{ -1, 12, 12, 0 },	// X = X - A11
+		{ -1, 13, 7, 13 },	// Y = B22 - Y
+		{ 0, 9, 12, 13 },	// C12 = X * Y
+		{ -1, 12, 1, 12 },	// X = A12 - X
+		{ 0, 8, 12, 7 },	// C11 = X * B22
+		{ 0, 14, 0, 4 },	// P = A11 * B11
+		{ 1, 9, 14, 9 },	// C12 = P + C12
+		{ 1, 10, 9, 10 },	// C21 = C12 + C21
+		{ 1, 9, 9, 11 },	// C12 = C12 + C22
+		{ 1, 11, 10, 11 },	// C22 = C21 + C22
+		{ 1, 9, 9, 8 },		// C12 = C12 + C11
+		{ -1, 13, 13, 6 },	// Y = Y - B21
+		{ 0, 8, 3, 13 },	// C11 = A22 * Y
+		{ -1, 10, 10, 8 },	// C21 = C21 - C11
+		{ 0, 8, 1, 6 },		// C11 = A12 * B21
+		{ 1, 8, 14, 8 } };	// C11 = P + C11
+
+	if (level == workspace->levelNum)
+		return strassenLeafProduct(workspace, resultMatrix, firstMatrix, secondMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond) != CL_SUCCESS;
+
+	const unsigned int halfRowNum = rowFirstMatrix / 2;
+	const unsigned int halfColNum = colSecondMatrix / 2;
+	const unsigned int halfColRowNum = colFirstRowSecond / 2;
+	const size_t arenaTop = workspace->arenaTop;
+
+	struct deviceMatrix operands[15];
+	quadrantsSplitting(firstMatrix, rowFirstMatrix, colFirstRowSecond, &operands[0]);
+	quadrantsSplitting(secondMatrix, colFirstRowSecond, colSecondMatrix, &operands[4]);
+	quadrantsSplitting(resultMatrix, rowFirstMatrix, colSecondMatrix, &operands[8]);
+
+	const struct deviceMatrix X = { workspace->arena, arenaTop, halfColRowNum };
+	const struct deviceMatrix Y = { workspace->arena, arenaTop + (size_t)halfRowNum * (halfColRowNum > halfColNum ? halfColRowNum : halfColNum), halfColNum };
+	const struct deviceMatrix P = { workspace->arena, arenaTop, halfColNum };
+	operands[12] = X;
+	operands[13] = Y;
+	operands[14] = P;
+	workspace->arenaTop = Y.offset + (size_t)halfColRowNum * halfColNum;
+
+	unsigned char errCode = 0;
+	for (size_t i = 0; i < 22 && !errCode; i++)
+	{
+		const struct deviceMatrix* result = &operands[schedule[i][1]];
+		const struct deviceMatrix* first = &operands[schedule[i][2]];
+		const struct deviceMatrix* second = &operands[schedule[i][3]];
+
+		if (!schedule[i][0])
+		{
+			errCode = strassenProduct(workspace, result, first, second, halfRowNum, halfColNum, halfColRowNum, level + 1);
+			continue;
+		}
+
+		// Sums take the shape of the quadrants they are made of
+		const int resultOperand = schedule[i][1];
+		const unsigned char firstShaped = resultOperand < 4 || resultOperand == 12;
+		const unsigned char secondShaped = (resultOperand >= 4 && resultOperand < 8) || resultOperand == 13;
+		const unsigned int rowNum = secondShaped ? halfColRowNum : halfRowNum;
+		const unsigned int colNum = firstShaped ? halfColRowNum : halfColNum;
+
+		errCode = strassenAddition(workspace, result, first, second, (cl_float)schedule[i][0], rowNum, colNum) != CL_SUCCESS;
+	}
+
+	workspace->arenaTop = arenaTop;
+	return errCode;
+}
+
+unsigned char matmulStrassenExecution(struct matmulContext* ctx, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int levelNum,
+	int implementationType, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, struct matmulTiming* timing)
+{
+	struct strassenWorkspace workspace;
+	workspace.queue = ctx->queue;
+	workspace.implementationType = implementationType;
+	workspace.levelNum = levelNum;
+	workspace.arenaTop = 0;
+	workspace.eventNum = 0;
+
+	// The kernels array may grow with the second kernel, so the first is taken out of it before
+	struct matmulKernel* kernel;
+	if (kernelPreparation(ctx, implementationType, ELEMENT_TYPE_FLOAT, 0, KERNEL_VARIANT_PLAIN, params, NULL, &kernel))
+		return 1;
+
+	workspace.productKernel = kernel->kernel;
+	workspace.productParams = kernel->params;
+
+	struct kernelParams additionParams;
+	kernelDefaultParams(ctx->device, IMPLEMENTATION_ADDITION, &additionParams);
+
+	if (kernelPreparation(ctx, IMPLEMENTATION_ADDITION, ELEMENT_TYPE_FLOAT, 0, KERNEL_VARIANT_PLAIN, &additionParams, NULL, &kernel))
+		return 1;
+
+	workspace.additionKernel = kernel->kernel;
+	workspace.additionGroupSize = kernel->params.localGroupSize;
+
+	// Sub-buffers must start on the base address alignment of the device, so the matrices are padded with zeros to a multiple
+	// of it for each level; every quadrant down to the leaves then starts on it
+	cl_uint baseAddressAlignment;
+	cl_int errCodeReturn = clGetDeviceInfo(ctx->device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(cl_uint), &baseAddressAlignment, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+		return 1;
+	}
+
+	size_t dimAlignment = baseAddressAlignment / 8 / sizeof(cl_float);
+	if (!dimAlignment)
+		dimAlignment = 1;
+
+	dimAlignment <<= levelNum;
+
+	const unsigned int paddedRowNum = dimensionAlignment(rowFirstMatrix, dimAlignment);
+	const unsigned int paddedColNum = dimensionAlignment(colSecondMatrix, dimAlignment);
+	const unsigned int paddedColRowNum = dimensionAlignment(colFirstRowSecond, dimAlignment);
+
+	// Each level takes X, as large as a quadrant of the first matrix or of the result, and Y, as large as a quadrant of the second
+	size_t arenaSize = 0;
+	size_t kernelNum = 1;
+	for (unsigned int level = 1; level <= levelNum; level++)
+	{
+		const size_t halfRowNum = paddedRowNum >> level;
+		const size_t halfColNum = paddedColNum >> level;
+		const size_t halfColRowNum = paddedColRowNum >> level;
+
+		arenaSize += halfRowNum * (halfColRowNum > halfColNum ? halfColRowNum : halfColNum) + halfColRowNum * halfColNum;
+		kernelNum = kernelNum * 7 + 15;
+	}
+
+	cl_mem mems[4] = { NULL, NULL, NULL, NULL };
+	if (bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * paddedRowNum * paddedColRowNum, CL_MEM_READ_ONLY, &mems[0])
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * paddedColRowNum * paddedColNum, CL_MEM_READ_ONLY, &mems[1])
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * paddedRowNum * paddedColNum, CL_MEM_READ_WRITE, &mems[2])
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * arenaSize, CL_MEM_READ_WRITE, &mems[3]))
+	{
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	workspace.arena = mems[3];
+	workspace.events = (cl_event*)calloc(kernelNum, sizeof(cl_event));
+	if (workspace.events == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		buffersReturning(&ctx->bufferPool, mems, 4);
+		return 1;
+	}
+
+	cl_event transferEvents[2] = { NULL, NULL };
+	const cl_float zero = 0.0f;
+
+	if (paddedRowNum != rowFirstMatrix || paddedColRowNum != colFirstRowSecond)
+		errCodeReturn = clEnqueueFillBuffer(ctx->queue, mems[0], &zero, sizeof(cl_float), 0, sizeof(cl_float) * paddedRowNum * paddedColRowNum, 0, NULL, &transferEvents[0]);
+
+	if (errCodeReturn == CL_SUCCESS && (paddedColRowNum != colFirstRowSecond || paddedColNum != colSecondMatrix))
+		errCodeReturn = clEnqueueFillBuffer(ctx->queue, mems[1], &zero, sizeof(cl_float), 0, sizeof(cl_float) * paddedColRowNum * paddedColNum, 0, NULL,
+			transferEvents[0] == NULL ? &transferEvents[0] : NULL);
+
+	if (errCodeReturn != CL_SUCCESS)
+		errCodeOutput(errCodeReturn, "clEnqueueFillBuffer");
+
+	if (errCodeReturn == CL_SUCCESS)
+	{
+		errCodeReturn = matrixUploading(ctx->queue, mems[0], paddedColRowNum, firstMatrix, leadingDims->first, rowFirstMatrix, colFirstRowSecond, sizeof(cl_float),
+			0, NULL, transferEvents[0] == NULL ? &transferEvents[0] : NULL);
+
+		if (errCodeReturn == CL_SUCCESS)
+			errCodeReturn = matrixUploading(ctx->queue, mems[1], paddedColNum, secondMatrix, leadingDims->second, colFirstRowSecond, colSecondMatrix, sizeof(cl_float),
+				0, NULL, NULL);
+
+		if (errCodeReturn != CL_SUCCESS)
+			errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+	}
+
+	const struct deviceMatrix first = { mems[0], 0, paddedColRowNum };
+	const struct deviceMatrix second = { mems[1], 0, paddedColNum };
+	const struct deviceMatrix result = { mems[2], 0, paddedColNum };
+
+	unsigned char errCode = errCodeReturn != CL_SUCCESS
+		|| strassenProduct(&workspace, &result, &first, &second, paddedRowNum, paddedColNum, paddedColRowNum, 0);
+
+	if (!errCode)
+	{
+		errCodeReturn = matrixDownloading(ctx->queue, mems[2], paddedColNum, resultMatrix, leadingDims->result, rowFirstMatrix, colSecondMatrix, sizeof(cl_float),
+			CL_TRUE, 0, NULL, &transferEvents[1]);
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clEnqueueReadBuffer");
+			errCode = 1;
+		}
+	}
+
+	clFinish(ctx->queue);
+
+	// The kernel time is that of the leaf products and additions together
+	cl_ulong kernelTime = 0;
+	cl_ulong transfer_start_time, transfer_end_time;
+
+	for (size_t i = 0; i < workspace.eventNum && !errCode; i++)
+	{
+		cl_ulong kernel_start_time, kernel_end_time;
+
+		errCodeReturn = clGetEventProfilingInfo(workspace.events[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start_time, NULL);
+		errCodeReturn |= clGetEventProfilingInfo(workspace.events[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end_time, NULL);
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+			errCode = 1;
+		}
+
+		kernelTime += kernel_end_time - kernel_start_time;
+	}
+
+	if (!errCode)
+	{
+		errCodeReturn = clGetEventProfilingInfo(transferEvents[0], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &transfer_start_time, NULL);
+		errCodeReturn |= clGetEventProfilingInfo(transferEvents[1], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &transfer_end_time, NULL);
+		if (errCodeReturn != CL_SUCCESS)
+		{
+			errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+			errCode = 1;
+		}
+	}
+
+	eventsRelease(workspace.events, workspace.eventNum);
+	eventsRelease(transferEvents, 2);
+	free(workspace.events);
+	buffersReturning(&ctx->bufferPool, mems, 4);
+
+	if (errCode)
+		return 1;
+
+	if (timing != NULL)
+	{
+		timing->kernelTime = kernelTime / 1000000.0;
+		timing->transferTime = (transfer_end_time - transfer_start_time) / 1000000.0;
+		timing->overlapTime = 0;
+		timing->params = *params;
+	}
+
+	return 0;
+}
+
+unsigned char matmul(struct matmulContext* ctx, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	const struct matmulOptions* options, struct matmulTiming* timing)
+{
+	return matmulBatched(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, 1, options, timing);
+}
+
+unsigned char matmulBatched(struct matmulContext* ctx, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	const struct matmulOptions* options, struct matmulTiming* timing)
+{
+	// The native CPU backend always multiplies the float matrices
+	if (options == NULL || options->elementType == ELEMENT_TYPE_FLOAT || ctx->native)
+	{
+		struct matmulOptions floatOptions = { options != NULL ? options->implementationType : 2, ELEMENT_TYPE_FLOAT, options != NULL ? options->layout : 0,
+			options != NULL && options->pipelined, options != NULL ? options->epilogue : NULL, options != NULL ? options->leadingDims : NULL,
+			options != NULL && options->strassen, options != NULL && options->exactKernel };
+		return matmulTypedBatched(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, batchNum, &floatOptions, timing);
+	}
+
+	if (options->elementType != ELEMENT_TYPE_HALF)
+	{
+		fprintf(stderr, "Double and int8 matrices are multiplied with matmulTypedBatched!\n");
+		return 1;
+	}
+
+	struct matmulLeadingDims leadingDims;
+	if (leadingDimsResolving(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, options->layout, options->leadingDims, &leadingDims))
+	{
+		fprintf(stderr, "Incorrect leading dimension!\n");
+		return 1;
+	}
+
+	// Half matrices are converted on the host into packed copies, in host allocations so devices sharing memory with the host
+	// can still use them in place
+	unsigned int firstShape[2], secondShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, options->layout, firstShape, secondShape);
+
+	const size_t firstMatrixSize = (size_t)rowFirstMatrix * colFirstRowSecond * batchNum;
+	const size_t secondMatrixSize = (size_t)colFirstRowSecond * colSecondMatrix * batchNum;
+	const size_t resultMatrixSize = (size_t)rowFirstMatrix * colSecondMatrix * batchNum;
+
+	cl_half* halfFirstMatrix = (cl_half*)matmulHostAllocation((firstMatrixSize + 1) / 2);
+	cl_half* halfSecondMatrix = (cl_half*)matmulHostAllocation((secondMatrixSize + 1) / 2);
+	cl_half* halfResultMatrix = (cl_half*)matmulHostAllocation((resultMatrixSize + 1) / 2);
+
+	if (halfFirstMatrix == NULL || halfSecondMatrix == NULL || halfResultMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		matmulHostRelease((float*)halfFirstMatrix);
+		matmulHostRelease((float*)halfSecondMatrix);
+		matmulHostRelease((float*)halfResultMatrix);
+		return 1;
+	}
+
+	halfRowsConversion(firstMatrix, leadingDims.first, halfFirstMatrix, (size_t)firstShape[0] * batchNum, firstShape[1]);
+	halfRowsConversion(secondMatrix, leadingDims.second, halfSecondMatrix, (size_t)secondShape[0] * batchNum, secondShape[1]);
+
+	if (options->epilogue != NULL && options->epilogue->beta != 0)
+		halfRowsConversion(resultMatrix, leadingDims.result, halfResultMatrix, (size_t)rowFirstMatrix * batchNum, colSecondMatrix);
+
+	struct matmulOptions halfOptions = *options;
+	halfOptions.leadingDims = NULL;
+
+	unsigned char errCode = matmulTypedBatched(ctx, halfFirstMatrix, halfSecondMatrix, halfResultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, batchNum,
+		&halfOptions, timing);
+
+	if (!errCode)
+		floatRowsConversion(halfResultMatrix, resultMatrix, leadingDims.result, (size_t)rowFirstMatrix * batchNum, colSecondMatrix);
+
+	matmulHostRelease((float*)halfFirstMatrix);
+	matmulHostRelease((float*)halfSecondMatrix);
+	matmulHostRelease((float*)halfResultMatrix);
+	return errCode;
+}
+
+unsigned char matmulTypedBatched(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	const struct matmulOptions* options, struct matmulTiming* timing)
+{
+	const int implementationType = options != NULL ? options->implementationType : 2;
+	const int elementType = options != NULL ? options->elementType : ELEMENT_TYPE_FLOAT;
+	const int layout = options != NULL ? options->layout : 0;
+
+	if (1 > implementationType || implementationType > IMPLEMENTATION_TYPE_NUM)
+	{
+		fprintf(stderr, "Incorrect implementation type!\n");
+		return 1;
+	}
+
+	if (0 > elementType || elementType >= ELEMENT_TYPE_NUM)
+	{
+		fprintf(stderr, "Incorrect element type!\n");
+		return 1;
+	}
+
+	if (0 > layout || layout >= LAYOUT_NUM)
+	{
+		fprintf(stderr, "Incorrect layout!\n");
+		return 1;
+	}
+
+	if (!batchNum)
+	{
+		fprintf(stderr, "Invalid batch size!\n");
+		return 1;
+	}
+
+	struct matmulLeadingDims leadingDims;
+	if (leadingDimsResolving(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, options != NULL ? options->leadingDims : NULL, &leadingDims))
+	{
+		fprintf(stderr, "Incorrect leading dimension!\n");
+		return 1;
+	}
+
+	const struct matmulEpilogue* epilogue = options != NULL ? options->epilogue : NULL;
+	if (epilogue != NULL && (0 > epilogue->activation || epilogue->activation >= ACTIVATION_NUM))
+	{
+		fprintf(stderr, "Incorrect activation!\n");
+		return 1;
+	}
+
+	// A first matrix of mostly zeros is compressed and multiplied by the sparse kernel, which skips the zeros. An explicit kernel,
+	// Strassen or pipelined run is kept as asked, and counting stops once the matrix is known to be dense enough
+	const size_t firstRowStride = layout & LAYOUT_FIRST_TRANSPOSED ? 1 : leadingDims.first;
+	const size_t firstColStride = layout & LAYOUT_FIRST_TRANSPOSED ? leadingDims.first : 1;
+	const size_t sparseNonZeroLimit = (size_t)(SPARSE_DENSITY_THRESHOLD * rowFirstMatrix * colFirstRowSecond);
+
+	if (elementType == ELEMENT_TYPE_FLOAT && batchNum == 1 && rowFirstMatrix && colFirstRowSecond
+		&& (options == NULL || (!options->exactKernel && !options->strassen && !options->pipelined))
+		&& nonZeroCounting(firstMatrix, rowFirstMatrix, colFirstRowSecond, firstRowStride, firstColStride, sparseNonZeroLimit) < sparseNonZeroLimit)
+	{
+		struct csrMatrix csr;
+		if (csrBuilding(firstMatrix, rowFirstMatrix, colFirstRowSecond, firstRowStride, firstColStride, &csr))
+			return 1;
+
+		struct matmulOptions sparseOptions = { implementationType, elementType, layout & LAYOUT_SECOND_TRANSPOSED, 0, epilogue, &leadingDims, 0, 0 };
+		unsigned char errCode = matmulSparse(ctx, &csr, secondMatrix, resultMatrix, colSecondMatrix, &sparseOptions, timing);
+
+		csrRelease(&csr);
+		return errCode;
+	}
+
+	// Large products split into leaves down to the crossover when asked for; the leaf kernel's parameters are those of the leaf shape
+	unsigned int strassenLevelNum = 0;
+	if (options != NULL && options->strassen && !ctx->native && elementType == ELEMENT_TYPE_FLOAT && layout == 0 && batchNum == 1 && epilogue == NULL)
+		strassenLevelNum = strassenLevels(rowFirstMatrix, colSecondMatrix, colFirstRowSecond);
+
+	struct kernelParams params = { 1, 1, 1, 1 };
+	if (!ctx->native)
+	{
+		kernelParamsSelection(ctx, implementationType, rowFirstMatrix >> strassenLevelNum, colSecondMatrix >> strassenLevelNum, colFirstRowSecond >> strassenLevelNum,
+			&params);
+
+		if (elementType == ELEMENT_TYPE_DOUBLE)
+		{
+			char* extensions;
+			if (deviceStringInfo(ctx->device, CL_DEVICE_EXTENSIONS, &extensions))
+				return 1;
+
+			const unsigned char doubleSupported = strstr(extensions, "cl_khr_fp64") != NULL;
+			free(extensions);
+
+			if (!doubleSupported)
+			{
+				fprintf(stderr, "The device does not support double precision!\n");
+				return 1;
+			}
+
+			// Double tiles take twice the local memory the parameters were chosen for
+			while (params.localGroupSize > params.vectorWidth && kernelParamsValidation(ctx->device, implementationType, &params, sizeof(cl_double)))
+				params.localGroupSize /= 2;
+		}
+	}
+
+	if (strassenLevelNum)
+		return matmulStrassenExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, strassenLevelNum,
+			implementationType, &leadingDims, &params, timing);
+
+	// A batch is already a single launch, so it is not split into panels
+	if (options != NULL && options->pipelined && batchNum == 1)
+		return matmulPipelinedExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond,
+			implementationType, elementType, layout, &leadingDims, &params, epilogue, timing);
+
+	// A result of only a few columns or rows is a product of the matrix with a few vectors, whose dot products along K
+	// the matrix-vector kernel sums within work-groups instead of padding the tiles of the other kernels
+	if (!ctx->native && batchNum == 1 && (options == NULL || !options->exactKernel))
+	{
+		struct kernelParams gemvParams;
+		kernelDefaultParams(ctx->device, IMPLEMENTATION_GEMV, &gemvParams);
+
+		if (gemvSelection(ctx->device, implementationType, elementType, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, &params, &gemvParams))
+			return matmulGemvExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond,
+				elementType, layout, &leadingDims, &gemvParams, epilogue, timing);
+	}
+
+	// Small results of a long K are split along it, so that there are enough work-groups for all compute units
+	const unsigned int sliceNum = !ctx->native && batchNum == 1
+		? splitKSlices(ctx->device, implementationType, elementType, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, &params) : 1;
+
+	if (sliceNum > 1)
+		return matmulSplitKExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, sliceNum,
+			implementationType, elementType, layout, &leadingDims, &params, epilogue, timing);
+
+	return matmulExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, batchNum,
+		implementationType, elementType, layout, &leadingDims, &params, epilogue, timing);
+}
+
+// Rows of uneven length are balanced by the row blocks, each taken by one work-group; the first leading dimension is not used
+unsigned char matmulSparse(struct matmulContext* ctx, const struct csrMatrix* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int colSecondMatrix, const struct matmulOptions* options, struct matmulTiming* timing)
+{
+	const unsigned int rowFirstMatrix = firstMatrix->rowNum;
+	const unsigned int colFirstRowSecond = firstMatrix->colNum;
+	const int layout = options != NULL ? options->layout : 0;
+	const struct matmulEpilogue* epilogue = options != NULL ? options->epilogue : NULL;
+
+	if (options != NULL && options->elementType != ELEMENT_TYPE_FLOAT)
+	{
+		fprintf(stderr, "Sparse matrices are only multiplied as float!\n");
+		return 1;
+	}
+
+	if (0 > layout || layout >= LAYOUT_NUM || layout & LAYOUT_FIRST_TRANSPOSED)
+	{
+		fprintf(stderr, "Incorrect layout!\n");
+		return 1;
+	}
+
+	if (epilogue != NULL && (0 > epilogue->activation || epilogue->activation >= ACTIVATION_NUM))
+	{
+		fprintf(stderr, "Incorrect activation!\n");
+		return 1;
+	}
+
+	struct matmulLeadingDims leadingDims;
+	if (options != NULL && options->leadingDims != NULL)
+	{
+		leadingDims = *options->leadingDims;
+		leadingDims.first = colFirstRowSecond;
+	}
+
+	if (leadingDimsResolving(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, options != NULL && options->leadingDims != NULL ? &leadingDims : NULL,
+		&leadingDims))
+	{
+		fprintf(stderr, "Incorrect leading dimension!\n");
+		return 1;
+	}
+
+	struct kernelParams params = { 1, 1, 1, 1 };
+
+	if (ctx->native)
+	{
+		if (epilogue != NULL)
+		{
+			fprintf(stderr, "The native backend has no epilogue!\n");
+			return 1;
+		}
+
+		double computeTime;
+		cpuSparseMatmul(firstMatrix->rowPointers, firstMatrix->colIndices, firstMatrix->values, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix,
+			layout, leadingDims.second, leadingDims.result, &computeTime);
+
+		if (timing != NULL)
+		{
+			timing->kernelTime = computeTime;
+			timing->transferTime = computeTime;
+			timing->overlapTime = 0;
+			timing->params = params;
+		}
+
+		return 0;
+	}
+
+	if (!rowFirstMatrix || !colSecondMatrix)
+	{
+		if (timing != NULL)
+			memset(timing, 0, sizeof(struct matmulTiming));
+
+		return 0;
+	}
+
+	kernelDefaultParams(ctx->device, IMPLEMENTATION_SPARSE, &params);
+
+	struct matmulKernel* kernel;
+	if (kernelPreparation(ctx, IMPLEMENTATION_SPARSE, ELEMENT_TYPE_FLOAT, layout, KERNEL_VARIANT_PLAIN, &params, epilogue, &kernel))
+		return 1;
+
+	unsigned int* rowBlocks;
+	unsigned int blockNum;
+	if (rowBlocksBuilding(firstMatrix, &rowBlocks, &blockNum))
+		return 1;
+
+	unsigned int secondShape[2], firstShape[2];
+	storedShapes(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, firstShape, secondShape);
+
+	const unsigned int nonZeroNum = firstMatrix->rowPointers[rowFirstMatrix];
+	const size_t secondMatrixSize = (size_t)secondShape[0] * leadingDims.second;
+	const unsigned char resultReading = epilogue != NULL && epilogue->beta != 0;
+
+	cl_mem mems[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+	cl_mem* rowBlocksMem = &mems[0];
+	cl_mem* rowPointersMem = &mems[1];
+	cl_mem* colIndicesMem = &mems[2];
+	cl_mem* valuesMem = &mems[3];
+	cl_mem* secondMatrixMem = &mems[4];
+	cl_mem* resultMatrixMem = &mems[5];
+	cl_mem* biasMem = &mems[6];
+
+	// Buffers are never empty, even for a first matrix without nonzeros
+	if (bufferAcquiring(&ctx->bufferPool, sizeof(cl_uint) * ((size_t)blockNum + 1), CL_MEM_READ_ONLY, rowBlocksMem)
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_uint) * ((size_t)rowFirstMatrix + 1), CL_MEM_READ_ONLY, rowPointersMem)
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_uint) * (nonZeroNum ? nonZeroNum : 1), CL_MEM_READ_ONLY, colIndicesMem)
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * (nonZeroNum ? nonZeroNum : 1), CL_MEM_READ_ONLY, valuesMem)
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * (secondMatrixSize ? secondMatrixSize : 1), CL_MEM_READ_ONLY, secondMatrixMem)
+		|| bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * rowFirstMatrix * leadingDims.result, resultReading ? CL_MEM_READ_WRITE : CL_MEM_WRITE_ONLY, resultMatrixMem)
+		|| (epilogue != NULL && epilogue->bias != NULL && bufferAcquiring(&ctx->bufferPool, sizeof(cl_float) * colSecondMatrix, CL_MEM_READ_ONLY, biasMem)))
+	{
+		free(rowBlocks);
+		buffersReturning(&ctx->bufferPool, mems, 7);
+		return 1;
+	}
+
+	cl_event events[3] = { NULL, NULL, NULL };
+	cl_event* event_start_transfer = &events[0];
+	cl_event* event_kernel = &events[1];
+	cl_event* event_end_transfer = &events[2];
+
+	cl_int errCodeReturn = clEnqueueWriteBuffer(ctx->queue, *rowBlocksMem, CL_FALSE, 0, sizeof(cl_uint) * ((size_t)blockNum + 1), rowBlocks, 0, NULL,
+		event_start_transfer);
+	errCodeReturn |= clEnqueueWriteBuffer(ctx->queue, *rowPointersMem, CL_FALSE, 0, sizeof(cl_uint) * ((size_t)rowFirstMatrix + 1), firstMatrix->rowPointers, 0, NULL, NULL);
+
+	if (nonZeroNum)
+	{
+		errCodeReturn |= clEnqueueWriteBuffer(ctx->queue, *colIndicesMem, CL_FALSE, 0, sizeof(cl_uint) * nonZeroNum, firstMatrix->colIndices, 0, NULL, NULL);
+		errCodeReturn |= clEnqueueWriteBuffer(ctx->queue, *valuesMem, CL_FALSE, 0, sizeof(cl_float) * nonZeroNum, firstMatrix->values, 0, NULL, NULL);
+	}
+
+	if (secondMatrixSize)
+		errCodeReturn |= matrixUploading(ctx->queue, *secondMatrixMem, leadingDims.second, secondMatrix, leadingDims.second, secondShape[0], secondShape[1],
+			sizeof(cl_float), 0, NULL, NULL);
+
+	if (resultReading)
+		errCodeReturn |= matrixUploading(ctx->queue, *resultMatrixMem, leadingDims.result, resultMatrix, leadingDims.result, rowFirstMatrix, colSecondMatrix,
+			sizeof(cl_float), 0, NULL, NULL);
+
+	if (*biasMem != NULL)
+		errCodeReturn |= clEnqueueWriteBuffer(ctx->queue, *biasMem, CL_FALSE, 0, sizeof(cl_float) * colSecondMatrix, epilogue->bias, 0, NULL, NULL);
+
+	// The rows are only needed until the uploads are done
+	clFinish(ctx->queue);
+	free(rowBlocks);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueWriteBuffer");
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 7);
+		return 1;
+	}
+
+	errCodeReturn = clSetKernelArg(kernel->kernel, 0, sizeof(cl_mem), rowBlocksMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 1, sizeof(cl_mem), rowPointersMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 2, sizeof(cl_mem), colIndicesMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 3, sizeof(cl_mem), valuesMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 4, sizeof(cl_mem), secondMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 5, sizeof(cl_mem), resultMatrixMem);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 6, sizeof(cl_uint), &colSecondMatrix);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 7, sizeof(cl_uint), &leadingDims.second);
+	errCodeReturn |= clSetKernelArg(kernel->kernel, 8, sizeof(cl_uint), &leadingDims.result);
+
+	if (epilogue != NULL)
+		errCodeReturn |= epilogueArgsSetting(kernel->kernel, 9, ELEMENT_TYPE_FLOAT, epilogue, biasMem);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clSetKernelArg");
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 7);
+		return 1;
+	}
+
+	const size_t global_item_size[2] = { dimensionAlignment(colSecondMatrix, kernel->params.localGroupSize), (size_t)blockNum * kernel->params.tileRows };
+	const size_t local_item_size[2] = { kernel->params.localGroupSize, kernel->params.tileRows };
+
+	errCodeReturn = clEnqueueNDRangeKernel(ctx->queue, kernel->kernel, 2, NULL, global_item_size, local_item_size, 0, NULL, event_kernel);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueNDRangeKernel");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 7);
+		return 1;
+	}
+
+	errCodeReturn = matrixDownloading(ctx->queue, *resultMatrixMem, leadingDims.result, resultMatrix, leadingDims.result, rowFirstMatrix, colSecondMatrix,
+		sizeof(cl_float), CL_TRUE, 0, NULL, event_end_transfer);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clEnqueueReadBuffer");
+		clFinish(ctx->queue);
+		eventsRelease(events, 3);
+		buffersReturning(&ctx->bufferPool, mems, 7);
+		return 1;
+	}
+
+	cl_ulong kernel_start_time, kernel_end_time;
+	cl_ulong transfer_start_time, transfer_end_time;
+
+	errCodeReturn = clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_kernel, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_start_transfer, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &transfer_start_time, NULL);
+	errCodeReturn |= clGetEventProfilingInfo(*event_end_transfer, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &transfer_end_time, NULL);
+
+	eventsRelease(events, 3);
+	buffersReturning(&ctx->bufferPool, mems, 7);
+
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetEventProfilingInfo");
+		return 1;
+	}
+
+	if (timing != NULL)
+	{
+		timing->kernelTime = (kernel_end_time - kernel_start_time) / 1000000.0;
+		timing->transferTime = (transfer_end_time - transfer_start_time) / 1000000.0;
+		timing->overlapTime = 0;
+		timing->params = params;
+	}
+
+	return 0;
+}
+
+// Measures every valid parameter set on random matrices of the given shape and stores the fastest in the tuning database
+unsigned char matmulTuning(struct matmulContext* ctx, int implementationType, unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	struct kernelParams* bestParams, double* bestTime)
+{
+	if (ctx->native)
+	{
+		fprintf(stderr, "No kernel parameters to tune!\n");
+		return 1;
+	}
+
+	struct kernelParams* candidates = (struct kernelParams*)malloc(sizeof(struct kernelParams) * TUNING_CANDIDATE_MAX);
+	float* firstMatrix = matmulHostAllocation((size_t)rowFirstMatrix * colFirstRowSecond);
+	float* secondMatrix = matmulHostAllocation((size_t)colSecondMatrix * colFirstRowSecond);
+	float* resultMatrix = matmulHostAllocation((size_t)rowFirstMatrix * colSecondMatrix);
+
+	if (candidates == NULL || firstMatrix == NULL || secondMatrix == NULL || resultMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(candidates);
+		matmulHostRelease(firstMatrix);
+		matmulHostRelease(secondMatrix);
+		matmulHostRelease(resultMatrix);
+		return 1;
+	}
+
+	for (size_t i = 0; i < (size_t)rowFirstMatrix * colFirstRowSecond; i++)
+		firstMatrix[i] = (float)rand() / RAND_MAX;
+
+	for (size_t i = 0; i < (size_t)colSecondMatrix * colFirstRowSecond; i++)
+		secondMatrix[i] = (float)rand() / RAND_MAX;
+
+	size_t candidateNum = kernelParamsCandidates(ctx->device, implementationType, candidates, TUNING_CANDIDATE_MAX);
+	const struct matmulLeadingDims leadingDims = { colFirstRowSecond, colSecondMatrix, colSecondMatrix };
+	*bestTime = -1.0;
+
+	for (size_t i = 0; i < candidateNum; i++)
+	{
+		struct matmulKernel* kernel;
+		if (kernelPreparation(ctx, implementationType, ELEMENT_TYPE_FLOAT, 0, KERNEL_VARIANT_PLAIN, &candidates[i], NULL, &kernel))
+			continue;
+
+		// The compiled kernel may allow smaller work-groups than the device does
+		size_t kernelWorkGroupSize;
+		cl_int errCodeReturn = clGetKernelWorkGroupInfo(kernel->kernel, ctx->device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &kernelWorkGroupSize, NULL);
+		if (errCodeReturn != CL_SUCCESS || kernelWorkGroupSize < candidates[i].localGroupSize * candidates[i].localGroupSize / candidates[i].vectorWidth)
+			continue;
+
+		double candidateTime = -1.0;
+		struct matmulTiming timing;
+
+		for (int repeat = 0; repeat <= TUNING_REPEAT_NUM; repeat++)
+		{
+			if (matmulExecution(ctx, firstMatrix, secondMatrix, resultMatrix, rowFirstMatrix, colSecondMatrix, colFirstRowSecond, 1, implementationType, ELEMENT_TYPE_FLOAT, 0,
+				&leadingDims, &candidates[i], NULL, &timing))
+			{
+				candidateTime = -1.0;
+				break;
+			}
+
+			// The first run only warms up
+			if (repeat && (candidateTime < 0.0 || timing.kernelTime < candidateTime))
+				candidateTime = timing.kernelTime;
+		}
+
+		if (candidateTime < 0.0)
+			continue;
+
+		printf("LSIZE %zu vecWidth %zu TM %zu TN %zu: %g\n", candidates[i].localGroupSize, candidates[i].vectorWidth, candidates[i].tileRows, candidates[i].tileCols, candidateTime);
+
+		if (*bestTime < 0.0 || candidateTime < *bestTime)
+		{
+			*bestTime = candidateTime;
+			*bestParams = candidates[i];
+		}
+	}
+
+	free(candidates);
+	matmulHostRelease(firstMatrix);
+	matmulHostRelease(secondMatrix);
+	matmulHostRelease(resultMatrix);
+
+	if (*bestTime < 0.0)
+	{
+		fprintf(stderr, "No kernel parameters to tune!\n");
+		return 1;
+	}
+
+	struct tuningEntry entry;
+	entry.implementationType = implementationType;
+	entry.rowClass = shapeClass(rowFirstMatrix);
+	entry.colClass = shapeClass(colSecondMatrix);
+	entry.colRowClass = shapeClass(colFirstRowSecond);
+	entry.params = *bestParams;
+	entry.kernelTime = *bestTime;
+
+	if (tuningDatabaseSaving(ctx->deviceKey, &entry))
+		return 1;
+
+	free(ctx->tuningEntries);
+	return tuningDatabaseLoading(ctx->deviceKey, &ctx->tuningEntries, &ctx->tuningEntryNum);
+}
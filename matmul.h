@@ -0,0 +1,298 @@
+#ifndef MATMUL_H
+#define MATMUL_H
+
+#define CL_TARGET_OPENCL_VERSION 120
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#pragma comment(lib, "opencl.lib")
+#endif
+
+// Compiled program binaries are cached in this directory unless MATMUL_KERNEL_CACHE overrides it (empty disables)
+#define KERNEL_CACHE_DIR "kernelCache"
+#define KERNEL_CACHE_MAGIC "CLMMPRG1"
+
+#define IMPLEMENTATION_TYPE_NUM 4
+
+// A first matrix with a smaller share of nonzeros than this is multiplied in CSR form by the sparse kernel, built as one more
+// implementation type. Its rows are grouped into blocks of about SPARSE_BLOCK_NONZEROS nonzeros (a longer row makes a block
+// of its own), and each block is taken by a work-group of SPARSE_LANE_NUM lanes of up to SPARSE_COL_NUM result columns
+#define SPARSE_DENSITY_THRESHOLD 0.05
+#define SPARSE_BLOCK_NONZEROS 256
+#define SPARSE_LANE_NUM 8
+#define SPARSE_COL_NUM 32
+#define IMPLEMENTATION_SPARSE (IMPLEMENTATION_TYPE_NUM + 1)
+
+// Products whose smallest dimension is above the crossover can be split by the Strassen-Winograd recursion into seven products
+// of half the size per level, down to leaves no larger than the crossover (MATMUL_STRASSEN_CROSSOVER overrides it) that are
+// multiplied by the kernel of the implementation type. The additions between them are done by one more kernel
+#define STRASSEN_CROSSOVER 1024
+#define STRASSEN_CROSSOVER_ENV "MATMUL_STRASSEN_CROSSOVER"
+#define STRASSEN_LEVEL_MAX 6
+#define IMPLEMENTATION_ADDITION (IMPLEMENTATION_TYPE_NUM + 2)
+
+// Products with fewer result tiles than SPLIT_K_GROUPS_PER_UNIT per compute unit leave the device partly idle, so they are split
+// along K into up to SPLIT_K_SLICE_MAX slices of at least SPLIT_K_MIN_TILES tiles. The partial products of the slices are summed
+// by a reduction kernel, built as one more implementation type
+#define SPLIT_K_GROUPS_PER_UNIT 4
+#define SPLIT_K_MIN_TILES 8
+#define SPLIT_K_SLICE_MAX 64
+#define IMPLEMENTATION_REDUCTION (IMPLEMENTATION_TYPE_NUM + 3)
+
+// A result of at most GEMV_VECTOR_MAX columns or rows is computed by the matrix-vector kernel, built as one more implementation
+// type: the work-groups sum along K for one result column or row after another, so no work-item is spent on padding
+#define GEMV_VECTOR_MAX 4
+#define IMPLEMENTATION_GEMV (IMPLEMENTATION_TYPE_NUM + 4)
+
+// Build variants of a kernel: the tiled kernels with the third dimension over slices of K, and the matrix-vector kernel with
+// the vectors as the rows of the first matrix instead of the columns of the second
+#define KERNEL_VARIANT_PLAIN 0
+#define KERNEL_VARIANT_SPLIT_K 1
+#define KERNEL_VARIANT_VECTOR_FIRST 2
+#define KERNEL_VARIANT_NUM 3
+
+// CL_PLATFORM_NOT_FOUND_KHR: returned by the ICD loader when no OpenCL runtime is installed
+#define PLATFORM_NOT_FOUND -1001
+
+// Outputs per work-item along each dimension in the register-blocked kernel
+#define REGISTER_TILE_SIZE 4
+
+// The pipelined mode splits the result into about this many row panels and keeps up to PIPELINE_SLOT_NUM of them in flight,
+// so the upload of one panel, the kernel of another and the download of a third overlap
+#define PIPELINE_PANEL_NUM 8
+#define PIPELINE_SLOT_NUM 3
+
+// Host matrices are allocated on this boundary so that devices sharing memory with the host can use them in place;
+// MATMUL_ZERO_COPY=0 makes those devices copy them to device buffers like the others
+#define HOST_BUFFER_ALIGNMENT 4096
+#define ZERO_COPY_ENV "MATMUL_ZERO_COPY"
+
+// Device memory held by the buffer pool is capped to this many megabytes when MATMUL_MEMORY_CAP is set (0 is unlimited)
+#define MEMORY_CAP_ENV "MATMUL_MEMORY_CAP"
+
+struct deviceInfo
+{
+	cl_device_id ID;
+	cl_device_type type;
+	cl_bool hostUnifiedMem;
+	cl_uint sortID;
+};
+
+// Build parameters of a kernel: local group side, vector width and the TM x TN block computed per work-item
+struct kernelParams
+{
+	size_t localGroupSize;
+	size_t vectorWidth;
+	size_t tileRows;
+	size_t tileCols;
+};
+
+// Element types the matrices can be kept in on the device. Half matrices are accumulated in float, double ones in double
+// (devices with cl_khr_fp64) and int8 ones in int32, which is also the type of their result
+#define ELEMENT_TYPE_FLOAT 0
+#define ELEMENT_TYPE_HALF 1
+#define ELEMENT_TYPE_DOUBLE 2
+#define ELEMENT_TYPE_INT8 3
+#define ELEMENT_TYPE_NUM 4
+
+// Layouts of the row-major matrices as bit flags: the first is M x K or, transposed, K x M and the second K x N or, transposed,
+// N x K. Column-major matrices are the transposed row-major ones
+#define LAYOUT_FIRST_TRANSPOSED 1
+#define LAYOUT_SECOND_TRANSPOSED 2
+#define LAYOUT_NUM 4
+
+#define ACTIVATION_NONE 0
+#define ACTIVATION_RELU 1
+#define ACTIVATION_GELU 2
+#define ACTIVATION_NUM 3
+
+// Fused into the kernels' final store: result = activation(alpha * product + beta * result + bias[column]). The result matrix is only
+// read when beta is not zero; bias is NULL or holds one value per result column, as double for double matrices and as float otherwise
+struct matmulEpilogue
+{
+	double alpha;
+	double beta;
+	const void* bias;
+	int activation;
+};
+
+// Elements from one stored row of each matrix to the next (lda, ldb and ldc), at least the stored row length. A sub-matrix of a
+// larger row-major matrix is multiplied in place by passing a pointer to its first element and the row length of the larger one;
+// the matrices of a batch then follow each other every leading dimension times stored rows elements
+struct matmulLeadingDims
+{
+	unsigned int first;
+	unsigned int second;
+	unsigned int result;
+};
+
+// epilogue is NULL for the plain product; layout 0 multiplies M x K by K x N; leadingDims is NULL for packed matrices;
+// strassen asks for the Strassen-Winograd recursion, which is taken by single float products of layout 0 without epilogue;
+// exactKernel keeps the kernel of implementationType, which is otherwise replaced by the sparse kernel for a mostly zero first matrix
+// and by the matrix-vector kernel for a result of few rows or columns
+struct matmulOptions
+{
+	int implementationType;
+	int elementType;
+	int layout;
+	unsigned char pipelined;
+	const struct matmulEpilogue* epilogue;
+	const struct matmulLeadingDims* leadingDims;
+	unsigned char strassen;
+	unsigned char exactKernel;
+};
+
+// First matrix in compressed sparse row form: the nonzeros of row i are values[rowPointers[i]] up to values[rowPointers[i + 1] - 1],
+// in the columns colIndices holds for them
+struct csrMatrix
+{
+	unsigned int rowNum;
+	unsigned int colNum;
+	unsigned int* rowPointers;
+	unsigned int* colIndices;
+	float* values;
+};
+
+// overlapTime is how much shorter the run was than its commands one after another
+struct matmulTiming
+{
+	double kernelTime;
+	double transferTime;
+	double overlapTime;
+	struct kernelParams params;
+};
+
+struct bufferPoolStats
+{
+	size_t allocatedBytes;
+	size_t inUseBytes;
+	size_t highWaterMark;
+	size_t memoryCap;
+	unsigned long long allocationNum;
+	unsigned long long reuseNum;
+	unsigned long long evictionNum;
+};
+
+// Everything that outlives a single multiplication: device, context, queue, built kernels and device buffers;
+// the device after the last OpenCL one is the native CPU backend, which needs none of them
+struct matmulContext;
+
+unsigned char matmulCreate(struct matmulContext** ctx, int selectedDeviceID);
+unsigned char matmulDeviceCreate(struct matmulContext** ctx, cl_device_id device);
+void matmulRelease(struct matmulContext* ctx);
+const char* matmulDeviceName(const struct matmulContext* ctx);
+unsigned char matmulDeviceNative(const struct matmulContext* ctx);
+unsigned char matmulMemoryLimits(const struct matmulContext* ctx, unsigned long long* maxBufferSize, unsigned long long* deviceMemSize);
+void matmulMemoryInfo(const struct matmulContext* ctx, struct bufferPoolStats* stats);
+void matmulMemoryCapSetting(struct matmulContext* ctx, size_t memoryCap);
+float* matmulHostAllocation(size_t count);
+void matmulHostRelease(float* matrix);
+size_t elementSize(int elementType);
+size_t resultElementSize(int elementType);
+void halfConversion(const float* matrix, cl_half* halfMatrix, size_t count);
+void floatConversion(const cl_half* halfMatrix, float* matrix, size_t count);
+void halfRowsConversion(const float* matrix, size_t leadingDim, cl_half* halfMatrix, size_t rowNum, size_t rowLength);
+void floatRowsConversion(const cl_half* halfMatrix, float* matrix, size_t leadingDim, size_t rowNum, size_t rowLength);
+void resultErrorCalculation(const float* resultMatrix, const float* referenceMatrix, size_t count, double* maxAbsError, double* maxRelError);
+
+// resultMatrix (M x N) = op(firstMatrix) * op(secondMatrix), where op transposes the matrices flagged in options->layout
+unsigned char matmul(struct matmulContext* ctx, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	const struct matmulOptions* options, struct matmulTiming* timing);
+
+// batchNum products of the same shape in one launch: the pairs of matrices and the results are packed one after another
+unsigned char matmulBatched(struct matmulContext* ctx, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	const struct matmulOptions* options, struct matmulTiming* timing);
+
+// matmulBatched on matrices already of options->elementType: cl_float, cl_half or cl_double matrices give a result of the same type,
+// cl_char matrices a cl_int result
+unsigned char matmulTypedBatched(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	const struct matmulOptions* options, struct matmulTiming* timing);
+
+// matmulBatched with explicitly given kernel parameters instead of the tuned or default ones; the matrices are already
+// of elementType, which the native CPU backend only takes as float
+unsigned char matmulExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing);
+
+// matmulExecution with the result split into row panels whose uploads, kernels and downloads run on separate queues
+unsigned char matmulPipelinedExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing);
+
+// matmulExecution on a device with host unified memory: the host matrices are wrapped in CL_MEM_USE_HOST_PTR buffers
+// and the result is mapped instead of read back, so nothing is copied
+unsigned char matmulZeroCopyExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int batchNum,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing);
+
+// matmulExecution of a single float product split levelNum times by the Strassen-Winograd recursion; the matrices are padded
+// on the device so that every quadrant is a sub-buffer, and all the intermediates stay there. params are those of the leaves
+unsigned char matmulStrassenExecution(struct matmulContext* ctx, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int levelNum,
+	int implementationType, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, struct matmulTiming* timing);
+
+// matmulExecution of a single product with K split into sliceNum slices, each multiplied by its own work-groups; a reduction
+// kernel then sums the partial products and applies the epilogue. The tiled kernels take any element type but half
+unsigned char matmulSplitKExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, unsigned int sliceNum,
+	int implementationType, int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing);
+
+// matmulExecution of a single product whose result has few rows or columns by the matrix-vector kernel: the vectors are the
+// smaller of the first matrix's rows and the second matrix's columns, and each result element is summed by a work-group row
+unsigned char matmulGemvExecution(struct matmulContext* ctx, const void* firstMatrix, const void* secondMatrix, void* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	int elementType, int layout, const struct matmulLeadingDims* leadingDims, const struct kernelParams* params, const struct matmulEpilogue* epilogue, struct matmulTiming* timing);
+
+// resultMatrix (M x N) = firstMatrix * op(secondMatrix) for a CSR first matrix of M rows and K columns; options->layout may only
+// transpose the second matrix, and the first leading dimension is not used
+unsigned char matmulSparse(struct matmulContext* ctx, const struct csrMatrix* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int colSecondMatrix, const struct matmulOptions* options, struct matmulTiming* timing);
+
+// Sweeps the kernel parameters of an implementation type for one shape; the fastest set is used for similar shapes from then on
+unsigned char matmulTuning(struct matmulContext* ctx, int implementationType, unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	struct kernelParams* bestParams, double* bestTime);
+
+void errCodeOutput(cl_int errCode, char* errLog);
+unsigned char getMaxLocalGroupSize(cl_device_id device, size_t* maxLocalGroupSize, const int implementationType);
+unsigned char kernelFileProcessing(const char* kernelFilePath, size_t* kernelFileSize, unsigned char** kernelFileText);
+unsigned char deviceStringInfo(cl_device_id device, cl_device_info paramName, char** paramValue);
+unsigned char buildLogOutput(cl_program program, cl_device_id device);
+unsigned char kernelCacheKeyCreation(cl_device_id device, const unsigned char* kernelFileText, size_t kernelFileSize, const char* buildDefStr, char** cacheKey, char** cacheFilePath);
+unsigned char cachedProgramLoading(cl_context context, cl_device_id device, const char* cacheFilePath, const char* cacheKey, const char* buildDefStr, cl_program* program);
+unsigned char cachedProgramSaving(cl_program program, const char* cacheFilePath, const char* cacheKey);
+unsigned char programCreation(cl_context context, cl_device_id device, const unsigned char* kernelFileText, size_t kernelFileSize, const char* buildDefStr, cl_program* program);
+cl_uint getDeviceNumber(cl_uint* platformNum);
+unsigned char getDeviceInfo(struct deviceInfo* devices, cl_uint deviceNum, cl_uint platformNum);
+void deviceSorting(struct deviceInfo* devices, cl_uint deviceNum);
+void deviceSelection(struct deviceInfo* devices, cl_uint deviceNum, cl_device_id* device, unsigned int selectedDeviceID);
+unsigned char buildDefCreation(const char* buildDef, const char* typeDef, char** buildDefStr, const struct kernelParams* params);
+int epilogueVariant(const struct matmulEpilogue* epilogue);
+void storedShapes(unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, int layout,
+	unsigned int* firstShape, unsigned int* secondShape);
+unsigned char leadingDimsResolving(unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond, int layout,
+	const struct matmulLeadingDims* leadingDims, struct matmulLeadingDims* resolvedDims);
+cl_int matrixUploading(cl_command_queue queue, cl_mem mem, size_t bufferLeadingDim, const void* matrix, size_t leadingDim, size_t rowNum, size_t rowLength,
+	size_t typeSize, cl_uint waitEventNum, const cl_event* waitEvents, cl_event* event);
+cl_int matrixDownloading(cl_command_queue queue, cl_mem mem, size_t bufferLeadingDim, void* matrix, size_t leadingDim, size_t rowNum, size_t rowLength,
+	size_t typeSize, cl_bool blocking, cl_uint waitEventNum, const cl_event* waitEvents, cl_event* event);
+cl_int epilogueArgsSetting(cl_kernel kernel, cl_uint argIndex, int elementType, const struct matmulEpilogue* epilogue, const cl_mem* biasMem);
+cl_int leadingDimsArgsSetting(cl_kernel kernel, cl_uint argIndex, const struct matmulLeadingDims* leadingDims);
+unsigned int dimensionAlignment(unsigned int dim, size_t maxLocalGroupSize);
+void kernelDefaultParams(cl_device_id device, int implementationType, struct kernelParams* params);
+size_t nonZeroCounting(const float* matrix, unsigned int rowNum, unsigned int colNum, size_t rowStride, size_t colStride, size_t nonZeroLimit);
+unsigned char csrBuilding(const float* matrix, unsigned int rowNum, unsigned int colNum, size_t rowStride, size_t colStride, struct csrMatrix* csr);
+void csrRelease(struct csrMatrix* csr);
+unsigned char rowBlocksBuilding(const struct csrMatrix* csr, unsigned int** rowBlocks, unsigned int* blockNum);
+unsigned int strassenCrossover(void);
+unsigned int splitKSlices(cl_device_id device, int implementationType, int elementType, unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	const struct kernelParams* params);
+unsigned char gemvSelection(cl_device_id device, int implementationType, int elementType, unsigned int rowFirstMatrix, unsigned int colSecondMatrix,
+	unsigned int colFirstRowSecond, const struct kernelParams* params, const struct kernelParams* gemvParams);
+unsigned int strassenLevels(unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond);
+
+#endif
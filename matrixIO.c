@@ -0,0 +1,1311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <time.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "matrixIO.h"
+
+// The first line is "N K M", or "N K M B" for a batch of B pairs that follow one after another
+unsigned char matrixSizing(FILE* inputFile, struct sizes* size)
+{
+	char firstLine[128];
+	if (fgets(firstLine, sizeof(firstLine), inputFile) == NULL)
+		return 1;
+
+	size->batchNum = 1;
+	size->secondTransposed = 0;
+
+	if (sscanf(firstLine, "%u %u %u %u", &size->colSecondMatrix, &size->colFirstRowSecond, &size->rowFirstMatrix, &size->batchNum) < 3 || !size->batchNum)
+		return 1;
+
+	size->firstMatrix = (unsigned long long)size->rowFirstMatrix * size->colFirstRowSecond * size->batchNum;
+	size->secondMatrix = (unsigned long long)size->colFirstRowSecond * size->colSecondMatrix * size->batchNum;
+	size->resultMatrix = (unsigned long long)size->rowFirstMatrix * size->colSecondMatrix * size->batchNum;
+
+	return 0;
+}
+
+unsigned char readFile(FILE* inputFile, float* firstMatrix, float* secondMatrix, struct sizes* size)
+{
+	const unsigned long long firstMatrixSize = size->firstMatrix / size->batchNum;
+	const unsigned long long secondMatrixSize = size->secondMatrix / size->batchNum;
+
+	for (unsigned int batch = 0; batch < size->batchNum; batch++, firstMatrix += firstMatrixSize, secondMatrix += secondMatrixSize)
+	{
+		for (unsigned long long i = 0; i < firstMatrixSize; i++)
+		{
+			if (fscanf(inputFile, "%f", &firstMatrix[i]) <= 0)
+				return 1;
+		}
+
+		for (unsigned long long i = 0; i < secondMatrixSize; i++)
+		{
+			if (fscanf(inputFile, "%f", &secondMatrix[i]) <= 0)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Every result of a batch is written as a result file of its own, one after another
+unsigned char writeFile(FILE* outputFile, float* matrix, struct sizes* size)
+{
+	for (unsigned int batch = 0; batch < size->batchNum; batch++, matrix += size->resultMatrix / size->batchNum)
+	{
+		if (fprintf(outputFile, "%u %u\n", size->colSecondMatrix, size->rowFirstMatrix) < 0)
+			return 1;
+
+		for (unsigned int i = 0; i < size->rowFirstMatrix; i++)
+		{
+			size_t currLine = (size_t)size->colSecondMatrix * i;
+
+			for (unsigned int j = 0; j < size->colSecondMatrix; j++)
+			{
+				size_t currElIndex = currLine + j;
+
+				if (fprintf(outputFile, "%f ", matrix[currElIndex]) < 0)
+					return 1;
+			}
+
+			if (fprintf(outputFile, "\n") < 0)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Reads one value of a typed text file into matrix[index]; chars are read as integers and have to fit into a signed byte
+unsigned char typedValueReading(FILE* inputFile, unsigned int valueType, void* matrix, size_t index)
+{
+	int value;
+
+	switch (valueType)
+	{
+	case VALUE_TYPE_DOUBLE:
+		return fscanf(inputFile, "%lf", &((double*)matrix)[index]) <= 0;
+	case VALUE_TYPE_CHAR:
+		if (fscanf(inputFile, "%d", &value) <= 0 || value < -128 || value > 127)
+			return 1;
+
+		((signed char*)matrix)[index] = (signed char)value;
+		return 0;
+	case VALUE_TYPE_INT:
+		return fscanf(inputFile, "%d", &((int*)matrix)[index]) <= 0;
+	default:
+		return 1;
+	}
+}
+
+// readFile for double or char matrices
+unsigned char readTypedFile(FILE* inputFile, unsigned int valueType, void* firstMatrix, void* secondMatrix, struct sizes* size)
+{
+	const unsigned long long firstMatrixSize = size->firstMatrix / size->batchNum;
+	const unsigned long long secondMatrixSize = size->secondMatrix / size->batchNum;
+
+	for (unsigned int batch = 0; batch < size->batchNum; batch++)
+	{
+		for (unsigned long long i = 0; i < firstMatrixSize; i++)
+		{
+			if (typedValueReading(inputFile, valueType, firstMatrix, (size_t)(batch * firstMatrixSize + i)))
+				return 1;
+		}
+
+		for (unsigned long long i = 0; i < secondMatrixSize; i++)
+		{
+			if (typedValueReading(inputFile, valueType, secondMatrix, (size_t)(batch * secondMatrixSize + i)))
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+// writeFile for double or int results; doubles are printed with all the digits needed to read them back exactly
+unsigned char writeTypedFile(FILE* outputFile, unsigned int valueType, const void* matrix, struct sizes* size)
+{
+	if (valueType != VALUE_TYPE_DOUBLE && valueType != VALUE_TYPE_INT)
+		return 1;
+
+	const size_t resultMatrixSize = (size_t)(size->resultMatrix / size->batchNum);
+
+	for (unsigned int batch = 0; batch < size->batchNum; batch++)
+	{
+		if (fprintf(outputFile, "%u %u\n", size->colSecondMatrix, size->rowFirstMatrix) < 0)
+			return 1;
+
+		for (unsigned int i = 0; i < size->rowFirstMatrix; i++)
+		{
+			size_t currLine = batch * resultMatrixSize + (size_t)size->colSecondMatrix * i;
+
+			for (unsigned int j = 0; j < size->colSecondMatrix; j++)
+			{
+				size_t currElIndex = currLine + j;
+
+				int errCode = valueType == VALUE_TYPE_DOUBLE ? fprintf(outputFile, "%.17g ", ((const double*)matrix)[currElIndex])
+					: fprintf(outputFile, "%d ", ((const int*)matrix)[currElIndex]);
+				if (errCode < 0)
+					return 1;
+			}
+
+			if (fprintf(outputFile, "\n") < 0)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+unsigned char hostLittleEndian(void)
+{
+	const unsigned int probe = 1;
+	return *(const unsigned char*)&probe;
+}
+
+void floatByteSwap(float* data, size_t count)
+{
+	unsigned char* bytes = (unsigned char*)data;
+
+	for (size_t i = 0; i < count; i++, bytes += sizeof(float))
+	{
+		unsigned char tmp = bytes[0];
+		bytes[0] = bytes[3];
+		bytes[3] = tmp;
+		tmp = bytes[1];
+		bytes[1] = bytes[2];
+		bytes[2] = tmp;
+	}
+}
+
+unsigned long long loadLittleEndian(const unsigned char* bytes, unsigned int byteNum)
+{
+	unsigned long long value = 0;
+
+	for (unsigned int i = byteNum; i > 0; i--)
+		value = (value << 8) | bytes[i - 1];
+
+	return value;
+}
+
+void storeLittleEndian(unsigned char* bytes, unsigned long long value, unsigned int byteNum)
+{
+	for (unsigned int i = 0; i < byteNum; i++, value >>= 8)
+		bytes[i] = (unsigned char)(value & 0xFF);
+}
+
+unsigned long long binaryAlignment(unsigned long long offset)
+{
+	return (offset + BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT * BINARY_ALIGNMENT;
+}
+
+unsigned long long fileLength(FILE* file)
+{
+#ifdef _WIN32
+	long long currPos = _ftelli64(file);
+	_fseeki64(file, 0LL, SEEK_END);
+	long long fileSize = _ftelli64(file);
+	_fseeki64(file, currPos, SEEK_SET);
+#else
+	off_t currPos = ftello(file);
+	fseeko(file, 0, SEEK_END);
+	off_t fileSize = ftello(file);
+	fseeko(file, currPos, SEEK_SET);
+#endif
+
+	return fileSize < 0 ? 0 : (unsigned long long)fileSize;
+}
+
+unsigned char fileSeeking(FILE* file, unsigned long long offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, (long long)offset, SEEK_SET) != 0;
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET) != 0;
+#endif
+}
+
+void* mapFile(FILE* file, size_t* fileSize)
+{
+#ifdef _WIN32
+	*fileSize = (size_t)fileLength(file);
+	rewind(file);
+
+	if (!*fileSize)
+		return NULL;
+
+	void* fileData = malloc(*fileSize);
+	if (fileData == NULL)
+		return NULL;
+
+	if (fread(fileData, 1, *fileSize, file) != *fileSize)
+	{
+		free(fileData);
+		return NULL;
+	}
+
+	return fileData;
+#else
+	struct stat fileStat;
+	if (fstat(fileno(file), &fileStat) != 0 || fileStat.st_size <= 0)
+		return NULL;
+
+	*fileSize = (size_t)fileStat.st_size;
+
+	void* fileData = mmap(NULL, *fileSize, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+	if (fileData == MAP_FAILED)
+		return NULL;
+
+	madvise(fileData, *fileSize, MADV_SEQUENTIAL);
+	return fileData;
+#endif
+}
+
+void unmapFile(void* fileData, size_t fileSize)
+{
+#ifdef _WIN32
+	free(fileData);
+#else
+	munmap(fileData, fileSize);
+#endif
+}
+
+unsigned char isBinaryFile(FILE* file)
+{
+	char magic[sizeof(BINARY_MAGIC) - 1];
+	unsigned char binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && !memcmp(magic, BINARY_MAGIC, sizeof(magic));
+
+	rewind(file);
+	return binary;
+}
+
+unsigned char isSparseFile(FILE* file)
+{
+	char magic[sizeof(SPARSE_MAGIC) - 1];
+	unsigned char sparse = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && !memcmp(magic, SPARSE_MAGIC, sizeof(magic));
+
+	rewind(file);
+	return sparse;
+}
+
+// The first line of a sparse file is "csr N K M Z": Z nonzeros of the M x K first matrix follow as "row column value" lines
+// ordered by row, then the K x N second matrix as in the text files
+unsigned char sparseMatrixSizing(FILE* inputFile, struct sizes* size, unsigned int* nonZeroNum)
+{
+	char firstLine[128];
+	if (fgets(firstLine, sizeof(firstLine), inputFile) == NULL)
+		return 1;
+
+	size->batchNum = 1;
+	size->secondTransposed = 0;
+
+	if (sscanf(firstLine, SPARSE_MAGIC " %u %u %u %u", &size->colSecondMatrix, &size->colFirstRowSecond, &size->rowFirstMatrix, nonZeroNum) != 4
+		|| *nonZeroNum > (unsigned long long)size->rowFirstMatrix * size->colFirstRowSecond)
+		return 1;
+
+	size->firstMatrix = (unsigned long long)size->rowFirstMatrix * size->colFirstRowSecond;
+	size->secondMatrix = (unsigned long long)size->colFirstRowSecond * size->colSecondMatrix;
+	size->resultMatrix = (unsigned long long)size->rowFirstMatrix * size->colSecondMatrix;
+
+	return 0;
+}
+
+// The row pointers are built while the nonzeros are read, so rows may not go back; rowPointers holds M + 1 elements
+unsigned char readSparseFile(FILE* inputFile, unsigned int* rowPointers, unsigned int* colIndices, float* values, float* secondMatrix,
+	const struct sizes* size, unsigned int nonZeroNum)
+{
+	unsigned int currRow = 0;
+	rowPointers[0] = 0;
+
+	for (unsigned int i = 0; i < nonZeroNum; i++)
+	{
+		unsigned int row;
+		if (fscanf(inputFile, "%u %u %f", &row, &colIndices[i], &values[i]) != 3
+			|| row < currRow || row >= size->rowFirstMatrix || colIndices[i] >= size->colFirstRowSecond)
+			return 1;
+
+		while (currRow < row)
+			rowPointers[++currRow] = i;
+	}
+
+	while (currRow < size->rowFirstMatrix)
+		rowPointers[++currRow] = nonZeroNum;
+
+	for (unsigned long long i = 0; i < size->secondMatrix; i++)
+	{
+		if (fscanf(inputFile, "%f", &secondMatrix[i]) <= 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+double wallTime(void)
+{
+	struct timespec currTime;
+	timespec_get(&currTime, TIME_UTC);
+
+	return currTime.tv_sec + currTime.tv_nsec / 1000000000.0;
+}
+
+int threadNumber(void)
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+unsigned char isSpaceChar(char symbol)
+{
+	return symbol == ' ' || symbol == '\n' || symbol == '\r' || symbol == '\t' || symbol == '\v' || symbol == '\f';
+}
+
+const char* slowFloatParsing(const char* tokenStart, const char* tokenEnd, float* value)
+{
+	char tokenBuffer[128];
+	size_t tokenSize = tokenEnd - tokenStart;
+	char* token = tokenBuffer;
+
+	if (tokenSize >= sizeof(tokenBuffer))
+	{
+		token = (char*)malloc(tokenSize + 1);
+		if (token == NULL)
+			return NULL;
+	}
+
+	memcpy(token, tokenStart, tokenSize);
+	token[tokenSize] = '\0';
+
+	char* parsedEnd;
+	*value = strtof(token, &parsedEnd);
+	unsigned char valid = parsedEnd != token && (size_t)(parsedEnd - token) == tokenSize;
+
+	if (token != tokenBuffer)
+		free(token);
+
+	return valid ? tokenEnd : NULL;
+}
+
+// Decimal to float conversion rounding exactly like strtof: the Clinger fast path in double
+// precision is used unless the result would be a double-rounding midpoint or outside the normal range
+const char* floatParsing(const char* curr, const char* end, float* value)
+{
+	static const double powersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const char* tokenStart = curr;
+	const char* tokenEnd = curr;
+	while (tokenEnd < end && !isSpaceChar(*tokenEnd))
+		tokenEnd++;
+
+	unsigned char negative = 0;
+	if (curr < tokenEnd && (*curr == '-' || *curr == '+'))
+	{
+		negative = *curr == '-';
+		curr++;
+	}
+
+	unsigned long long mantissa = 0;
+	int digitNum = 0;
+	int exponent = 0;
+	unsigned char anyDigit = 0;
+
+	for (; curr < tokenEnd && *curr >= '0' && *curr <= '9'; curr++, anyDigit = 1)
+	{
+		if (mantissa || *curr != '0')
+			digitNum++;
+
+		mantissa = mantissa * 10 + (*curr - '0');
+	}
+
+	if (curr < tokenEnd && *curr == '.')
+	{
+		for (curr++; curr < tokenEnd && *curr >= '0' && *curr <= '9'; curr++, anyDigit = 1)
+		{
+			if (mantissa || *curr != '0')
+				digitNum++;
+
+			mantissa = mantissa * 10 + (*curr - '0');
+			exponent--;
+		}
+	}
+
+	if (curr < tokenEnd && (*curr == 'e' || *curr == 'E'))
+	{
+		const char* exponentStart = ++curr;
+		unsigned char negativeExponent = 0;
+		int exponentValue = 0;
+
+		if (curr < tokenEnd && (*curr == '-' || *curr == '+'))
+		{
+			negativeExponent = *curr == '-';
+			curr++;
+		}
+
+		for (; curr < tokenEnd && *curr >= '0' && *curr <= '9' && exponentValue < 10000; curr++)
+			exponentValue = exponentValue * 10 + (*curr - '0');
+
+		if (curr == exponentStart)
+			return slowFloatParsing(tokenStart, tokenEnd, value);
+
+		exponent += negativeExponent ? -exponentValue : exponentValue;
+	}
+
+	if (!anyDigit || curr != tokenEnd || digitNum > 19)
+		return slowFloatParsing(tokenStart, tokenEnd, value);
+
+	if (!mantissa)
+	{
+		*value = negative ? -0.0f : 0.0f;
+		return tokenEnd;
+	}
+
+	if (mantissa > (1ULL << 53) || exponent < -22 || exponent > 22)
+		return slowFloatParsing(tokenStart, tokenEnd, value);
+
+	double result = exponent < 0 ? (double)mantissa / powersOfTen[-exponent] : (double)mantissa * powersOfTen[exponent];
+
+	unsigned long long resultBits;
+	memcpy(&resultBits, &result, sizeof(resultBits));
+
+	if (result < FLT_MIN || result > FLT_MAX || (resultBits & ((1ULL << 29) - 1)) == (1ULL << 28))
+		return slowFloatParsing(tokenStart, tokenEnd, value);
+
+	*value = negative ? -(float)result : (float)result;
+	return tokenEnd;
+}
+
+size_t tokenCounting(const char* curr, const char* end)
+{
+	size_t tokenNum = 0;
+	unsigned char prevSpace = 1;
+
+	for (; curr < end; curr++)
+	{
+		unsigned char currSpace = isSpaceChar(*curr);
+		tokenNum += prevSpace & !currSpace;
+		prevSpace = currSpace;
+	}
+
+	return tokenNum;
+}
+
+// Text matrices are split into chunks at whitespace boundaries, tokens are counted per chunk to get
+// every chunk's first element index and then all chunks are parsed concurrently
+unsigned char readFileParallel(FILE* inputFile, float* firstMatrix, float* secondMatrix, struct sizes* size)
+{
+	long dataOffset = ftell(inputFile);
+	if (dataOffset < 0)
+		return 1;
+
+	size_t fileSize;
+	const char* fileData = (const char*)mapFile(inputFile, &fileSize);
+	if (fileData == NULL)
+		return 1;
+
+	const char* dataBegin = fileData + dataOffset;
+	const char* dataEnd = fileData + fileSize;
+	size_t dataSize = dataEnd > dataBegin ? dataEnd - dataBegin : 0;
+
+	const size_t minChunkSize = 1 << 16;
+	size_t chunkNum = (size_t)threadNumber() * 4;
+	if (chunkNum > dataSize / minChunkSize)
+		chunkNum = dataSize / minChunkSize;
+	if (!chunkNum)
+		chunkNum = 1;
+
+	const char** chunkBounds = (const char**)malloc(sizeof(const char*) * (chunkNum + 1));
+	size_t* chunkOffsets = (size_t*)malloc(sizeof(size_t) * (chunkNum + 1));
+	if (chunkBounds == NULL || chunkOffsets == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(chunkBounds);
+		free(chunkOffsets);
+		unmapFile((void*)fileData, fileSize);
+		return 1;
+	}
+
+	chunkBounds[0] = dataBegin;
+	chunkBounds[chunkNum] = dataEnd;
+
+	for (size_t i = 1; i < chunkNum; i++)
+	{
+		const char* bound = dataBegin + dataSize / chunkNum * i;
+		if (bound < chunkBounds[i - 1])
+			bound = chunkBounds[i - 1];
+
+		while (bound < dataEnd && !isSpaceChar(*bound))
+			bound++;
+
+		chunkBounds[i] = bound;
+	}
+
+	long long chunkCount = (long long)chunkNum;
+
+	#pragma omp parallel for schedule(static)
+	for (long long i = 0; i < chunkCount; i++)
+		chunkOffsets[i + 1] = tokenCounting(chunkBounds[i], chunkBounds[i + 1]);
+
+	chunkOffsets[0] = 0;
+	for (size_t i = 1; i <= chunkNum; i++)
+		chunkOffsets[i] += chunkOffsets[i - 1];
+
+	// Elements run through the pairs of a batch: the first matrix, then the second one, then the next pair
+	const size_t firstMatrixSize = size->firstMatrix / size->batchNum;
+	const size_t secondMatrixSize = size->secondMatrix / size->batchNum;
+	const size_t elementNum = (size_t)size->firstMatrix + size->secondMatrix;
+	unsigned char errCode = chunkOffsets[chunkNum] < elementNum;
+
+	if (!errCode)
+	{
+		#pragma omp parallel for schedule(dynamic) reduction(|:errCode)
+		for (long long i = 0; i < chunkCount; i++)
+		{
+			const char* curr = chunkBounds[i];
+			const char* end = chunkBounds[i + 1];
+
+			size_t batch = chunkOffsets[i] / (firstMatrixSize + secondMatrixSize);
+			size_t pairIndex = chunkOffsets[i] % (firstMatrixSize + secondMatrixSize);
+
+			for (size_t elIndex = chunkOffsets[i]; elIndex < elementNum; elIndex++, pairIndex++)
+			{
+				while (curr < end && isSpaceChar(*curr))
+					curr++;
+
+				if (curr == end)
+					break;
+
+				float value;
+				curr = floatParsing(curr, end, &value);
+				if (curr == NULL)
+				{
+					errCode = 1;
+					break;
+				}
+
+				if (pairIndex == firstMatrixSize + secondMatrixSize)
+				{
+					batch++;
+					pairIndex = 0;
+				}
+
+				if (pairIndex < firstMatrixSize)
+					firstMatrix[batch * firstMatrixSize + pairIndex] = value;
+				else
+					secondMatrix[batch * secondMatrixSize + pairIndex - firstMatrixSize] = value;
+			}
+		}
+	}
+
+	free(chunkBounds);
+	free(chunkOffsets);
+	unmapFile((void*)fileData, fileSize);
+	return errCode;
+}
+
+unsigned char parserBenchmark(const char* inputFilePath)
+{
+	FILE* inputFile = fopen(inputFilePath, "rb");
+	if (inputFile == NULL)
+	{
+		fprintf(stderr, "Input file open error!\n");
+		return 1;
+	}
+
+	struct sizes size;
+	if (isBinaryFile(inputFile) || matrixSizing(inputFile, &size))
+	{
+		fprintf(stderr, "Invalid matrix sizes!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	long dataOffset = ftell(inputFile);
+	double dataSize = (fileLength(inputFile) - dataOffset) / (1024.0 * 1024.0);
+
+	float* serialMatrices = (float*)malloc(sizeof(float) * ((size_t)size.firstMatrix + size.secondMatrix));
+	float* parallelMatrices = (float*)malloc(sizeof(float) * ((size_t)size.firstMatrix + size.secondMatrix));
+	if (serialMatrices == NULL || parallelMatrices == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(serialMatrices);
+		free(parallelMatrices);
+		fclose(inputFile);
+		return 1;
+	}
+
+	double startTime = wallTime();
+	unsigned char errCode = readFile(inputFile, serialMatrices, serialMatrices + size.firstMatrix, &size);
+	double serialTime = wallTime() - startTime;
+
+	fseek(inputFile, dataOffset, SEEK_SET);
+
+	startTime = wallTime();
+	errCode |= readFileParallel(inputFile, parallelMatrices, parallelMatrices + size.firstMatrix, &size);
+	double parallelTime = wallTime() - startTime;
+
+	fclose(inputFile);
+
+	if (errCode)
+	{
+		fprintf(stderr, "Invalid file format!\n");
+		free(serialMatrices);
+		free(parallelMatrices);
+		return 1;
+	}
+
+	unsigned char identical = !memcmp(serialMatrices, parallelMatrices, sizeof(float) * ((size_t)size.firstMatrix + size.secondMatrix));
+
+	printf("Threads: %d\n", threadNumber());
+	printf("fscanf: %g ms\t%g MB/s\n", serialTime * 1000.0, dataSize / serialTime);
+	printf("parallel: %g ms\t%g MB/s\n", parallelTime * 1000.0, dataSize / parallelTime);
+	printf("Bit-identical: %s\n", identical ? "yes" : "no");
+
+	free(serialMatrices);
+	free(parallelMatrices);
+	return !identical;
+}
+
+unsigned char binaryHeaderParsing(const unsigned char* headerData, unsigned long long fileSize, struct binaryHeader* header)
+{
+	if (fileSize < BINARY_HEADER_SIZE || memcmp(headerData, BINARY_MAGIC, sizeof(BINARY_MAGIC) - 1))
+		return 1;
+
+	if (loadLittleEndian(headerData + 4, 4) != BINARY_VERSION)
+		return 1;
+
+	header->kind = (unsigned int)loadLittleEndian(headerData + 8, 4);
+	header->flags = (unsigned int)loadLittleEndian(headerData + 12, 4);
+	header->colSecondMatrix = loadLittleEndian(headerData + 16, 8);
+	header->colFirstRowSecond = loadLittleEndian(headerData + 24, 8);
+	header->rowFirstMatrix = loadLittleEndian(headerData + 32, 8);
+	header->firstMatrixOffset = loadLittleEndian(headerData + 40, 8);
+	header->secondMatrixOffset = loadLittleEndian(headerData + 48, 8);
+	header->batchNum = loadLittleEndian(headerData + 56, 8);
+
+	// Files without a batch size hold a single pair
+	if (!header->batchNum)
+		header->batchNum = 1;
+
+	if (header->kind != BINARY_KIND_INPUT && header->kind != BINARY_KIND_RESULT)
+		return 1;
+
+	if (header->colSecondMatrix > 0xFFFFFFFFULL || header->colFirstRowSecond > 0xFFFFFFFFULL || header->rowFirstMatrix > 0xFFFFFFFFULL || header->batchNum > 0xFFFFFFFFULL)
+		return 1;
+
+	unsigned long long firstMatrixSize = header->rowFirstMatrix * header->colFirstRowSecond;
+	unsigned long long secondMatrixSize = header->colFirstRowSecond * header->colSecondMatrix;
+
+	if (header->kind == BINARY_KIND_RESULT)
+		firstMatrixSize = header->rowFirstMatrix * header->colSecondMatrix;
+
+	// Payload byte counts must not overflow
+	if (firstMatrixSize > (~0ULL >> 3) / header->batchNum || secondMatrixSize > (~0ULL >> 3) / header->batchNum)
+		return 1;
+
+	firstMatrixSize *= header->batchNum;
+	secondMatrixSize *= header->batchNum;
+
+	if (header->firstMatrixOffset < BINARY_HEADER_SIZE || header->firstMatrixOffset % sizeof(float))
+		return 1;
+
+	// Offsets are compared with what is left of the file rather than added to the payload sizes, which could wrap around
+	if (header->firstMatrixOffset > fileSize || firstMatrixSize * sizeof(float) > fileSize - header->firstMatrixOffset)
+		return 1;
+
+	if (header->kind == BINARY_KIND_INPUT)
+	{
+		if (header->secondMatrixOffset < header->firstMatrixOffset + firstMatrixSize * sizeof(float) || header->secondMatrixOffset % sizeof(float))
+			return 1;
+
+		if (header->secondMatrixOffset > fileSize || secondMatrixSize * sizeof(float) > fileSize - header->secondMatrixOffset)
+			return 1;
+	}
+
+	return 0;
+}
+
+unsigned char binaryMatrixSizing(FILE* inputFile, struct sizes* size, unsigned int* kind)
+{
+	unsigned char headerData[BINARY_HEADER_SIZE];
+	if (fread(headerData, 1, BINARY_HEADER_SIZE, inputFile) != BINARY_HEADER_SIZE)
+		return 1;
+
+	struct binaryHeader header;
+	if (binaryHeaderParsing(headerData, fileLength(inputFile), &header))
+		return 1;
+
+	*kind = header.kind;
+	size->secondTransposed = (header.flags & BINARY_FLAG_SECOND_TRANSPOSED) != 0;
+	size->colSecondMatrix = (unsigned int)header.colSecondMatrix;
+	size->colFirstRowSecond = (unsigned int)header.colFirstRowSecond;
+	size->rowFirstMatrix = (unsigned int)header.rowFirstMatrix;
+	size->batchNum = (unsigned int)header.batchNum;
+
+	size->firstMatrix = (unsigned long long)size->rowFirstMatrix * size->colFirstRowSecond * size->batchNum;
+	size->secondMatrix = (unsigned long long)size->colFirstRowSecond * size->colSecondMatrix * size->batchNum;
+	size->resultMatrix = (unsigned long long)size->rowFirstMatrix * size->colSecondMatrix * size->batchNum;
+
+	return 0;
+}
+
+void binaryPayloadCopy(float* matrix, const unsigned char* payload, size_t count)
+{
+	memcpy(matrix, payload, sizeof(float) * count);
+
+	if (!hostLittleEndian())
+		floatByteSwap(matrix, count);
+}
+
+unsigned char readBinaryFile(FILE* inputFile, float* firstMatrix, float* secondMatrix, struct sizes* size)
+{
+	size_t fileSize;
+	const unsigned char* fileData = (const unsigned char*)mapFile(inputFile, &fileSize);
+	if (fileData == NULL)
+		return 1;
+
+	struct binaryHeader header;
+	if (binaryHeaderParsing(fileData, fileSize, &header))
+	{
+		unmapFile((void*)fileData, fileSize);
+		return 1;
+	}
+
+	if (header.kind == BINARY_KIND_RESULT)
+	{
+		binaryPayloadCopy(firstMatrix, fileData + header.firstMatrixOffset, size->resultMatrix);
+		unmapFile((void*)fileData, fileSize);
+		return 0;
+	}
+
+	// The second matrix is kept as stored, size->secondTransposed tells which way
+	binaryPayloadCopy(firstMatrix, fileData + header.firstMatrixOffset, size->firstMatrix);
+	binaryPayloadCopy(secondMatrix, fileData + header.secondMatrixOffset, size->secondMatrix);
+
+	unmapFile((void*)fileData, fileSize);
+	return 0;
+}
+
+// Reads rowNum x colNum floats starting at byte offset, where consecutive rows are rowLength floats apart
+unsigned char binaryBlockReading(FILE* inputFile, unsigned long long offset, unsigned long long rowLength, size_t rowNum, size_t colNum, float* block)
+{
+	unsigned char errCode = 0;
+
+	for (size_t i = 0; i < rowNum && !errCode; i++)
+	{
+		float* row = block + i * colNum;
+
+		errCode = fileSeeking(inputFile, offset + sizeof(float) * rowLength * i) || fread(row, sizeof(float), colNum, inputFile) != colNum;
+
+		if (!hostLittleEndian())
+			floatByteSwap(row, colNum);
+	}
+
+	return errCode;
+}
+
+unsigned char binaryHeaderWriting(FILE* outputFile, const struct binaryHeader* header)
+{
+	unsigned char headerData[BINARY_HEADER_SIZE] = { 0 };
+
+	memcpy(headerData, BINARY_MAGIC, sizeof(BINARY_MAGIC) - 1);
+	storeLittleEndian(headerData + 4, BINARY_VERSION, 4);
+	storeLittleEndian(headerData + 8, header->kind, 4);
+	storeLittleEndian(headerData + 12, header->flags, 4);
+	storeLittleEndian(headerData + 16, header->colSecondMatrix, 8);
+	storeLittleEndian(headerData + 24, header->colFirstRowSecond, 8);
+	storeLittleEndian(headerData + 32, header->rowFirstMatrix, 8);
+	storeLittleEndian(headerData + 40, header->firstMatrixOffset, 8);
+	storeLittleEndian(headerData + 48, header->secondMatrixOffset, 8);
+	storeLittleEndian(headerData + 56, header->batchNum, 8);
+
+	return fwrite(headerData, 1, BINARY_HEADER_SIZE, outputFile) != BINARY_HEADER_SIZE;
+}
+
+unsigned char binaryPayloadWriting(FILE* outputFile, const float* matrix, size_t count)
+{
+	if (hostLittleEndian())
+		return fwrite(matrix, sizeof(float), count, outputFile) != count;
+
+	float* swapped = (float*)malloc(sizeof(float) * count);
+	if (swapped == NULL)
+		return 1;
+
+	memcpy(swapped, matrix, sizeof(float) * count);
+	floatByteSwap(swapped, count);
+
+	unsigned char errCode = fwrite(swapped, sizeof(float), count, outputFile) != count;
+	free(swapped);
+	return errCode;
+}
+
+unsigned char writeBinaryFile(FILE* outputFile, float* matrix, struct sizes* size)
+{
+	struct binaryHeader header = { BINARY_KIND_RESULT, BINARY_FLAG_ALIGNED, size->colSecondMatrix, 0, size->rowFirstMatrix, BINARY_HEADER_SIZE, 0, size->batchNum };
+
+	if (binaryHeaderWriting(outputFile, &header))
+		return 1;
+
+	return binaryPayloadWriting(outputFile, matrix, size->resultMatrix);
+}
+
+unsigned char writeBinaryInputFile(FILE* outputFile, float* firstMatrix, float* secondMatrix, struct sizes* size)
+{
+	struct binaryHeader header = { BINARY_KIND_INPUT, BINARY_FLAG_ALIGNED | (size->secondTransposed ? BINARY_FLAG_SECOND_TRANSPOSED : 0), size->colSecondMatrix, size->colFirstRowSecond, size->rowFirstMatrix, BINARY_HEADER_SIZE, 0, size->batchNum };
+	header.secondMatrixOffset = binaryAlignment(header.firstMatrixOffset + sizeof(float) * (unsigned long long)size->firstMatrix);
+
+	if (binaryHeaderWriting(outputFile, &header))
+		return 1;
+
+	if (binaryPayloadWriting(outputFile, firstMatrix, size->firstMatrix))
+		return 1;
+
+	const unsigned char padding[BINARY_ALIGNMENT] = { 0 };
+	size_t paddingSize = (size_t)(header.secondMatrixOffset - header.firstMatrixOffset - sizeof(float) * (unsigned long long)size->firstMatrix);
+
+	if (fwrite(padding, 1, paddingSize, outputFile) != paddingSize)
+		return 1;
+
+	return binaryPayloadWriting(outputFile, secondMatrix, size->secondMatrix);
+}
+
+// A batched text result is one "N M" block per product. The blocks are counted up to the end of the file, which is then rewound,
+// and a block of another shape or anything after the last one fails the whole file
+unsigned char resultMatrixSizing(FILE* inputFile, struct sizes* size)
+{
+	if (fscanf(inputFile, "%u ", &size->colSecondMatrix) < 1)
+		return 1;
+
+	if (fscanf(inputFile, "%u\n", &size->rowFirstMatrix) < 1)
+		return 1;
+
+	const unsigned long long blockSize = (unsigned long long)size->rowFirstMatrix * size->colSecondMatrix;
+	unsigned int batchNum = 1;
+
+	while (1)
+	{
+		float value;
+		for (unsigned long long i = 0; i < blockSize; i++)
+		{
+			if (fscanf(inputFile, "%f", &value) <= 0)
+				return 1;
+		}
+
+		unsigned int colNum, rowNum;
+		int dimNum = fscanf(inputFile, "%u %u", &colNum, &rowNum);
+		if (dimNum == EOF)
+			break;
+
+		if (dimNum < 2 || colNum != size->colSecondMatrix || rowNum != size->rowFirstMatrix || batchNum == 0xFFFFFFFFU)
+			return 1;
+
+		batchNum++;
+	}
+
+	rewind(inputFile);
+
+	size->colFirstRowSecond = 0;
+	size->batchNum = batchNum;
+	size->secondTransposed = 0;
+	size->firstMatrix = 0;
+	size->secondMatrix = 0;
+	size->resultMatrix = blockSize * batchNum;
+
+	return 0;
+}
+
+unsigned char readResultFile(FILE* inputFile, float* matrix, struct sizes* size)
+{
+	const unsigned long long blockSize = size->resultMatrix / size->batchNum;
+
+	for (unsigned int batch = 0; batch < size->batchNum; batch++, matrix += blockSize)
+	{
+		unsigned int colNum, rowNum;
+		if (fscanf(inputFile, "%u %u", &colNum, &rowNum) < 2)
+			return 1;
+
+		for (unsigned long long i = 0; i < blockSize; i++)
+		{
+			if (fscanf(inputFile, "%f", &matrix[i]) <= 0)
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+unsigned char textFileKind(FILE* inputFile, unsigned int* kind)
+{
+	char firstLine[128];
+	unsigned int dims[4];
+
+	if (fgets(firstLine, sizeof(firstLine), inputFile) == NULL)
+		return 1;
+
+	rewind(inputFile);
+
+	int dimNum = sscanf(firstLine, "%u %u %u %u", &dims[0], &dims[1], &dims[2], &dims[3]);
+	if (dimNum == 3 || dimNum == 4)
+		*kind = BINARY_KIND_INPUT;
+	else if (dimNum == 2)
+		*kind = BINARY_KIND_RESULT;
+	else
+		return 1;
+
+	return 0;
+}
+
+// Prints the value exactly like "%f": |value| * 10^6 is exact in double precision for every finite float (24 + 14 significant bits),
+// so rounding it half-to-even gives the same digits as the correctly rounded printf conversion. The 2^32 bound only keeps
+// the rounded fixed-point value within unsigned long long; larger values go to sprintf
+char* floatFormatting(char* curr, float value)
+{
+	if (!isfinite(value) || fabsf(value) >= 4294967296.0f)
+		return curr + sprintf(curr, "%f", value);
+
+	unsigned long long fixedValue = (unsigned long long)nearbyint(fabs((double)value) * 1000000.0);
+	unsigned long long intPart = fixedValue / 1000000;
+	unsigned int fracPart = (unsigned int)(fixedValue % 1000000);
+
+	if (signbit(value))
+		*curr++ = '-';
+
+	char intDigits[20];
+	int digitNum = 0;
+
+	do
+	{
+		intDigits[digitNum++] = (char)('0' + intPart % 10);
+		intPart /= 10;
+	} while (intPart);
+
+	while (digitNum)
+		*curr++ = intDigits[--digitNum];
+
+	*curr++ = '.';
+
+	for (int i = 5; i >= 0; i--, fracPart /= 10)
+		curr[i] = (char)('0' + fracPart % 10);
+
+	return curr + 6;
+}
+
+// Rows are formatted by all threads into per-thread buffers and flushed in order with one fwrite per buffer;
+// element (i, j) is read from matrix[i * rowStride + j * colStride]
+unsigned char textRowsWriting(FILE* outputFile, const float* matrix, size_t rowNum, size_t colNum, size_t rowStride, size_t colStride)
+{
+	const size_t maxElementSize = 48;
+	const size_t maxRowSize = colNum * maxElementSize + 1;
+
+	size_t rowsPerBlock = ((size_t)1 << 20) / maxRowSize;
+	if (!rowsPerBlock)
+		rowsPerBlock = 1;
+
+	int threadNum = threadNumber();
+
+	char* textBuffer = (char*)malloc(maxRowSize * rowsPerBlock * threadNum);
+	size_t* textSizes = (size_t*)malloc(sizeof(size_t) * threadNum);
+	if (textBuffer == NULL || textSizes == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(textBuffer);
+		free(textSizes);
+		return 1;
+	}
+
+	for (size_t blockStart = 0; blockStart < rowNum; blockStart += rowsPerBlock * threadNum)
+	{
+		#pragma omp parallel for schedule(static, 1)
+		for (int t = 0; t < threadNum; t++)
+		{
+			char* begin = textBuffer + maxRowSize * rowsPerBlock * t;
+			char* curr = begin;
+
+			size_t rowStart = blockStart + rowsPerBlock * t;
+			size_t rowEnd = rowStart + rowsPerBlock < rowNum ? rowStart + rowsPerBlock : rowNum;
+
+			for (size_t i = rowStart; i < rowEnd; i++)
+			{
+				const float* row = matrix + i * rowStride;
+
+				for (size_t j = 0; j < colNum; j++)
+				{
+					curr = floatFormatting(curr, row[j * colStride]);
+					*curr++ = ' ';
+				}
+
+				*curr++ = '\n';
+			}
+
+			textSizes[t] = curr - begin;
+		}
+
+		for (int t = 0; t < threadNum; t++)
+		{
+			if (fwrite(textBuffer + maxRowSize * rowsPerBlock * t, 1, textSizes[t], outputFile) != textSizes[t])
+			{
+				free(textBuffer);
+				free(textSizes);
+				return 1;
+			}
+		}
+	}
+
+	free(textBuffer);
+	free(textSizes);
+	return 0;
+}
+
+unsigned char writeFileParallel(FILE* outputFile, float* matrix, struct sizes* size)
+{
+	for (unsigned int batch = 0; batch < size->batchNum; batch++, matrix += size->resultMatrix / size->batchNum)
+	{
+		if (fprintf(outputFile, "%u %u\n", size->colSecondMatrix, size->rowFirstMatrix) < 0)
+			return 1;
+
+		if (textRowsWriting(outputFile, matrix, size->rowFirstMatrix, size->colSecondMatrix, size->colSecondMatrix, 1))
+			return 1;
+	}
+
+	return 0;
+}
+
+unsigned char formatterBenchmark(const char* resultFilePath)
+{
+	FILE* resultFile = fopen(resultFilePath, "rb");
+	if (resultFile == NULL)
+	{
+		fprintf(stderr, "Input file open error!\n");
+		return 1;
+	}
+
+	unsigned int kind;
+	struct sizes size;
+	if (isBinaryFile(resultFile) ? binaryMatrixSizing(resultFile, &size, &kind) : textFileKind(resultFile, &kind) || resultMatrixSizing(resultFile, &size))
+	{
+		fprintf(stderr, "Invalid matrix sizes!\n");
+		fclose(resultFile);
+		return 1;
+	}
+
+	if (kind != BINARY_KIND_RESULT)
+	{
+		fprintf(stderr, "Invalid file format!\n");
+		fclose(resultFile);
+		return 1;
+	}
+
+	float* resultMatrix = (float*)malloc(sizeof(float) * size.resultMatrix);
+	if (resultMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		fclose(resultFile);
+		return 1;
+	}
+
+	unsigned char binary = isBinaryFile(resultFile);
+	if (binary ? readBinaryFile(resultFile, resultMatrix, NULL, &size) : readResultFile(resultFile, resultMatrix, &size))
+	{
+		fprintf(stderr, "Invalid file format!\n");
+		free(resultMatrix);
+		fclose(resultFile);
+		return 1;
+	}
+
+	fclose(resultFile);
+
+	FILE* serialFile = tmpfile();
+	FILE* parallelFile = tmpfile();
+	if (serialFile == NULL || parallelFile == NULL)
+	{
+		fprintf(stderr, "Output file open error!\n");
+		free(resultMatrix);
+		if (serialFile != NULL)
+			fclose(serialFile);
+		if (parallelFile != NULL)
+			fclose(parallelFile);
+		return 1;
+	}
+
+	double startTime = wallTime();
+	unsigned char errCode = writeFile(serialFile, resultMatrix, &size) || fflush(serialFile);
+	double serialTime = wallTime() - startTime;
+
+	startTime = wallTime();
+	errCode |= writeFileParallel(parallelFile, resultMatrix, &size) || fflush(parallelFile);
+	double parallelTime = wallTime() - startTime;
+
+	free(resultMatrix);
+
+	unsigned long long textSize = fileLength(serialFile);
+	unsigned char identical = !errCode && textSize == fileLength(parallelFile);
+
+	rewind(serialFile);
+	rewind(parallelFile);
+
+	char serialBlock[1 << 14], parallelBlock[1 << 14];
+	size_t blockSize;
+
+	while (identical && (blockSize = fread(serialBlock, 1, sizeof(serialBlock), serialFile)) > 0)
+		identical = fread(parallelBlock, 1, blockSize, parallelFile) == blockSize && !memcmp(serialBlock, parallelBlock, blockSize);
+
+	fclose(serialFile);
+	fclose(parallelFile);
+
+	if (errCode)
+	{
+		fprintf(stderr, "File write error!\n");
+		return 1;
+	}
+
+	double dataSize = textSize / (1024.0 * 1024.0);
+
+	printf("Threads: %d\n", threadNumber());
+	printf("fprintf: %g ms\t%g MB/s\n", serialTime * 1000.0, dataSize / serialTime);
+	printf("parallel: %g ms\t%g MB/s\n", parallelTime * 1000.0, dataSize / parallelTime);
+	printf("Byte-identical: %s\n", identical ? "yes" : "no");
+
+	return !identical;
+}
+
+unsigned char writeTextInputFile(FILE* outputFile, float* firstMatrix, float* secondMatrix, struct sizes* size)
+{
+	int headerSize = size->batchNum > 1
+		? fprintf(outputFile, "%u %u %u %u\n", size->colSecondMatrix, size->colFirstRowSecond, size->rowFirstMatrix, size->batchNum)
+		: fprintf(outputFile, "%u %u %u\n", size->colSecondMatrix, size->colFirstRowSecond, size->rowFirstMatrix);
+
+	if (headerSize < 0)
+		return 1;
+
+	for (unsigned int batch = 0; batch < size->batchNum; batch++)
+	{
+		if (textRowsWriting(outputFile, firstMatrix + batch * (size->firstMatrix / size->batchNum), size->rowFirstMatrix, size->colFirstRowSecond, size->colFirstRowSecond, 1))
+			return 1;
+
+		const float* batchSecondMatrix = secondMatrix + batch * (size->secondMatrix / size->batchNum);
+
+		if (size->secondTransposed ? textRowsWriting(outputFile, batchSecondMatrix, size->colFirstRowSecond, size->colSecondMatrix, 1, size->colFirstRowSecond)
+			: textRowsWriting(outputFile, batchSecondMatrix, size->colFirstRowSecond, size->colSecondMatrix, size->colSecondMatrix, 1))
+			return 1;
+	}
+
+	return 0;
+}
+
+unsigned char fileConversion(const char* inputFilePath, const char* outputFilePath)
+{
+	FILE* inputFile = fopen(inputFilePath, "rb");
+	if (inputFile == NULL)
+	{
+		fprintf(stderr, "Input file open error!\n");
+		return 1;
+	}
+
+	unsigned char inputBinary = isBinaryFile(inputFile);
+	unsigned int kind;
+	struct sizes size;
+
+	if (inputBinary)
+	{
+		if (binaryMatrixSizing(inputFile, &size, &kind))
+		{
+			fprintf(stderr, "Invalid matrix sizes!\n");
+			fclose(inputFile);
+			return 1;
+		}
+	}
+	else
+	{
+		if (textFileKind(inputFile, &kind) || (kind == BINARY_KIND_INPUT ? matrixSizing(inputFile, &size) : resultMatrixSizing(inputFile, &size)))
+		{
+			fprintf(stderr, "Invalid matrix sizes!\n");
+			fclose(inputFile);
+			return 1;
+		}
+	}
+
+	size_t firstMatrixSize = kind == BINARY_KIND_INPUT ? size.firstMatrix : size.resultMatrix;
+
+	float* firstMatrix = (float*)malloc(sizeof(float) * firstMatrixSize);
+	float* secondMatrix = (float*)malloc(sizeof(float) * (size.secondMatrix ? size.secondMatrix : 1));
+	if (firstMatrix == NULL || secondMatrix == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(firstMatrix);
+		free(secondMatrix);
+		fclose(inputFile);
+		return 1;
+	}
+
+	unsigned char errCode;
+	if (inputBinary)
+		errCode = readBinaryFile(inputFile, firstMatrix, secondMatrix, &size);
+	else if (kind == BINARY_KIND_INPUT)
+		errCode = readFileParallel(inputFile, firstMatrix, secondMatrix, &size);
+	else
+		errCode = readResultFile(inputFile, firstMatrix, &size);
+
+	fclose(inputFile);
+
+	if (errCode)
+	{
+		fprintf(stderr, "Invalid file format!\n");
+		free(firstMatrix);
+		free(secondMatrix);
+		return 1;
+	}
+
+	FILE* outputFile = fopen(outputFilePath, "wb");
+	if (outputFile == NULL)
+	{
+		fprintf(stderr, "Output file open error!\n");
+		free(firstMatrix);
+		free(secondMatrix);
+		return 1;
+	}
+
+	if (kind == BINARY_KIND_INPUT)
+		errCode = inputBinary ? writeTextInputFile(outputFile, firstMatrix, secondMatrix, &size) : writeBinaryInputFile(outputFile, firstMatrix, secondMatrix, &size);
+	else
+		errCode = inputBinary ? writeFileParallel(outputFile, firstMatrix, &size) : writeBinaryFile(outputFile, firstMatrix, &size);
+
+	if (fclose(outputFile) != 0 || errCode)
+	{
+		fprintf(stderr, "File write error!\n");
+		free(firstMatrix);
+		free(secondMatrix);
+		return 1;
+	}
+
+	free(firstMatrix);
+	free(secondMatrix);
+	return 0;
+}
+
+unsigned long long hashCalculation(const void* data, size_t dataSize, unsigned long long hash)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	for (size_t i = 0; i < dataSize; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
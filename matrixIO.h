@@ -0,0 +1,104 @@
+#ifndef MATRIX_IO_H
+#define MATRIX_IO_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Binary container: 64-byte little-endian header followed by raw little-endian float32 payloads
+#define BINARY_MAGIC "CLMM"
+#define BINARY_VERSION 1U
+#define BINARY_HEADER_SIZE 64U
+#define BINARY_ALIGNMENT 64U
+
+#define BINARY_KIND_INPUT 0U
+#define BINARY_KIND_RESULT 1U
+
+#define BINARY_FLAG_ALIGNED 1U
+#define BINARY_FLAG_SECOND_TRANSPOSED 2U
+
+// Text files of a sparse first matrix start with this word
+#define SPARSE_MAGIC "csr"
+
+// Element types of the typed text files, which have the same layout as the float ones
+#define VALUE_TYPE_DOUBLE 0U
+#define VALUE_TYPE_CHAR 1U
+#define VALUE_TYPE_INT 2U
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+// A batch file holds batchNum pairs of matrices of the same shape; the element counts cover all of them.
+// The second matrices are K x N as in the text files, or N x K when secondTransposed is set by a binary file
+struct sizes
+{
+	unsigned int rowFirstMatrix;
+	unsigned int colSecondMatrix;
+	unsigned int colFirstRowSecond;
+	unsigned int batchNum;
+	unsigned char secondTransposed;
+	unsigned long long firstMatrix;
+	unsigned long long secondMatrix;
+	unsigned long long resultMatrix;
+};
+
+struct binaryHeader
+{
+	unsigned int kind;
+	unsigned int flags;
+	unsigned long long colSecondMatrix;
+	unsigned long long colFirstRowSecond;
+	unsigned long long rowFirstMatrix;
+	unsigned long long firstMatrixOffset;
+	unsigned long long secondMatrixOffset;
+	unsigned long long batchNum;
+};
+
+unsigned char matrixSizing(FILE* inputFile, struct sizes* size);
+unsigned char readFile(FILE* inputFile, float* firstMatrix, float* secondMatrix, struct sizes* size);
+unsigned char writeFile(FILE* outputFile, float* matrix, struct sizes* size);
+unsigned char typedValueReading(FILE* inputFile, unsigned int valueType, void* matrix, size_t index);
+unsigned char readTypedFile(FILE* inputFile, unsigned int valueType, void* firstMatrix, void* secondMatrix, struct sizes* size);
+unsigned char writeTypedFile(FILE* outputFile, unsigned int valueType, const void* matrix, struct sizes* size);
+unsigned char hostLittleEndian(void);
+void floatByteSwap(float* data, size_t count);
+unsigned long long loadLittleEndian(const unsigned char* bytes, unsigned int byteNum);
+void storeLittleEndian(unsigned char* bytes, unsigned long long value, unsigned int byteNum);
+unsigned long long binaryAlignment(unsigned long long offset);
+unsigned long long fileLength(FILE* file);
+unsigned char fileSeeking(FILE* file, unsigned long long offset);
+void* mapFile(FILE* file, size_t* fileSize);
+void unmapFile(void* fileData, size_t fileSize);
+unsigned char isBinaryFile(FILE* file);
+unsigned char isSparseFile(FILE* file);
+unsigned char sparseMatrixSizing(FILE* inputFile, struct sizes* size, unsigned int* nonZeroNum);
+unsigned char readSparseFile(FILE* inputFile, unsigned int* rowPointers, unsigned int* colIndices, float* values, float* secondMatrix,
+	const struct sizes* size, unsigned int nonZeroNum);
+double wallTime(void);
+int threadNumber(void);
+unsigned char isSpaceChar(char symbol);
+const char* slowFloatParsing(const char* tokenStart, const char* tokenEnd, float* value);
+const char* floatParsing(const char* curr, const char* end, float* value);
+size_t tokenCounting(const char* curr, const char* end);
+unsigned char readFileParallel(FILE* inputFile, float* firstMatrix, float* secondMatrix, struct sizes* size);
+unsigned char parserBenchmark(const char* inputFilePath);
+unsigned char binaryHeaderParsing(const unsigned char* headerData, unsigned long long fileSize, struct binaryHeader* header);
+unsigned char binaryMatrixSizing(FILE* inputFile, struct sizes* size, unsigned int* kind);
+void binaryPayloadCopy(float* matrix, const unsigned char* payload, size_t count);
+unsigned char readBinaryFile(FILE* inputFile, float* firstMatrix, float* secondMatrix, struct sizes* size);
+unsigned char binaryBlockReading(FILE* inputFile, unsigned long long offset, unsigned long long rowLength, size_t rowNum, size_t colNum, float* block);
+unsigned char binaryHeaderWriting(FILE* outputFile, const struct binaryHeader* header);
+unsigned char binaryPayloadWriting(FILE* outputFile, const float* matrix, size_t count);
+unsigned char writeBinaryFile(FILE* outputFile, float* matrix, struct sizes* size);
+unsigned char writeBinaryInputFile(FILE* outputFile, float* firstMatrix, float* secondMatrix, struct sizes* size);
+unsigned char resultMatrixSizing(FILE* inputFile, struct sizes* size);
+unsigned char readResultFile(FILE* inputFile, float* matrix, struct sizes* size);
+unsigned char textFileKind(FILE* inputFile, unsigned int* kind);
+char* floatFormatting(char* curr, float value);
+unsigned char textRowsWriting(FILE* outputFile, const float* matrix, size_t rowNum, size_t colNum, size_t rowStride, size_t colStride);
+unsigned char writeFileParallel(FILE* outputFile, float* matrix, struct sizes* size);
+unsigned char formatterBenchmark(const char* resultFilePath);
+unsigned char writeTextInputFile(FILE* outputFile, float* firstMatrix, float* secondMatrix, struct sizes* size);
+unsigned char fileConversion(const char* inputFilePath, const char* outputFilePath);
+unsigned long long hashCalculation(const void* data, size_t dataSize, unsigned long long hash);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "multiDevice.h"
+#include "matrixIO.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Splits a CPU into subDeviceNum sub-devices of about the same number of compute units; the whole device is kept when that fails
+unsigned char subDevicesCreation(cl_device_id device, unsigned int subDeviceNum, cl_device_id* subDevices, cl_uint* createdNum)
+{
+	cl_uint computeUnitNum = 0;
+	if (clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnitNum, NULL) != CL_SUCCESS || computeUnitNum < 2)
+		return 1;
+
+	if (subDeviceNum > computeUnitNum)
+		subDeviceNum = computeUnitNum;
+
+	cl_device_partition_property* properties = (cl_device_partition_property*)malloc(sizeof(cl_device_partition_property) * (subDeviceNum + 2));
+	if (properties == NULL)
+		return 1;
+
+	properties[0] = CL_DEVICE_PARTITION_BY_COUNTS;
+	for (unsigned int i = 0; i < subDeviceNum; i++)
+		properties[i + 1] = computeUnitNum / subDeviceNum + (i < computeUnitNum % subDeviceNum);
+
+	properties[subDeviceNum + 1] = CL_DEVICE_PARTITION_BY_COUNTS_LIST_END;
+
+	cl_int errCode = clCreateSubDevices(device, properties, subDeviceNum, subDevices, createdNum);
+	free(properties);
+
+	return errCode != CL_SUCCESS || !*createdNum;
+}
+
+// One worker per OpenCL device in the order of the device IDs; CPUs are split into subDeviceNum sub-devices when it is above 1
+unsigned char deviceWorkersCreation(struct deviceWorker** workers, size_t* workerNum, unsigned int subDeviceNum)
+{
+	cl_uint platformNum = 0;
+	cl_uint deviceNum = getDeviceNumber(&platformNum);
+
+	struct deviceInfo* devices = (struct deviceInfo*)malloc(sizeof(struct deviceInfo) * (deviceNum ? deviceNum : 1));
+	if (devices == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	if (!deviceNum || getDeviceInfo(devices, deviceNum, platformNum))
+	{
+		fprintf(stderr, "Number of devices: 0\n");
+		free(devices);
+		return 1;
+	}
+
+	deviceSorting(devices, deviceNum);
+
+	if (subDeviceNum < 1)
+		subDeviceNum = 1;
+
+	*workers = (struct deviceWorker*)calloc((size_t)deviceNum * subDeviceNum, sizeof(struct deviceWorker));
+	cl_device_id* subDevices = (cl_device_id*)malloc(sizeof(cl_device_id) * subDeviceNum);
+	if (*workers == NULL || subDevices == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		free(*workers);
+		free(subDevices);
+		free(devices);
+		return 1;
+	}
+
+	*workerNum = 0;
+
+	for (cl_uint i = 0; i < deviceNum; i++)
+	{
+		// The sort ID, not the enumeration order, picks the device, so its type is that of the entry with the same ID
+		cl_device_id device = NULL;
+		cl_device_type deviceType = 0;
+		for (cl_uint j = 0; j < deviceNum; j++)
+		{
+			if (devices[j].sortID == i)
+			{
+				device = devices[j].ID;
+				deviceType = devices[j].type;
+			}
+		}
+
+		cl_uint createdNum = 0;
+		if (!(deviceType & CL_DEVICE_TYPE_CPU) || subDeviceNum == 1 || subDevicesCreation(device, subDeviceNum, subDevices, &createdNum))
+		{
+			subDevices[0] = device;
+			createdNum = 0;
+		}
+
+		for (cl_uint j = 0; j < (createdNum ? createdNum : 1); j++)
+		{
+			struct deviceWorker* worker = &(*workers)[*workerNum];
+			worker->subDevice = createdNum ? subDevices[j] : NULL;
+
+			if (matmulDeviceCreate(&worker->ctx, subDevices[j]))
+			{
+				worker->ctx = NULL;
+
+				for (cl_uint k = j + 1; k < createdNum; k++)
+					clReleaseDevice(subDevices[k]);
+
+				deviceWorkersRelease(*workers, *workerNum + 1);
+				free(subDevices);
+				free(devices);
+				return 1;
+			}
+
+			(*workerNum)++;
+		}
+	}
+
+	free(subDevices);
+	free(devices);
+	return 0;
+}
+
+void deviceWorkersRelease(struct deviceWorker* workers, size_t workerNum)
+{
+	for (size_t i = 0; i < workerNum; i++)
+	{
+		if (workers[i].ctx != NULL)
+			matmulRelease(workers[i].ctx);
+
+		if (workers[i].subDevice != NULL)
+			clReleaseDevice(workers[i].subDevice);
+	}
+
+	free(workers);
+}
+
+// The panels left in the pool are split into consecutive runs in proportion to the measured throughputs
+void panelDealing(struct panelSchedule* schedule, struct deviceWorker* workers, size_t workerNum)
+{
+	double throughputSum = 0.0;
+	for (size_t i = 0; i < workerNum; i++)
+		throughputSum += workers[i].throughput;
+
+	const unsigned int remainingNum = schedule->panelNum - schedule->poolHead;
+	unsigned int panelHead = schedule->poolHead;
+	double share = 0.0;
+
+	for (size_t i = 0; i < workerNum; i++)
+	{
+		share += workers[i].throughput / throughputSum;
+
+		unsigned int panelTail = i == workerNum - 1 ? schedule->panelNum : schedule->poolHead + (unsigned int)(share * remainingNum + 0.5);
+		if (panelTail < panelHead)
+			panelTail = panelHead;
+
+		workers[i].panelHead = panelHead;
+		workers[i].panelTail = panelTail;
+		panelHead = panelTail;
+	}
+
+	schedule->poolHead = schedule->panelNum;
+	schedule->dealt = 1;
+}
+
+// Next panel for a worker: from the pool before the panels are dealt, afterwards from its own run or stolen from the tail
+// of the worker that would take longest to finish, as long as that takes longer than this worker needs for the panel
+unsigned char panelTaking(struct panelSchedule* schedule, struct deviceWorker* workers, size_t workerNum, size_t workerID, unsigned int* panel)
+{
+	struct deviceWorker* worker = &workers[workerID];
+
+	if (schedule->failed)
+		return 1;
+
+	if (!schedule->dealt)
+	{
+		unsigned char measured = 1;
+		for (size_t i = 0; i < workerNum; i++)
+			measured = measured && workers[i].throughput > 0.0;
+
+		if (!measured || schedule->poolHead == schedule->panelNum)
+		{
+			if (schedule->poolHead == schedule->panelNum)
+				return 1;
+
+			*panel = schedule->poolHead++;
+			return 0;
+		}
+
+		panelDealing(schedule, workers, workerNum);
+	}
+
+	if (worker->panelHead < worker->panelTail)
+	{
+		*panel = worker->panelHead++;
+		return 0;
+	}
+
+	size_t victimID = workerNum;
+	double victimTime = (double)schedule->panelRowNum / worker->throughput;
+
+	for (size_t i = 0; i < workerNum; i++)
+	{
+		const unsigned int remainingNum = workers[i].panelTail - workers[i].panelHead;
+		const double remainingTime = (double)remainingNum * schedule->panelRowNum / workers[i].throughput;
+
+		if (remainingNum && remainingTime > victimTime)
+		{
+			victimID = i;
+			victimTime = remainingTime;
+		}
+	}
+
+	if (victimID == workerNum)
+		return 1;
+
+	*panel = --workers[victimID].panelTail;
+	worker->stolenNum++;
+	return 0;
+}
+
+// Rows per millisecond, averaged over the panels so a slow first panel (kernel build, buffer allocation) is soon forgotten
+void throughputUpdating(struct deviceWorker* worker, unsigned int rowNum, double panelTime)
+{
+	const double throughput = rowNum / (panelTime > 1e-3 ? panelTime : 1e-3);
+
+	if (worker->throughput > 0.0)
+		worker->throughput = MULTI_THROUGHPUT_WEIGHT * throughput + (1.0 - MULTI_THROUGHPUT_WEIGHT) * worker->throughput;
+	else
+		worker->throughput = throughput;
+}
+
+// Runs row panels of the result on all workers at once, one host thread per device;
+// the timing holds the kernel and transfer times summed over the devices
+unsigned char multiDeviceProcessing(struct deviceWorker* workers, size_t workerNum, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	const struct matmulOptions* options, struct matmulTiming* timing)
+{
+	// A panel is a view of rows of the whole matrices, so it is multiplied with their leading dimensions;
+	// a row panel of a transposed first matrix is a band of its columns
+	const int layout = options != NULL ? options->layout : 0;
+
+	struct matmulLeadingDims leadingDims;
+	if (leadingDimsResolving(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, layout, options != NULL ? options->leadingDims : NULL, &leadingDims))
+	{
+		fprintf(stderr, "Incorrect leading dimension!\n");
+		return 1;
+	}
+
+	struct matmulOptions panelOptions = { 2, ELEMENT_TYPE_FLOAT, 0, 0, NULL, NULL, 0, 0 };
+	if (options != NULL)
+		panelOptions = *options;
+
+	panelOptions.leadingDims = &leadingDims;
+
+	struct panelSchedule schedule;
+	schedule.panelRowNum = (rowFirstMatrix + workerNum * MULTI_PANEL_PER_DEVICE - 1) / (workerNum * MULTI_PANEL_PER_DEVICE);
+	schedule.panelRowNum = (schedule.panelRowNum + MULTI_PANEL_ALIGNMENT - 1) / MULTI_PANEL_ALIGNMENT * MULTI_PANEL_ALIGNMENT;
+	schedule.panelNum = (rowFirstMatrix + schedule.panelRowNum - 1) / schedule.panelRowNum;
+	schedule.poolHead = 0;
+	schedule.dealt = 0;
+	schedule.failed = 0;
+
+	for (size_t i = 0; i < workerNum; i++)
+	{
+		workers[i].panelHead = 0;
+		workers[i].panelTail = 0;
+		workers[i].throughput = 0.0;
+		workers[i].rowNum = 0;
+		workers[i].panelNum = 0;
+		workers[i].stolenNum = 0;
+		workers[i].kernelTime = 0.0;
+		workers[i].transferTime = 0.0;
+	}
+
+#pragma omp parallel num_threads((int)workerNum)
+	{
+#ifdef _OPENMP
+		const size_t workerID = (size_t)omp_get_thread_num();
+#else
+		const size_t workerID = 0;
+#endif
+		struct deviceWorker* worker = &workers[workerID];
+
+		while (1)
+		{
+			unsigned int panel;
+			unsigned char finished;
+
+#pragma omp critical(panelScheduling)
+			finished = panelTaking(&schedule, workers, workerNum, workerID, &panel);
+
+			if (finished)
+				break;
+
+			const unsigned int rowStart = panel * schedule.panelRowNum;
+			const unsigned int rowNum = rowStart + schedule.panelRowNum < rowFirstMatrix ? schedule.panelRowNum : rowFirstMatrix - rowStart;
+
+			struct matmulTiming panelTiming;
+			const double startTime = wallTime();
+
+			const size_t firstOffset = layout & LAYOUT_FIRST_TRANSPOSED ? rowStart : (size_t)rowStart * leadingDims.first;
+
+			unsigned char errCode = matmul(worker->ctx, firstMatrix + firstOffset, secondMatrix, resultMatrix + (size_t)rowStart * leadingDims.result,
+				rowNum, colSecondMatrix, colFirstRowSecond, &panelOptions, &panelTiming);
+
+			const double panelTime = (wallTime() - startTime) * 1000.0;
+
+#pragma omp critical(panelScheduling)
+			{
+				if (errCode)
+				{
+					fprintf(stderr, "Panel failed on %s!\n", matmulDeviceName(worker->ctx));
+					schedule.failed = 1;
+				}
+				else
+				{
+					throughputUpdating(worker, rowNum, panelTime);
+					worker->rowNum += rowNum;
+					worker->panelNum++;
+					worker->kernelTime += panelTiming.kernelTime;
+					worker->transferTime += panelTiming.transferTime;
+				}
+			}
+		}
+	}
+
+	if (schedule.failed)
+		return 1;
+
+	memset(timing, 0, sizeof(struct matmulTiming));
+	for (size_t i = 0; i < workerNum; i++)
+	{
+		timing->kernelTime += workers[i].kernelTime;
+		timing->transferTime += workers[i].transferTime;
+	}
+
+	return 0;
+}
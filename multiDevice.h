@@ -0,0 +1,49 @@
+#ifndef MULTI_DEVICE_H
+#define MULTI_DEVICE_H
+
+#include "matmul.h"
+
+// The result is cut into about this many row panels per device, so there is enough left to balance once devices are measured
+#define MULTI_PANEL_PER_DEVICE 8
+
+// Panels are a multiple of this many rows, the largest work-group tile
+#define MULTI_PANEL_ALIGNMENT 64
+
+// Weight of the last panel in the moving average of a device's throughput
+#define MULTI_THROUGHPUT_WEIGHT 0.5
+
+// A device of the split with the panels dealt to it: its own work is taken from the head, others steal from the tail
+struct deviceWorker
+{
+	struct matmulContext* ctx;
+	cl_device_id subDevice;
+	unsigned int panelHead;
+	unsigned int panelTail;
+	double throughput;
+	unsigned int rowNum;
+	unsigned int panelNum;
+	unsigned int stolenNum;
+	double kernelTime;
+	double transferTime;
+};
+
+// Panels are handed out from a shared pool until every device has a measured throughput, the rest are then dealt in proportion
+struct panelSchedule
+{
+	unsigned int panelRowNum;
+	unsigned int panelNum;
+	unsigned int poolHead;
+	unsigned char dealt;
+	unsigned char failed;
+};
+
+unsigned char deviceWorkersCreation(struct deviceWorker** workers, size_t* workerNum, unsigned int subDeviceNum);
+void deviceWorkersRelease(struct deviceWorker* workers, size_t workerNum);
+void panelDealing(struct panelSchedule* schedule, struct deviceWorker* workers, size_t workerNum);
+unsigned char panelTaking(struct panelSchedule* schedule, struct deviceWorker* workers, size_t workerNum, size_t workerID, unsigned int* panel);
+void throughputUpdating(struct deviceWorker* worker, unsigned int rowNum, double panelTime);
+unsigned char multiDeviceProcessing(struct deviceWorker* workers, size_t workerNum, const float* firstMatrix, const float* secondMatrix, float* resultMatrix,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond,
+	const struct matmulOptions* options, struct matmulTiming* timing);
+
+#endif
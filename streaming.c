@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "streaming.h"
+#include "matrixIO.h"
+
+// Halves the longest side until every block fits its device buffer, the device and host budgets and the kernel index range
+unsigned char streamBlockSizing(unsigned long long rowFirstMatrix, unsigned long long colSecondMatrix, unsigned long long colFirstRowSecond,
+	unsigned long long maxBufferSize, unsigned long long deviceMemSize, unsigned long long hostMemSize, struct streamBlocks* blocks)
+{
+	blocks->rowNum = rowFirstMatrix;
+	blocks->colNum = colSecondMatrix;
+	blocks->colRowNum = colFirstRowSecond;
+
+	while (1)
+	{
+		const unsigned long long rowNum = blocks->rowNum;
+		const unsigned long long colNum = blocks->colNum;
+		const unsigned long long colRowNum = blocks->colRowNum;
+
+		unsigned char fits = rowNum * colRowNum < STREAM_BLOCK_ELEMENT_MAX && colNum * colRowNum < STREAM_BLOCK_ELEMENT_MAX
+			&& rowNum * colNum < STREAM_BLOCK_ELEMENT_MAX;
+
+		if (fits)
+		{
+			const unsigned long long alignedRowNum = (rowNum + STREAM_ALIGNMENT - 1) / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+			const unsigned long long alignedColNum = (colNum + STREAM_ALIGNMENT - 1) / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+			const unsigned long long alignedColRowNum = (colRowNum + STREAM_ALIGNMENT - 1) / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+
+			const unsigned long long firstBufferSize = sizeof(float) * alignedRowNum * alignedColRowNum;
+			const unsigned long long secondBufferSize = sizeof(float) * alignedColNum * alignedColRowNum;
+			const unsigned long long resultBufferSize = sizeof(float) * alignedRowNum * alignedColNum;
+
+			// A partial result needs its own accumulator when the depth is split
+			unsigned long long hostBlockSize = sizeof(float) * (rowNum * colRowNum + colNum * colRowNum + rowNum * colNum);
+			if (colRowNum < colFirstRowSecond)
+				hostBlockSize += sizeof(float) * rowNum * colNum;
+
+			fits = firstBufferSize <= maxBufferSize && secondBufferSize <= maxBufferSize && resultBufferSize <= maxBufferSize
+				&& firstBufferSize + secondBufferSize + resultBufferSize <= deviceMemSize / 2 && hostBlockSize <= hostMemSize;
+		}
+
+		if (fits)
+			return 0;
+
+		if (rowNum == 1 && colNum == 1 && colRowNum == 1)
+			return 1;
+
+		if (rowNum >= colNum && rowNum >= colRowNum)
+			blocks->rowNum = (rowNum + 1) / 2;
+		else if (colNum >= colRowNum)
+			blocks->colNum = (colNum + 1) / 2;
+		else
+			blocks->colRowNum = (colRowNum + 1) / 2;
+	}
+}
+
+// Places a rowNum x colNum tile of the result at its position in a binary result file
+unsigned char resultTileWriting(FILE* outputFile, const float* tile, unsigned long long colSecondMatrix,
+	unsigned long long rowStart, unsigned long long colStart, size_t rowNum, size_t colNum)
+{
+	for (size_t i = 0; i < rowNum; i++)
+	{
+		if (fileSeeking(outputFile, BINARY_HEADER_SIZE + sizeof(float) * ((rowStart + i) * colSecondMatrix + colStart))
+			|| binaryPayloadWriting(outputFile, tile + i * colNum, colNum))
+			return 1;
+	}
+
+	return 0;
+}
+
+// Multiplies a binary input file block by block: row panels of the first matrix and column panels of the second are read
+// from disk, split along the depth when needed, and every finished result tile goes straight to the output file
+unsigned char streamProcessing(struct matmulContext* ctx, const char* inputFilePath, const char* outputFilePath,
+	const struct matmulOptions* options, unsigned long long hostMemSize, struct matmulTiming* timing)
+{
+	FILE* inputFile = fopen(inputFilePath, "rb");
+	if (inputFile == NULL)
+	{
+		fprintf(stderr, "Input file open error!\n");
+		return 1;
+	}
+
+	unsigned char headerData[BINARY_HEADER_SIZE];
+	struct binaryHeader header;
+
+	if (fread(headerData, 1, BINARY_HEADER_SIZE, inputFile) != BINARY_HEADER_SIZE || binaryHeaderParsing(headerData, fileLength(inputFile), &header)
+		|| header.kind != BINARY_KIND_INPUT)
+	{
+		fprintf(stderr, "Streaming needs a binary input file, use convert first!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	if (header.batchNum > 1)
+	{
+		fprintf(stderr, "Batches cannot be streamed!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	const unsigned long long rowFirstMatrix = header.rowFirstMatrix;
+	const unsigned long long colSecondMatrix = header.colSecondMatrix;
+	const unsigned long long colFirstRowSecond = header.colFirstRowSecond;
+
+	if (!rowFirstMatrix || !colSecondMatrix || !colFirstRowSecond)
+	{
+		fprintf(stderr, "Invalid matrix sizes!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	unsigned long long maxBufferSize, deviceMemSize;
+	if (matmulMemoryLimits(ctx, &maxBufferSize, &deviceMemSize))
+	{
+		fclose(inputFile);
+		return 1;
+	}
+
+	struct streamBlocks blocks;
+	if (streamBlockSizing(rowFirstMatrix, colSecondMatrix, colFirstRowSecond, maxBufferSize, deviceMemSize, hostMemSize, &blocks))
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		fclose(inputFile);
+		return 1;
+	}
+
+	const unsigned char depthSplit = blocks.colRowNum < colFirstRowSecond;
+
+	struct matmulOptions blockOptions = *options;
+	blockOptions.layout = header.flags & BINARY_FLAG_SECOND_TRANSPOSED ? LAYOUT_SECOND_TRANSPOSED : 0;
+	blockOptions.leadingDims = NULL;
+
+	float* firstBlock = matmulHostAllocation(blocks.rowNum * blocks.colRowNum);
+	float* secondBlock = matmulHostAllocation(blocks.colNum * blocks.colRowNum);
+	float* resultBlock = matmulHostAllocation(blocks.rowNum * blocks.colNum);
+	float* accumulator = depthSplit ? matmulHostAllocation(blocks.rowNum * blocks.colNum) : resultBlock;
+
+	FILE* outputFile = NULL;
+	unsigned char errCode = 0;
+
+	if (firstBlock == NULL || secondBlock == NULL || resultBlock == NULL || accumulator == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		errCode = 1;
+	}
+	else if ((outputFile = fopen(outputFilePath, "wb")) == NULL)
+	{
+		fprintf(stderr, "Output file open error!\n");
+		errCode = 1;
+	}
+	else
+	{
+		struct binaryHeader resultHeader = { BINARY_KIND_RESULT, BINARY_FLAG_ALIGNED, colSecondMatrix, 0, rowFirstMatrix, BINARY_HEADER_SIZE, 0, 1 };
+
+		if (binaryHeaderWriting(outputFile, &resultHeader))
+		{
+			fprintf(stderr, "File write error!\n");
+			errCode = 1;
+		}
+	}
+
+	timing->kernelTime = 0;
+	timing->transferTime = 0;
+
+	for (unsigned long long rowStart = 0; rowStart < rowFirstMatrix && !errCode; rowStart += blocks.rowNum)
+	{
+		const size_t rowNum = (size_t)(rowFirstMatrix - rowStart < blocks.rowNum ? rowFirstMatrix - rowStart : blocks.rowNum);
+
+		for (unsigned long long colStart = 0; colStart < colSecondMatrix && !errCode; colStart += blocks.colNum)
+		{
+			const size_t colNum = (size_t)(colSecondMatrix - colStart < blocks.colNum ? colSecondMatrix - colStart : blocks.colNum);
+
+			for (unsigned long long colRowStart = 0; colRowStart < colFirstRowSecond && !errCode; colRowStart += blocks.colRowNum)
+			{
+				const size_t colRowNum = (size_t)(colFirstRowSecond - colRowStart < blocks.colRowNum ? colFirstRowSecond - colRowStart : blocks.colRowNum);
+
+				// Without a depth split the row panel stays the same for the whole row of tiles
+				if (depthSplit || !colStart)
+				{
+					errCode = binaryBlockReading(inputFile, header.firstMatrixOffset + sizeof(float) * (rowStart * colFirstRowSecond + colRowStart),
+						colFirstRowSecond, rowNum, colRowNum, firstBlock);
+				}
+
+				// The block of the second matrix keeps the layout of the file, which the kernels are told about
+				if (!errCode && blockOptions.layout & LAYOUT_SECOND_TRANSPOSED)
+				{
+					errCode = binaryBlockReading(inputFile, header.secondMatrixOffset + sizeof(float) * (colStart * colFirstRowSecond + colRowStart),
+						colFirstRowSecond, colNum, colRowNum, secondBlock);
+				}
+				else if (!errCode)
+				{
+					errCode = binaryBlockReading(inputFile, header.secondMatrixOffset + sizeof(float) * (colRowStart * colSecondMatrix + colStart),
+						colSecondMatrix, colRowNum, colNum, secondBlock);
+				}
+
+				if (errCode)
+				{
+					fprintf(stderr, "File read error!\n");
+					break;
+				}
+
+				struct matmulTiming blockTiming;
+				if (matmul(ctx, firstBlock, secondBlock, colRowStart ? resultBlock : accumulator, (unsigned int)rowNum, (unsigned int)colNum, (unsigned int)colRowNum,
+					&blockOptions, &blockTiming))
+				{
+					errCode = 1;
+					break;
+				}
+
+				timing->kernelTime += blockTiming.kernelTime;
+				timing->transferTime += blockTiming.transferTime;
+				timing->params = blockTiming.params;
+
+				if (colRowStart)
+				{
+					const long long tileSize = (long long)(rowNum * colNum);
+
+					#pragma omp parallel for
+					for (long long i = 0; i < tileSize; i++)
+						accumulator[i] += resultBlock[i];
+				}
+			}
+
+			if (!errCode && resultTileWriting(outputFile, accumulator, colSecondMatrix, rowStart, colStart, rowNum, colNum))
+			{
+				fprintf(stderr, "File write error!\n");
+				errCode = 1;
+			}
+		}
+	}
+
+	if (outputFile != NULL)
+		fclose(outputFile);
+
+	if (depthSplit)
+		matmulHostRelease(accumulator);
+
+	matmulHostRelease(firstBlock);
+	matmulHostRelease(secondBlock);
+	matmulHostRelease(resultBlock);
+	fclose(inputFile);
+	return errCode;
+}
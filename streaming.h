@@ -0,0 +1,30 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include "matmul.h"
+
+// Host memory used for blocks when the stream mode is given no limit, in megabytes
+#define STREAM_HOST_MEMORY_DEFAULT 1024ULL
+
+// Device buffers are sized for blocks rounded up to this many rows and columns, the largest work-group tile
+#define STREAM_ALIGNMENT 512ULL
+
+// Block sides are kept below this many elements so kernel indices stay within unsigned int
+#define STREAM_BLOCK_ELEMENT_MAX 0x80000000ULL
+
+// Row panel, column panel and depth of the blocks the matrices are streamed in
+struct streamBlocks
+{
+	unsigned long long rowNum;
+	unsigned long long colNum;
+	unsigned long long colRowNum;
+};
+
+unsigned char streamBlockSizing(unsigned long long rowFirstMatrix, unsigned long long colSecondMatrix, unsigned long long colFirstRowSecond,
+	unsigned long long maxBufferSize, unsigned long long deviceMemSize, unsigned long long hostMemSize, struct streamBlocks* blocks);
+unsigned char resultTileWriting(FILE* outputFile, const float* tile, unsigned long long colSecondMatrix,
+	unsigned long long rowStart, unsigned long long colStart, size_t rowNum, size_t colNum);
+unsigned char streamProcessing(struct matmulContext* ctx, const char* inputFilePath, const char* outputFilePath,
+	const struct matmulOptions* options, unsigned long long hostMemSize, struct matmulTiming* timing);
+
+#endif
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tuning.h"
+
+unsigned int shapeClass(unsigned int dim)
+{
+	unsigned int dimClass = 0;
+	while (dim > 1)
+	{
+		dim >>= 1;
+		dimClass++;
+	}
+
+	return dimClass;
+}
+
+const char* tuningDatabasePath(void)
+{
+	const char* databasePath = getenv(TUNING_DB_ENV);
+	if (databasePath == NULL)
+		return TUNING_DB_FILE;
+
+	return *databasePath ? databasePath : NULL;
+}
+
+// Line format: device name, driver version, implementation type, three shape classes, LSIZE, vecWidth, TM, TN and the kernel time, tab separated
+unsigned char tuningEntryParsing(char* line, char** deviceKey, struct tuningEntry* entry)
+{
+	char* driverEnd = NULL;
+	char* nameEnd = strchr(line, '\t');
+	if (nameEnd != NULL)
+		driverEnd = strchr(nameEnd + 1, '\t');
+
+	if (driverEnd == NULL)
+		return 1;
+
+	*driverEnd = '\0';
+	*deviceKey = line;
+
+	if (sscanf(driverEnd + 1, "%d\t%u\t%u\t%u\t%zu\t%zu\t%zu\t%zu\t%lf", &entry->implementationType, &entry->rowClass, &entry->colClass, &entry->colRowClass,
+		&entry->params.localGroupSize, &entry->params.vectorWidth, &entry->params.tileRows, &entry->params.tileCols, &entry->kernelTime) != 9)
+		return 1;
+
+	return 0;
+}
+
+unsigned char tuningDatabaseLoading(const char* deviceKey, struct tuningEntry** entries, size_t* entryNum)
+{
+	*entries = NULL;
+	*entryNum = 0;
+
+	const char* databasePath = tuningDatabasePath();
+	if (databasePath == NULL)
+		return 0;
+
+	FILE* databaseFile = fopen(databasePath, "r");
+	if (databaseFile == NULL)
+		return 0;
+
+	size_t entryCapacity = 0;
+	char line[1024];
+
+	while (fgets(line, sizeof(line), databaseFile) != NULL)
+	{
+		char* lineDeviceKey;
+		struct tuningEntry entry;
+
+		if (line[0] == '#' || tuningEntryParsing(line, &lineDeviceKey, &entry) || strcmp(lineDeviceKey, deviceKey))
+			continue;
+
+		if (*entryNum == entryCapacity)
+		{
+			entryCapacity = entryCapacity ? entryCapacity * 2 : 16;
+			struct tuningEntry* newEntries = (struct tuningEntry*)realloc(*entries, sizeof(struct tuningEntry) * entryCapacity);
+			if (newEntries == NULL)
+			{
+				fprintf(stderr, "Insufficient memory available!\n");
+				free(*entries);
+				*entries = NULL;
+				*entryNum = 0;
+				fclose(databaseFile);
+				return 1;
+			}
+
+			*entries = newEntries;
+		}
+
+		(*entries)[(*entryNum)++] = entry;
+	}
+
+	fclose(databaseFile);
+	return 0;
+}
+
+// Rewrites the database with the entry replacing any earlier one for the same device, implementation type and shape class
+unsigned char tuningDatabaseSaving(const char* deviceKey, const struct tuningEntry* entry)
+{
+	const char* databasePath = tuningDatabasePath();
+	if (databasePath == NULL)
+		return 0;
+
+	size_t tempPathSize = strlen(databasePath) + 5;
+	char* tempPath = (char*)malloc(sizeof(char) * tempPathSize);
+	if (tempPath == NULL)
+	{
+		fprintf(stderr, "Insufficient memory available!\n");
+		return 1;
+	}
+
+	snprintf(tempPath, tempPathSize, "%s.tmp", databasePath);
+
+	FILE* tempFile = fopen(tempPath, "w");
+	if (tempFile == NULL)
+	{
+		fprintf(stderr, "Output file open error!\n");
+		free(tempPath);
+		return 1;
+	}
+
+	FILE* databaseFile = fopen(databasePath, "r");
+	char line[1024];
+	char lineCopy[1024];
+
+	if (databaseFile != NULL)
+	{
+		while (fgets(line, sizeof(line), databaseFile) != NULL)
+		{
+			char* lineDeviceKey;
+			struct tuningEntry lineEntry;
+
+			strcpy(lineCopy, line);
+
+			if (line[0] != '#' && !tuningEntryParsing(line, &lineDeviceKey, &lineEntry) && !strcmp(lineDeviceKey, deviceKey)
+				&& lineEntry.implementationType == entry->implementationType && lineEntry.rowClass == entry->rowClass
+				&& lineEntry.colClass == entry->colClass && lineEntry.colRowClass == entry->colRowClass)
+				continue;
+
+			fputs(lineCopy, tempFile);
+		}
+
+		fclose(databaseFile);
+	}
+	else
+	{
+		fprintf(tempFile, "# device\tdriver\ttype\tlog2 M\tlog2 N\tlog2 K\tLSIZE\tvecWidth\tTM\tTN\tkernel time (ms)\n");
+	}
+
+	fprintf(tempFile, "%s\t%d\t%u\t%u\t%u\t%zu\t%zu\t%zu\t%zu\t%g\n", deviceKey, entry->implementationType, entry->rowClass, entry->colClass, entry->colRowClass,
+		entry->params.localGroupSize, entry->params.vectorWidth, entry->params.tileRows, entry->params.tileCols, entry->kernelTime);
+
+	if (fclose(tempFile) != 0)
+	{
+		fprintf(stderr, "File write error!\n");
+		remove(tempPath);
+		free(tempPath);
+		return 1;
+	}
+
+	remove(databasePath);
+	if (rename(tempPath, databasePath) != 0)
+	{
+		fprintf(stderr, "File write error!\n");
+		remove(tempPath);
+		free(tempPath);
+		return 1;
+	}
+
+	free(tempPath);
+	return 0;
+}
+
+// The entry of the nearest shape class tuned for the implementation type, NULL if there is none
+const struct tuningEntry* tuningEntrySearch(const struct tuningEntry* entries, size_t entryNum, int implementationType,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond)
+{
+	const unsigned int rowClass = shapeClass(rowFirstMatrix);
+	const unsigned int colClass = shapeClass(colSecondMatrix);
+	const unsigned int colRowClass = shapeClass(colFirstRowSecond);
+
+	const struct tuningEntry* nearestEntry = NULL;
+	unsigned int nearestDistance = 0;
+
+	for (size_t i = 0; i < entryNum; i++)
+	{
+		if (entries[i].implementationType != implementationType)
+			continue;
+
+		unsigned int distance = abs((int)entries[i].rowClass - (int)rowClass) + abs((int)entries[i].colClass - (int)colClass)
+			+ abs((int)entries[i].colRowClass - (int)colRowClass);
+
+		if (nearestEntry == NULL || distance < nearestDistance)
+		{
+			nearestEntry = &entries[i];
+			nearestDistance = distance;
+		}
+	}
+
+	return nearestEntry;
+}
+
+unsigned char kernelParamsValidation(cl_device_id device, int implementationType, const struct kernelParams* params, size_t localElementSize)
+{
+	size_t maxWorkGroupSize;
+	cl_ulong localMemSize;
+
+	cl_int errCodeReturn = clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxWorkGroupSize, NULL);
+	errCodeReturn |= clGetDeviceInfo(device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &localMemSize, NULL);
+	if (errCodeReturn != CL_SUCCESS)
+	{
+		errCodeOutput(errCodeReturn, "clGetDeviceInfo");
+		return 1;
+	}
+
+	const size_t localSize = params->localGroupSize;
+	if (!localSize || !params->vectorWidth || !params->tileRows || !params->tileCols || localSize % params->vectorWidth)
+		return 1;
+
+	size_t workGroupSize = localSize * localSize / params->vectorWidth;
+	size_t localMemUsage = 0;
+
+	// Local memory per work-group as declared in the kernels, in elements of the accumulator type
+	switch (implementationType)
+	{
+	case 1:
+		return localSize != 1 || params->vectorWidth != 1 || params->tileRows != 1 || params->tileCols != 1;
+	case 2:
+	case 3:
+		localMemUsage = localElementSize * 2 * localSize * (localSize + 1);
+		break;
+	case 4:
+		localMemUsage = localElementSize * 2 * localSize * (localSize * (params->tileRows + params->tileCols) + 2);
+		break;
+	default:
+		return 1;
+	}
+
+	if (implementationType != 4 && (params->tileRows != 1 || params->tileCols != 1))
+		return 1;
+
+	if (implementationType != 3 && params->vectorWidth != 1)
+		return 1;
+
+	return workGroupSize > maxWorkGroupSize || localMemUsage > localMemSize;
+}
+
+size_t kernelParamsCandidates(cl_device_id device, int implementationType, struct kernelParams* candidates, size_t candidateMax)
+{
+	// Vector widths kernelVector.cl can be built with
+	static const size_t vectorWidths[] = { 1, 2, 4, 8, 16 };
+	static const size_t tileSizes[] = { 1, 2, 4, 8 };
+
+	size_t candidateNum = 0;
+
+	for (size_t localSize = 2; localSize <= 64; localSize *= 2)
+	{
+		for (size_t i = 0; i < sizeof(vectorWidths) / sizeof(vectorWidths[0]); i++)
+		{
+			for (size_t j = 0; j < sizeof(tileSizes) / sizeof(tileSizes[0]); j++)
+			{
+				for (size_t k = 0; k < sizeof(tileSizes) / sizeof(tileSizes[0]); k++)
+				{
+					struct kernelParams params;
+					params.localGroupSize = localSize;
+					params.vectorWidth = implementationType == 3 ? vectorWidths[i] : 1;
+					params.tileRows = implementationType == 4 ? tileSizes[j] : 1;
+					params.tileCols = implementationType == 4 ? tileSizes[k] : 1;
+
+					unsigned char duplicate = 0;
+					for (size_t c = 0; c < candidateNum; c++)
+						duplicate |= !memcmp(&candidates[c], &params, sizeof(struct kernelParams));
+
+					if (!duplicate && candidateNum < candidateMax && !kernelParamsValidation(device, implementationType, &params, sizeof(cl_float)))
+						candidates[candidateNum++] = params;
+				}
+			}
+		}
+	}
+
+	return candidateNum;
+}
@@ -0,0 +1,34 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include "matmul.h"
+
+// Tuned kernel parameters are kept in this file unless MATMUL_TUNING_DB overrides it (empty disables)
+#define TUNING_DB_FILE "kernelTuning.txt"
+#define TUNING_DB_ENV "MATMUL_TUNING_DB"
+
+#define TUNING_REPEAT_NUM 3
+#define TUNING_CANDIDATE_MAX 256
+
+// Shapes are grouped by the binary logarithm of each dimension
+struct tuningEntry
+{
+	int implementationType;
+	unsigned int rowClass;
+	unsigned int colClass;
+	unsigned int colRowClass;
+	struct kernelParams params;
+	double kernelTime;
+};
+
+unsigned int shapeClass(unsigned int dim);
+const char* tuningDatabasePath(void);
+unsigned char tuningEntryParsing(char* line, char** deviceKey, struct tuningEntry* entry);
+unsigned char tuningDatabaseLoading(const char* deviceKey, struct tuningEntry** entries, size_t* entryNum);
+unsigned char tuningDatabaseSaving(const char* deviceKey, const struct tuningEntry* entry);
+const struct tuningEntry* tuningEntrySearch(const struct tuningEntry* entries, size_t entryNum, int implementationType,
+	unsigned int rowFirstMatrix, unsigned int colSecondMatrix, unsigned int colFirstRowSecond);
+unsigned char kernelParamsValidation(cl_device_id device, int implementationType, const struct kernelParams* params, size_t localElementSize);
+size_t kernelParamsCandidates(cl_device_id device, int implementationType, struct kernelParams* candidates, size_t candidateMax);
+
+#endif